@@ -2,8 +2,23 @@
 #include "AppTemplate.h"
 #include "algorithm_result.pb.h"
 #include "sensor_data.pb.h"
-#include <vector>
-#include <mutex>
+#include "SensorCodec.h"
+#include "Topics.h"
+#include "SensorWorkerPool.h"
+#include "Pipeline.h"
+#include "ResultDeadband.h"
+#include "ResultBuilder.h"
+#include "StateCheckpoint.h"
+#include "ComfortKernel.h"
+#include <array>
+#include <atomic>
+#include <memory>
+
+// 订阅端使用 SensorSample，同时接受 protobuf 和二进制记录
+using SensorDataTopic = Topic<topics::SENSOR_DATA, sensor::SensorSample>;
+using SensorBatchTopic = Topic<topics::SENSOR_BATCH, SensorBatch>;
+using AlgorithmResultTopic = Topic<topics::ALGORITHM_RESULT, AlgorithmResult>;
+using AlgorithmAnomalyTopic = Topic<topics::ALGORITHM_ANOMALY, AnomalyEvent>;
 
 class Algorithm : public AppTemplate {
 public:
@@ -16,13 +31,59 @@ protected:
     void cleanup() override;
 
 private:
-    void handleSensorData(const std::string& eventType, const std::string& data);
-    AlgorithmResult processData();
+    // 处理器只把样本转交给该传感器所在的工作线程
+    void handleSensorData(const sensor::SensorSample& sensorData);
+    // 批量样本逐个进入窗口，每批处理一次；未启用流式统计时超过窗口容量的部分只取最后一段
+    void handleSensorBatch(const SensorBatch& batch);
+    void loadWindowConfig();
+    void loadStatsConfig();
+    void loadAnomalyConfig();
+    void loadEventTimeConfig();
+    void loadPipelineConfig();
+    void loadPublishConfig();
+    void loadCheckpointConfig();
+    // emit 算子的输出：按死区策略发布本批已评分的窗口记录
+    void emitResults(const RecordBatch& batch);
+    // 在工作线程上调用：发布并清空该传感器本批检测到的异常
+    void publishAnomalies(const std::string& sensorId, SensorWorkerPool::SensorState& state);
     double calculateComfortIndex(double temp, double humidity, double pressure);
-    std::string determineAlertLevel(double comfortIndex);
-    std::string generateRecommendation(double comfortIndex, const std::string& alertLevel);
+    AlertLevel determineAlertLevel(double comfortIndex);
+    static const char* alertLevelName(AlertLevel level);
+    static const char* generateRecommendation(AlertLevel level);
 
-    std::vector<SensorData> sensorDataBuffer_;
-    std::mutex bufferMutex_;
-    static constexpr size_t BUFFER_SIZE = 5;
+    // "algorithm": { "window_size": 5, "workers": 4 }，窗口按传感器独立维护
+    size_t windowSize_;
+    size_t workerCount_;
+    size_t maxPending_;
+    size_t maxSensors_;
+    // "algorithm": { "stats": { "enabled": true, "ewma_alpha": 0.1, "sketch_k": 128, "quantile_interval_ms": 1000 } }
+    StreamingStats::Options statsOptions_;
+    std::chrono::milliseconds quantileInterval_;
+    // "algorithm": { "anomaly": { "enabled": true, "z_threshold": 4, "cusum_k": 0.5, "cusum_h": 8,
+    //   "ewma_lambda": 0.2, "ewma_l": 3.5, "warmup": 10, "min_stddev": 0.01 } }
+    AnomalyDetector::Options anomalyOptions_;
+    std::atomic<uint64_t> anomalyCount_;
+    // "algorithm": { "event_time": { "size_ms": 10000, "slide_ms": 5000, "max_delay_ms": 1000, "allowed_lateness_ms": 5000 } }
+    // 配置后按样本时间戳划分窗口，结果在窗口关闭时输出
+    bool eventTimeEnabled_;
+    EventTimeWindow::Options eventTimeOptions_;
+    // "algorithm": { "pipeline": [ { "op": "window" }, { "op": "score" }, { "op": "emit" } ] }，见 Pipeline.h
+    std::unique_ptr<Pipeline> pipeline_;
+    // "algorithm": { "publish": { "enabled": true, "epsilon": 1.0, "min_interval_ms": 100, "max_interval_ms": 10000 } }
+    ResultDeadband deadband_;
+    std::array<std::atomic<uint64_t>, 6> publishCounts_;  // 按 ResultDeadband::Decision 计数
+    std::unique_ptr<SensorWorkerPool> workers_;
+    // "algorithm": { "checkpoint": { "enabled": true, "path": "algorithm.ckpt", "interval_ms": 10000 } }
+    // 启动时恢复每个传感器的窗口状态，见 StateCheckpoint.h
+    StateCheckpoint::Options checkpointOptions_;
+    std::unique_ptr<StateCheckpoint> checkpoint_;
+    ResultBuilder results_;
+    static constexpr size_t DEFAULT_WINDOW_SIZE = 5;
+    static constexpr size_t MAX_WINDOW_SIZE = 1 << 22;
+    static constexpr size_t MIN_SAMPLES = 3;
+    static constexpr std::chrono::seconds REPORT_INTERVAL{1};
+    // emitResults 中按线程保存的键状态：每分钟清理一次，超过 10 分钟没有结果的键被移除
+    static constexpr std::chrono::seconds KEY_PRUNE_INTERVAL{60};
+    static constexpr std::chrono::minutes KEY_IDLE_TIMEOUT{10};
+    static constexpr std::chrono::milliseconds DEFAULT_QUANTILE_INTERVAL{1000};
 };
\ No newline at end of file
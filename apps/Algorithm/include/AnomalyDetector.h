@@ -0,0 +1,71 @@
+// AnomalyDetector.h
+#pragma once
+#include "SlidingWindow.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class StateReader;
+class StateWriter;
+
+// 每个传感器、每个指标的增量异常检测，基线为样本进入前的滑动窗口（均值/标准差）：
+//   - 滚动 z 分数：|x - 均值| / 标准差 超过阈值
+//   - CUSUM：对标准化残差做双侧累积和，检测持续的小幅偏移；报警后归零重新累积
+//   - EWMA 控制图：残差的指数加权平均超出控制限 L * sqrt(λ / (2 - λ))
+// z 分数和 EWMA 在越界时报一次，回到限内后才会再次报警，持续异常不会每个样本都产生事件
+class AnomalyDetector {
+public:
+    // 数值与 algorithm_result.proto 中的 AnomalyKind 一致
+    enum Kind : uint8_t {
+        ZSCORE = 0,
+        CUSUM_HIGH = 1,
+        CUSUM_LOW = 2,
+        EWMA = 3
+    };
+
+    struct Options {
+        bool enabled = true;
+        double zThreshold = 4.0;
+        double cusumK = 0.5;      // 允许的偏移（以标准差计）
+        double cusumH = 8.0;      // 决策阈值
+        double ewmaLambda = 0.2;
+        double ewmaL = 3.5;
+        size_t warmup = 10;       // 窗口中至少有这么多样本才开始检测（不超过窗口容量）
+        double minStddev = 0.01;  // 标准差下限，避免恒定信号上的微小噪声被放大
+    };
+
+    struct Event {
+        int64_t timestamp;
+        SlidingWindow::Channel channel;
+        Kind kind;
+        double value;
+        double mean;    // 基线均值
+        double stddev;  // 基线标准差
+        double score;   // z 分数、CUSUM 累积值或 EWMA 值
+    };
+
+    // options 由调用方持有，生命周期需长于检测器
+    explicit AnomalyDetector(const Options& options);
+
+    // 必须在样本进入窗口之前调用；检测到的异常追加到 events
+    void update(const SlidingWindow& window, const SlidingWindow::Sample& sample, std::vector<Event>& events);
+
+    static const char* kindName(Kind kind);
+
+    // 保存 CUSUM / EWMA 累积量和越界状态；阈值来自配置，不保存
+    void save(StateWriter& writer) const;
+    bool load(StateReader& reader);
+
+private:
+    struct ChannelState {
+        double cusumHigh = 0;
+        double cusumLow = 0;
+        double ewma = 0;
+        bool zActive = false;
+        bool ewmaActive = false;
+    };
+
+    const Options* options_;
+    double ewmaLimit_;
+    std::array<ChannelState, SlidingWindow::CHANNEL_COUNT> channels_;
+};
@@ -0,0 +1,43 @@
+// ComfortKernel.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 舒适度指数批量计算内核：输入为列式（SoA）温度/湿度/气压数组，输出指数和警报等级
+//   - AVX2（4 路）、SSE2（2 路）和标量三种实现，首次调用时按 CPU 能力选择
+//   - 各实现的运算顺序完全相同且不使用 FMA，结果与标量版本逐位一致
+//   - 环境变量 COMFORT_KERNEL_ISA=scalar|sse2|avx2 可强制选择（不支持时忽略）
+class ComfortKernel {
+public:
+    enum class Isa {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    // 警报等级编码，数值越大越严重
+    enum Alert : uint8_t {
+        ALERT_GOOD = 0,
+        ALERT_MODERATE = 1,
+        ALERT_POOR = 2,
+        ALERT_CRITICAL = 3
+    };
+
+    // 输入输出数组不要求对齐；alert 可以为 nullptr
+    static void score(const double* temperature, const double* humidity, const double* pressure,
+                      size_t count, double* index, uint8_t* alert);
+    static void scoreWith(Isa isa, const double* temperature, const double* humidity, const double* pressure,
+                          size_t count, double* index, uint8_t* alert);
+
+    // 标量参考实现
+    static double scoreOne(double temperature, double humidity, double pressure);
+    static Alert alertOf(double index);
+    static const char* alertName(Alert alert);
+
+    static Isa activeIsa();
+    static bool isSupported(Isa isa);
+    static const char* isaName(Isa isa);
+
+    // 用边界值和随机输入逐位比较当前实现与标量实现；不一致时切换到标量实现并返回 false
+    static bool selfTest();
+};
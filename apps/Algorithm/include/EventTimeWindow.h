@@ -0,0 +1,92 @@
+// EventTimeWindow.h
+#pragma once
+#include "SlidingWindow.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class StateReader;
+class StateWriter;
+
+// 按事件时间（样本时间戳）划分的滚动/滑动窗口，单个传感器使用：
+//   - 窗口 [k * slide - size + slide, (k + 1) * slide)，slide == size 时为滚动窗口；size 必须是 slide 的整数倍
+//   - 样本按 slide 长度分桶（pane），每个样本只更新一个桶（O(1)），窗口关闭时合并 size / slide 个桶
+//   - 水位线 = 已见最大时间戳 - max_delay，水位线越过窗口结束时间时窗口关闭并输出
+//   - 迟到样本：所属窗口关闭后 allowed_lateness 内到达的仍被接受，受影响的窗口重新输出（late = true）；
+//     更晚的样本丢弃并计数
+//   - 不再可能被迟到样本更新的桶立即淘汰，状态大小只与 (size + max_delay + allowed_lateness) / slide 有关
+// 结果只取决于样本时间戳和到达顺序，批量发送、断线重连或回放时可重复
+class EventTimeWindow {
+public:
+    struct Options {
+        int64_t sizeMs = 10000;
+        int64_t slideMs = 10000;
+        int64_t maxDelayMs = 1000;
+        int64_t allowedLatenessMs = 0;
+
+        // 修正非法取值：size 至少为 slide，且向上取整到 slide 的整数倍
+        void normalize();
+    };
+
+    struct Aggregate {
+        uint64_t count = 0;
+        std::array<double, SlidingWindow::CHANNEL_COUNT> sum{};
+        std::array<double, SlidingWindow::CHANNEL_COUNT> min{};
+        std::array<double, SlidingWindow::CHANNEL_COUNT> max{};
+
+        void add(const SlidingWindow::Sample& sample);
+        void merge(const Aggregate& other);
+        double mean(SlidingWindow::Channel channel) const { return sum[channel] / static_cast<double>(count); }
+    };
+
+    struct Result {
+        int64_t start;  // 毫秒，包含
+        int64_t end;    // 毫秒，不包含
+        bool late;      // 窗口关闭后因迟到样本重新输出
+        Aggregate aggregate;
+    };
+
+    enum class Accept {
+        ON_TIME,
+        LATE,
+        DROPPED
+    };
+
+    // options 由调用方持有且已 normalize，生命周期需长于窗口
+    explicit EventTimeWindow(const Options& options);
+
+    // 关闭或因迟到样本更新的窗口追加到 results
+    Accept push(const SlidingWindow::Sample& sample, std::vector<Result>& results);
+
+    int64_t watermark() const { return watermark_; }
+    uint64_t droppedCount() const { return dropped_; }
+    uint64_t lateCount() const { return late_; }
+    size_t paneCount() const { return paneCount_; }
+
+    // 保存水位线和未淘汰的桶；窗口参数与保存时不同时恢复失败
+    void save(StateWriter& writer) const;
+    bool load(StateReader& reader);
+
+private:
+    static int64_t floorDiv(int64_t value, int64_t divisor);
+
+    void advanceWatermark(int64_t watermark, std::vector<Result>& results);
+    // 输出以 lastPane 结尾的窗口；窗口内没有样本时不输出
+    void emitWindow(int64_t lastPane, bool late, std::vector<Result>& results) const;
+    Aggregate* pane(int64_t index);
+    const Aggregate* pane(int64_t index) const;
+
+    const Options* options_;
+    int64_t panesPerWindow_;
+    int64_t watermark_;
+    int64_t maxTimestamp_;
+    int64_t firstPane_;   // 环形缓冲区中最旧的桶序号
+    int64_t nextWindow_;  // 下一个待关闭窗口的最后一个桶序号
+    bool started_;
+    // 桶的环形缓冲区，容量为 2 的幂且只增不减，窗口滚动时不分配内存
+    std::vector<Aggregate> panes_;
+    size_t paneHead_;   // firstPane_ 所在的下标
+    size_t paneCount_;
+    uint64_t dropped_;
+    uint64_t late_;
+};
@@ -0,0 +1,194 @@
+// Pipeline.h
+#pragma once
+#include "SensorWorkerPool.h"
+#include "SpscQueue.h"
+#include <rapidjson/document.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 流式统计快照：记录跨线程传递时不能再引用工作线程上的 SensorState
+struct MetricSnapshot {
+    double ewma = 0;
+    double stddev = 0;
+    StreamingStats::Quantiles quantiles{};
+    uint64_t count = 0;
+};
+
+// 流水线中流动的窗口记录，按值传递
+struct WindowRecord {
+    // 传感器 ID 或聚合分组名，下游可以按地址缓存每个键的状态。指向的字符串在流水线运行期间不变：
+    // 传感器 ID 是 SensorWorkerPool 中 unordered_map 的键（节点不搬移、传感器不删除），分组名是 std::map 的键
+    const std::string* key;
+    std::array<double, SlidingWindow::CHANNEL_COUNT> mean;
+    std::array<double, SlidingWindow::CHANNEL_COUNT> min;
+    std::array<double, SlidingWindow::CHANNEL_COUNT> max;
+    uint64_t count;    // 窗口内样本数
+    uint64_t samples;  // 该传感器累计样本数
+    int64_t start;     // 事件时间窗口为 [start, end)；计数窗口为最旧和最新样本的时间戳
+    int64_t end;
+    bool late;
+    int64_t watermark;  // 仅事件时间窗口：生成记录时的水位线和累计丢弃的迟到样本数
+    uint64_t dropped;
+    bool hasStats;
+    std::array<MetricSnapshot, SlidingWindow::CHANNEL_COUNT> stats;
+    bool scored;
+    double comfortIndex;
+    uint8_t alert;  // ComfortKernel::Alert
+};
+
+using RecordBatch = std::vector<WindowRecord>;
+
+// 算子接口：window 之前的算子处理单个样本，之后的算子就地处理一批窗口记录
+// 每个执行线程持有自己的算子实例，实现不需要线程安全
+class PipelineOperator {
+public:
+    enum class Placement {
+        Any,     // 无状态，可与前一个算子融合在同一线程
+        Global   // 需要看到所有传感器的记录，只能运行在单线程阶段
+    };
+
+    virtual ~PipelineOperator() = default;
+
+    virtual Placement placement() const { return Placement::Any; }
+    // 返回 false 时丢弃样本
+    virtual bool processSample(SlidingWindow::Sample& sample) { return true; }
+    // 可以删除、修改或追加记录
+    virtual void processBatch(RecordBatch& batch) {}
+    // Global 算子在 flushDeadline() 到期时被调用，输出到期的结果（例如聚合周期结束）；
+    // 停止时以 time_point::max() 再调用一次
+    virtual void flush(RecordBatch& out, std::chrono::steady_clock::time_point now) {}
+    // 下一次需要 flush 的时间，阶段线程空闲时最多睡到这个时间；max() 表示只在停止时 flush
+    virtual std::chrono::steady_clock::time_point flushDeadline() const {
+        return std::chrono::steady_clock::time_point::max();
+    }
+};
+
+// 数据流引擎：算子按配置串联，window 把每个传感器的样本流转换为窗口记录
+//   "algorithm": { "pipeline": [
+//       { "op": "filter", "metric": "temperature", "min": -40, "max": 85 },
+//       { "op": "map", "metric": "temperature", "scale": 1.0, "offset": -0.5 },
+//       { "op": "window" },
+//       { "op": "score" },
+//       { "op": "aggregate", "separator": "_", "interval_ms": 1000 },
+//       { "op": "emit" } ] }
+// 执行方式：
+//   - window 及之前的算子运行在传感器所属的工作线程上（按 sensor_id 分片）
+//   - 之后的算子融合到同一阶段，在同一批记录上依次执行，中间不经过队列；
+//     遇到 Global 算子或 "thread": true 时切分出新阶段，由独立线程执行，阶段之间用 SPSC 队列连接，
+//     处理完的批次经回收队列还给上游复用，稳态下不分配内存
+//   - 未配置时为 window → score → emit，全部在工作线程上执行
+class Pipeline {
+public:
+    struct Context {
+        // emit 算子的输出，每批调用一次；可能在多个线程上同时调用
+        std::function<void(const RecordBatch& batch)> emit;
+        std::chrono::milliseconds quantileInterval{1000};
+        size_t minWindowSamples = 3;  // 计数窗口样本数不足时不输出记录
+        bool stats = false;           // 窗口记录是否带 EWMA / 分位数统计量
+    };
+
+    struct OperatorConfig {
+        const rapidjson::Value* params;  // 配置中的算子对象，可能为 nullptr；只在工厂调用期间有效
+        bool beforeWindow;
+        bool scored;  // 前面是否已有 score
+        const Context* context;
+    };
+
+    // 参数不合法时返回 nullptr 并设置 error
+    using Factory = std::function<std::unique_ptr<PipelineOperator>(const OperatorConfig& config, std::string& error)>;
+
+    // 注册自定义算子；需在 configure 之前调用
+    static void registerOperator(const std::string& name, Factory factory);
+
+    explicit Pipeline(Context context);
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    // 解析并校验配置（nullptr 时使用缺省流水线），失败时返回 false 并保持缺省流水线
+    // operators 需在流水线生命周期内保持有效（start 时据此创建算子实例）
+    bool configure(const rapidjson::Value* operators, std::string& error);
+    // 为每个工作线程创建算子实例并启动下游阶段线程
+    void start(size_t workers);
+    // 工作线程停止后调用，下游阶段处理完队列中剩余的记录后退出
+    void stop();
+
+    bool hasSampleOperators() const { return windowIndex_ > 0; }
+    // 在工作线程上调用
+    bool processSample(size_t worker, SlidingWindow::Sample& sample);
+    void processRound(size_t worker, const std::vector<SensorWorkerPool::Touched>& touched);
+
+    std::string describe() const;
+
+private:
+    struct Spec {
+        std::string name;
+        const rapidjson::Value* params;
+        bool beforeWindow;
+        bool scored;
+        size_t stage;  // 0 为工作线程阶段
+    };
+
+    // 相邻阶段之间的连接：正向传递批次，回收队列把处理完的批次还给生产者
+    struct Edge {
+        Edge() : forward(QUEUE_CAPACITY), recycle(QUEUE_CAPACITY) {}
+        SpscQueue<RecordBatch> forward;
+        SpscQueue<RecordBatch> recycle;
+    };
+
+    // 消费者空闲时休眠，生产者只在对方休眠时才加锁通知
+    struct Waker {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::atomic<bool> sleeping{false};
+
+        void notify();
+    };
+
+    struct Worker {
+        std::vector<std::unique_ptr<PipelineOperator>> sampleOps;
+        std::vector<std::unique_ptr<PipelineOperator>> ops;
+        RecordBatch batch;
+        Edge* out = nullptr;
+    };
+
+    struct StageThread {
+        std::vector<std::unique_ptr<PipelineOperator>> ops;
+        std::vector<Edge*> inputs;
+        Edge* out = nullptr;
+        Waker waker;
+        RecordBatch pending;  // flush 的输出
+        std::atomic<bool> upstreamDone{false};  // 上游全部退出，清空输入后即可结束
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<PipelineOperator>> instantiate(size_t stage, bool beforeWindow);
+    void collectWindows(const std::vector<SensorWorkerPool::Touched>& touched, RecordBatch& batch);
+    // 把 batch 交给下一阶段并换回一个空批次；队列满时等待（对上游形成背压）
+    void send(Edge& edge, StageThread& consumer, RecordBatch& batch);
+    void stageLoop(size_t index);
+    void runOps(std::vector<std::unique_ptr<PipelineOperator>>& ops, RecordBatch& batch);
+
+    static std::map<std::string, Factory>& registry();
+
+    Context context_;
+    std::vector<Spec> specs_;
+    size_t windowIndex_;
+    size_t stageCount_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::unique_ptr<StageThread>> stages_;  // stages_[i] 执行第 i + 1 阶段
+    std::vector<std::unique_ptr<Edge>> edges_;
+    std::atomic<bool> running_;
+
+    static constexpr size_t QUEUE_CAPACITY = 64;
+};
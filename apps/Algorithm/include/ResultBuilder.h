@@ -0,0 +1,26 @@
+// ResultBuilder.h
+#pragma once
+#include "Pipeline.h"
+#include "algorithm_result.pb.h"
+#include <atomic>
+#include <cstdint>
+
+// 由窗口记录填充 AlgorithmResult：调用方按线程复用同一个消息，字符串字段原地覆盖，
+// 结果 ID 单调递增并格式化到栈上缓冲区，消息的字段缓冲区建立后不再产生堆分配
+// （tests/ResultAllocationTest.cpp 验证）
+class ResultBuilder {
+public:
+    ResultBuilder() : nextResultId_(1) {}
+
+    // 线程安全，result 由调用方独占
+    void fill(const WindowRecord& record, int64_t timestampMs, AlgorithmResult& result);
+
+    // 按 AlertLevel 索引的静态文本，越界时按 CRITICAL 处理
+    static const char* alertLevelName(AlertLevel level);
+    static const char* recommendation(AlertLevel level);
+
+private:
+    static void fillSummary(const MetricSnapshot& snapshot, MetricSummary& summary);
+
+    std::atomic<uint64_t> nextResultId_;
+};
@@ -0,0 +1,47 @@
+// ResultDeadband.h
+#pragma once
+#include <chrono>
+#include <cstdint>
+
+// 按变化发布结果的死区策略，每个传感器（或聚合分组）一个 State：
+//   - 与上一次 *已发布* 的结果比较：警报等级变化、舒适度指数变化超过 epsilon、迟到窗口更新时发布
+//   - 数值变化的两次发布至少间隔 min_interval（最大速率），被抑制的变化在间隔过后的下一个结果中发布；
+//     警报等级变化和迟到窗口更新不受此限制，立即发布
+//   - 距上次发布超过 max_interval 时即使没有变化也发布一次（最小速率 / 心跳）
+// 判断只在有新结果时进行，传感器停止发送后不会补发
+class ResultDeadband {
+public:
+    struct Options {
+        bool enabled = true;  // false 时每个结果都发布
+        double epsilon = 1.0;
+        std::chrono::milliseconds minInterval{100};
+        std::chrono::milliseconds maxInterval{10000};
+    };
+
+    enum class Decision {
+        SUPPRESS,
+        FIRST,
+        ALERT_CHANGE,
+        VALUE_CHANGE,
+        LATE_UPDATE,
+        HEARTBEAT
+    };
+
+    struct State {
+        bool published = false;
+        uint8_t alert = 0;
+        double comfortIndex = 0;
+        std::chrono::steady_clock::time_point lastPublish;
+    };
+
+    explicit ResultDeadband(const Options& options) : options_(options) {}
+
+    // 决定是否发布；发布时更新 state
+    Decision evaluate(State& state, double comfortIndex, uint8_t alert, bool late,
+                      std::chrono::steady_clock::time_point now) const;
+
+    const Options& options() const { return options_; }
+
+private:
+    Options options_;
+};
@@ -0,0 +1,169 @@
+// SensorWorkerPool.h
+#pragma once
+#include "SlidingWindow.h"
+#include "StreamingStats.h"
+#include "AnomalyDetector.h"
+#include "EventTimeWindow.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 按 sensor_id 哈希分片的工作线程池：
+//   - 每个传感器固定落在一个工作线程上，其窗口状态只由该线程访问，不需要加锁
+//   - 同一传感器的样本按提交顺序处理；不同传感器在各线程上并行
+//   - 提交端与工作线程之间只有各分片自己的交接队列，工作线程一次取走整批任务，
+//     整批样本进入窗口后，对本批涉及的传感器调用一次处理器（便于批量计算）
+//   - 交接队列有上限，工作线程跟不上时丢弃新提交的任务并计数，不会无限占用内存
+class SensorWorkerPool {
+public:
+    struct SensorState {
+        struct Options {
+            size_t windowSize = 5;
+            StreamingStats::Options stats;
+            AnomalyDetector::Options anomaly;
+            bool eventTimeEnabled = false;
+            EventTimeWindow::Options eventTime;
+        };
+
+        // options 由线程池持有，检测器引用其中的阈值
+        explicit SensorState(const Options& options)
+            : window(options.windowSize), stats(options.stats), detector(options.anomaly),
+              eventWindow(options.eventTimeEnabled ? std::make_unique<EventTimeWindow>(options.eventTime) : nullptr) {}
+
+        // 含 NaN / 无穷的样本不进入任何状态并返回 false：窗口的滚动和一旦混入非有限值，
+        // 样本移出后也无法恢复，之后的均值、舒适度指数和异常检测都会失效
+        bool push(const SlidingWindow::Sample& sample) {
+            for (double value : sample.values) {
+                if (!std::isfinite(value)) {
+                    return false;
+                }
+            }
+            // 异常检测以样本进入前的窗口为基线
+            detector.update(window, sample, anomalies);
+            window.push(sample);
+            stats.push(sample);
+            if (eventWindow) {
+                eventWindow->push(sample, closedWindows);
+            }
+            return true;
+        }
+
+        // 检查点：窗口、流式统计、检测器和事件时间窗口的状态；与当前配置不兼容时 load 返回 false
+        void save(StateWriter& writer) const;
+        bool load(StateReader& reader);
+
+        SlidingWindow window;
+        StreamingStats stats;  // 全部历史的流式统计，不受窗口大小限制
+        AnomalyDetector detector;
+        std::vector<AnomalyDetector::Event> anomalies;  // 本批检测到、尚未发布的异常，由处理器取走
+        std::unique_ptr<EventTimeWindow> eventWindow;    // 未启用事件时间窗口时为空
+        std::vector<EventTimeWindow::Result> closedWindows;  // 本批关闭或更新的窗口，由处理器取走
+        uint64_t samples = 0;
+        std::chrono::steady_clock::time_point lastQuantiles;
+        std::chrono::steady_clock::time_point lastAnomalyReport;
+        uint64_t lastRound = 0;  // 最近一次被处理的批次，用于批内去重
+    };
+
+    struct Touched {
+        const std::string* sensorId;
+        SensorState* state;
+    };
+
+    // 在工作线程上调用，touched 中的状态只属于该线程，每个传感器在一批中只出现一次
+    using Processor = std::function<void(size_t worker, const std::vector<Touched>& touched)>;
+    // 在工作线程上、样本进入窗口之前调用，可以修改样本；返回 false 时丢弃
+    using SampleFilter = std::function<bool(size_t worker, SlidingWindow::Sample& sample)>;
+    // 接收一个工作线程的快照：若干条 [sensor_id][u32 长度][SensorState] 记录
+    using SnapshotSink = std::function<void(size_t worker, uint64_t generation, std::string&& data)>;
+
+    SensorWorkerPool(size_t workers, const SensorState::Options& options, Processor processor);
+    ~SensorWorkerPool();
+
+    SensorWorkerPool(const SensorWorkerPool&) = delete;
+    SensorWorkerPool& operator=(const SensorWorkerPool&) = delete;
+
+    // 需在 start 之前设置
+    void setSampleFilter(SampleFilter filter) { sampleFilter_ = std::move(filter); }
+    void setSnapshotSink(SnapshotSink sink) { snapshotSink_ = std::move(sink); }
+    // 每个工作线程最多积压的任务数
+    void setMaxPending(size_t jobs) { maxPending_ = std::max<size_t>(1, jobs); }
+    // 所有工作线程合计的传感器数上限；状态不会淘汰，达到上限后新传感器的样本被丢弃并计数
+    void setMaxSensors(size_t sensors) { maxSensors_ = std::max<size_t>(1, sensors); }
+
+    // 线程安全：请求每个工作线程在当前批次处理完后序列化自己的传感器状态并交给 sink，
+    // 状态只由所属线程访问，快照不需要加锁，也不会阻塞其他工作线程
+    void requestSnapshot(uint64_t generation);
+    // 工作线程未运行时（start 之前或 stop 之后）在调用线程上序列化全部状态
+    void snapshot(uint64_t generation);
+    // start 之前调用：从快照记录恢复一个传感器，状态与配置不兼容时丢弃并返回 false
+    bool restore(const std::string& sensorId, const char* data, size_t size);
+
+    void start();
+    void stop();
+
+    // 线程安全；批量提交的样本作为一个任务。队列已满时丢弃并返回 false
+    bool submit(const std::string& sensorId, const SlidingWindow::Sample& sample);
+    bool submit(const std::string& sensorId, std::vector<SlidingWindow::Sample> samples);
+
+    size_t workerCount() const { return workers_.size(); }
+    size_t shardOf(const std::string& sensorId) const;
+    uint64_t processedCount() const;
+    // 因队列已满被丢弃的样本数
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+    // 因含非有限值被丢弃的样本数
+    uint64_t invalidCount() const;
+    // 因传感器数达到上限被丢弃的样本数
+    uint64_t rejectedCount() const;
+    size_t sensorCount() const { return sensorCount_.load(std::memory_order_relaxed); }
+
+    static constexpr size_t DEFAULT_MAX_PENDING = 1 << 16;
+    static constexpr size_t DEFAULT_MAX_SENSORS = 100000;
+
+private:
+    struct Job {
+        std::string sensorId;
+        SlidingWindow::Sample sample;
+        std::vector<SlidingWindow::Sample> batch;  // 非空时忽略 sample
+    };
+
+    struct Worker {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::vector<Job> pending;
+        // 传感器只增不删（总数受 maxSensors_ 限制）；unordered_map 的节点在 rehash 时不搬移，
+        // Touched::sensorId 和下游 WindowRecord::key 可以一直引用这里的键
+        std::unordered_map<std::string, std::unique_ptr<SensorState>> sensors;
+        std::atomic<uint64_t> processed{0};
+        std::atomic<uint64_t> invalid{0};
+        std::atomic<uint64_t> rejected{0};
+        std::atomic<uint64_t> snapshotRequested{0};  // 请求的快照代数，0 表示没有请求
+        uint64_t snapshotTaken = 0;
+        std::thread thread;
+    };
+
+    bool enqueue(Job job);
+    // 在传感器总数上限内占用一个名额，已满时返回 false
+    bool reserveSensor();
+    void workerLoop(size_t index);
+    void takeSnapshot(size_t index, uint64_t generation);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    SensorState::Options options_;
+    Processor processor_;
+    SampleFilter sampleFilter_;
+    SnapshotSink snapshotSink_;
+    size_t maxPending_;
+    size_t maxSensors_;
+    std::atomic<size_t> sensorCount_;
+    std::atomic<bool> sensorLimitReported_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<bool> running_;
+};
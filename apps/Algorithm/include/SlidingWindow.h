@@ -0,0 +1,116 @@
+// SlidingWindow.h
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <limits>
+
+class StateReader;
+class StateWriter;
+
+// 固定容量的样本滑动窗口：环形缓冲区 + 增量聚合，每个样本的处理代价与窗口大小无关
+//   - 均值/方差：带 Neumaier 补偿的滚动和与平方和，加入/移出各一次，百万级窗口长时间运行也不会累积误差；
+//     累加的是相对基准值的偏移量，平方和不会因数值较大（如气压）而抵消精度
+//   - 极值：单调队列，每个样本最多入队、出队一次（均摊 O(1)）
+//   - 存储按需倍增到容量上限，样本少的传感器不会占用整个窗口的内存
+class SlidingWindow {
+public:
+    enum Channel : size_t {
+        TEMPERATURE = 0,
+        HUMIDITY,
+        PRESSURE,
+        CHANNEL_COUNT
+    };
+
+    struct Sample {
+        int64_t timestamp = 0;  // 毫秒
+        std::array<double, CHANNEL_COUNT> values{};
+    };
+
+    static constexpr size_t MAX_CAPACITY = std::numeric_limits<uint32_t>::max();
+
+    explicit SlidingWindow(size_t capacity);
+
+    // 重新设置容量并清空窗口
+    void setCapacity(size_t capacity);
+    void clear();
+
+    void push(const Sample& sample);
+
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    bool empty() const { return size_ == 0; }
+
+    // 窗口为空时调用结果未定义
+    double mean(Channel channel) const;
+    // 样本方差（n - 1），少于两个样本时为 0
+    double variance(Channel channel) const;
+    double min(Channel channel) const;
+    double max(Channel channel) const;
+    const Sample& latest() const;
+    const Sample& oldest() const;
+
+    // 检查点：保存窗口内的样本（从旧到新）和滚动和，恢复时重新加入样本以重建单调队列；
+    // 容量变小时只保留最新的 capacity 个样本，滚动和重新计算
+    void save(StateWriter& writer) const;
+    bool load(StateReader& reader);
+
+private:
+    void rebase();
+    // 窗口未满且存储已用完时扩容；未满时样本按写入顺序存放在 [0, size_)，扩容不需要搬动槽位
+    void grow();
+
+    static constexpr size_t MIN_REBASE_INTERVAL = 4096;
+    static constexpr size_t INITIAL_STORAGE = 16;
+
+    // 定长单调队列，存放样本在环形缓冲区中的槽位（窗口内每个槽位只对应一个样本）
+    // 下标回绕使用比较而非取模，避免热路径上的整数除法
+    class MonotonicQueue {
+    public:
+        void reset(size_t capacity);
+        // 扩大容量，保留队列内容（按从头到尾的顺序重新排列）
+        void grow(size_t capacity);
+        bool empty() const { return size_ == 0; }
+        uint32_t front() const { return slots_[head_]; }
+        uint32_t back() const {
+            size_t index = head_ + size_ - 1;
+            return slots_[index >= slots_.size() ? index - slots_.size() : index];
+        }
+        void popFront() {
+            head_ = head_ + 1 == slots_.size() ? 0 : head_ + 1;
+            --size_;
+        }
+        void popBack() { --size_; }
+        void pushBack(uint32_t slot) {
+            size_t index = head_ + size_;
+            slots_[index >= slots_.size() ? index - slots_.size() : index] = slot;
+            ++size_;
+        }
+
+    private:
+        std::vector<uint32_t> slots_;
+        size_t head_ = 0;
+        size_t size_ = 0;
+    };
+
+    struct RunningSum {
+        double sum = 0;
+        double compensation = 0;
+
+        void add(double value);
+        double value() const { return sum + compensation; }
+    };
+
+    std::vector<Sample> samples_;  // 大小 <= capacity_，窗口满之前按需增长
+    size_t capacity_;
+    size_t size_;
+    size_t writePos_;  // 下一个样本写入的槽位；窗口满时即最旧样本的槽位
+    size_t sinceRebase_;
+
+    std::array<double, CHANNEL_COUNT> shifts_;  // 滚动和的基准值：清空后第一个样本，之后每圈取当前均值
+    std::array<RunningSum, CHANNEL_COUNT> sums_;
+    std::array<RunningSum, CHANNEL_COUNT> squares_;
+    std::array<MonotonicQueue, CHANNEL_COUNT> minQueues_;  // 值递增
+    std::array<MonotonicQueue, CHANNEL_COUNT> maxQueues_;  // 值递减
+};
@@ -0,0 +1,67 @@
+// SpscQueue.h
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// 有界单生产者单消费者无锁队列：
+//   - 生产者只写 tail_、消费者只写 head_，各自缓存对方的下标，只有缓存显示满/空时才读取对方的原子变量
+//   - 下标分别放在独立的缓存行上，避免两个线程之间的伪共享
+template <typename T>
+class SpscQueue {
+public:
+    // 容量向上取整为 2 的幂
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size *= 2;
+        }
+        slots_.resize(size);
+        mask_ = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // 仅生产者调用；队列满时返回 false，value 保持不变
+    bool tryPush(T&& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ == slots_.size()) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ == slots_.size()) {
+                return false;
+            }
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 仅消费者调用；队列空时返回 false
+    bool tryPop(T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cachedTail_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_) {
+                return false;
+            }
+        }
+        value = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 任意线程调用，结果只是瞬时快照
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0};  // 消费者
+    size_t cachedTail_ = 0;
+    alignas(64) std::atomic<size_t> tail_{0};  // 生产者
+    size_t cachedHead_ = 0;
+};
@@ -0,0 +1,75 @@
+// StateCheckpoint.h
+#pragma once
+#include "SensorWorkerPool.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 每个传感器窗口状态的周期检查点，重启时直接恢复，不必等待窗口重新填满：
+//   - 后台线程定期向线程池请求快照，各工作线程在两批之间序列化自己的传感器（状态只属于该线程，不加锁），
+//     交出缓冲区后立即继续处理；文件写入、fsync 和改名都在后台线程上进行
+//   - 文件布局：FileHeader + 各工作线程的记录，记录为 [u32 长度][sensor_id][u32 长度][SensorState]；
+//     先写临时文件再 rename，崩溃时保留上一个完整的检查点
+//   - 启动时校验魔数、版本和 CRC 后逐个恢复；与当前配置不兼容的传感器状态被丢弃，从空窗口开始
+//   - 停止时线程池退出后再同步写一次，正常重启不丢失任何样本
+class StateCheckpoint {
+public:
+    struct Options {
+        bool enabled = false;
+        std::string path = "algorithm.ckpt";
+        std::chrono::milliseconds interval{10000};
+    };
+
+    StateCheckpoint(const Options& options, SensorWorkerPool& pool);
+    ~StateCheckpoint();
+
+    StateCheckpoint(const StateCheckpoint&) = delete;
+    StateCheckpoint& operator=(const StateCheckpoint&) = delete;
+
+    // 线程池 start 之前调用；文件不存在或损坏时返回 false
+    bool restore();
+    // 线程池 start 之前调用：设置快照接收端并启动后台线程
+    void start();
+    // 线程池 stop 之前调用，未完成的快照被放弃
+    void stop();
+    // 线程池 stop 之后调用：在调用线程上序列化全部状态并写入文件
+    bool writeFinal();
+
+    uint64_t checkpointCount() const { return checkpoints_.load(); }
+
+private:
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t generation;
+        int64_t createdMs;    // 写入时的系统时间
+        uint64_t bodyLength;  // 头之后的字节数
+        uint32_t checksum;    // 头之后全部字节的 CRC32
+        uint32_t reserved;
+    };
+
+    void run();
+    void collect(size_t worker, uint64_t generation, std::string&& data);
+    // 写入临时文件，fsync 后替换检查点文件
+    bool write(uint64_t generation, const std::vector<std::string>& parts);
+
+
+    Options options_;
+    SensorWorkerPool& pool_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::vector<std::string> parts_;  // 当前代各工作线程的快照
+    size_t received_;
+    uint64_t generation_;
+    bool running_;
+    std::thread thread_;
+    std::atomic<uint64_t> checkpoints_;
+
+    static constexpr uint32_t MAGIC = 0x4B434C41;  // "ALCK"
+    static constexpr uint32_t VERSION = 1;
+};
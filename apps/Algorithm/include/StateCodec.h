@@ -0,0 +1,104 @@
+// StateCodec.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// 检查点的二进制读写：本机字节序，定长字段按内存布局直接拷贝；检查点只在同一台机器上恢复
+class StateWriter {
+public:
+    explicit StateWriter(std::string& out) : out_(out) {}
+
+    template <typename T>
+    void write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "StateWriter::write needs a trivially copyable type");
+        out_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void writeString(const std::string& value) {
+        write(static_cast<uint32_t>(value.size()));
+        out_.append(value);
+    }
+
+    template <typename T>
+    void writeVector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable_v<T>, "StateWriter::writeVector needs a trivially copyable type");
+        write(static_cast<uint64_t>(values.size()));
+        out_.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    size_t size() const { return out_.size(); }
+    // 回填之前预留的定长字段（例如记录长度）
+    template <typename T>
+    void patch(size_t offset, const T& value) {
+        std::memcpy(&out_[offset], &value, sizeof(T));
+    }
+
+private:
+    std::string& out_;
+};
+
+// 越界时置为失败，之后的读取全部返回 false
+class StateReader {
+public:
+    StateReader(const char* data, size_t size) : pos_(data), end_(data + size), ok_(true) {}
+
+    template <typename T>
+    bool read(T& value) {
+        static_assert(std::is_trivially_copyable_v<T>, "StateReader::read needs a trivially copyable type");
+        if (!take(sizeof(T))) {
+            return false;
+        }
+        std::memcpy(&value, pos_ - sizeof(T), sizeof(T));
+        return true;
+    }
+
+    bool readString(std::string& value) {
+        uint32_t length = 0;
+        if (!read(length) || !take(length)) {
+            return false;
+        }
+        value.assign(pos_ - length, length);
+        return true;
+    }
+
+    template <typename T>
+    bool readVector(std::vector<T>& values) {
+        uint64_t count = 0;
+        if (!read(count) || count > remaining() / sizeof(T)) {
+            return fail();
+        }
+        values.resize(static_cast<size_t>(count));
+        std::memcpy(values.data(), pos_, values.size() * sizeof(T));
+        pos_ += values.size() * sizeof(T);
+        return true;
+    }
+
+    // 跳过 size 字节，返回其起始位置；越界时返回 nullptr
+    const char* skip(size_t size) {
+        return take(size) ? pos_ - size : nullptr;
+    }
+
+    bool fail() {
+        ok_ = false;
+        return false;
+    }
+    bool ok() const { return ok_; }
+    size_t remaining() const { return ok_ ? static_cast<size_t>(end_ - pos_) : 0; }
+
+private:
+    bool take(size_t size) {
+        if (!ok_ || size > static_cast<size_t>(end_ - pos_)) {
+            return fail();
+        }
+        pos_ += size;
+        return true;
+    }
+
+    const char* pos_;
+    const char* end_;
+    bool ok_;
+};
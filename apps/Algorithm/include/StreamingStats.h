@@ -0,0 +1,157 @@
+// StreamingStats.h
+#pragma once
+#include "SlidingWindow.h"
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class StateReader;
+class StateWriter;
+
+// 指数加权移动平均，首个样本直接作为初值
+class Ewma {
+public:
+    explicit Ewma(double alpha = 0.1) : alpha_(alpha) {}
+
+    void update(double value) {
+        value_ = initialized_ ? value_ + alpha_ * (value - value_) : value;
+        initialized_ = true;
+    }
+    double value() const { return value_; }
+    bool empty() const { return !initialized_; }
+
+    void save(StateWriter& writer) const;
+    bool load(StateReader& reader);
+
+private:
+    double alpha_;
+    double value_ = 0;
+    bool initialized_ = false;
+};
+
+// Welford 在线均值/方差，可与其他分片的结果合并（Chan 公式）
+class WelfordVariance {
+public:
+    void update(double value);
+    void merge(const WelfordVariance& other);
+
+    uint64_t count() const { return count_; }
+    double mean() const { return mean_; }
+    // 样本方差（n - 1）；少于两个样本时为 0
+    double variance() const;
+    double stddev() const;
+
+    void save(StateWriter& writer) const;
+    bool load(StateReader& reader);
+
+private:
+    uint64_t count_ = 0;
+    double mean_ = 0;
+    double m2_ = 0;
+};
+
+// KLL 分位数草图：按层级保存样本，第 h 层每个样本代表 2^h 个原始样本
+//   - 某层超出容量时排序并随机保留奇数位或偶数位，提升到上一层（均摊 O(log k)）
+//   - 保留样本数约为 3k，与数据量无关；秩误差约 1.7/k（k = 128 时约 1.3%）
+//   - 可合并：不同传感器或分片的草图可汇总为整体分布
+class KllSketch {
+public:
+    explicit KllSketch(uint32_t k = DEFAULT_K, uint64_t seed = 1);
+
+    void update(double value);
+    void merge(const KllSketch& other);
+    void clear();
+
+    uint64_t count() const { return count_; }
+    size_t retained() const { return retained_; }
+    bool empty() const { return count_ == 0; }
+    double minValue() const { return min_; }
+    double maxValue() const { return max_; }
+
+    // q 取 [0, 1]；草图为空时返回 0。每次查询需要对保留样本排序（O(k log k)）
+    double quantile(double q) const;
+    // 一次排序回答多个分位数
+    void quantiles(const double* q, double* out, size_t count) const;
+
+    // 保存各层样本和随机数状态，恢复后的草图与保存时完全一致；k 不同时恢复失败
+    void save(StateWriter& writer) const;
+    bool load(StateReader& reader);
+
+    static constexpr uint32_t DEFAULT_K = 128;
+    static constexpr uint32_t MIN_K = 8;
+    static constexpr uint32_t MAX_LEVELS = 64;
+
+private:
+    void updateCapacity();
+    void compress();
+    bool nextBit();
+
+    uint32_t k_;
+    uint64_t rng_;
+    uint64_t count_;
+    size_t retained_;
+    size_t capacity_;  // 各层容量之和，保留样本数达到该值时压缩
+    double min_;
+    double max_;
+    std::vector<std::vector<double>> levels_;
+    std::vector<uint32_t> capacities_;
+    mutable std::vector<std::pair<double, uint64_t>> sorted_;  // 查询用的（值, 累计权重）
+};
+
+// 单个指标的流式统计；窗口极值由 SlidingWindow 的单调队列提供
+struct MetricStats {
+    MetricStats(double ewmaAlpha, uint32_t sketchK, uint64_t seed) : ewma(ewmaAlpha), sketch(sketchK, seed) {}
+
+    // NaN / 无穷在这里统一跳过：一个非有限值会让 EWMA 和 Welford 之后的结果永久变成 NaN
+    void update(double value) {
+        if (!std::isfinite(value)) {
+            return;
+        }
+        ewma.update(value);
+        variance.update(value);
+        sketch.update(value);
+    }
+
+    void save(StateWriter& writer) const;
+    bool load(StateReader& reader);
+
+    Ewma ewma;
+    WelfordVariance variance;
+    KllSketch sketch;
+};
+
+// 每个传感器温度/湿度/气压三个指标的流式统计，不保存原始历史
+class StreamingStats {
+public:
+    struct Options {
+        bool enabled = true;
+        double ewmaAlpha = 0.1;
+        uint32_t sketchK = KllSketch::DEFAULT_K;
+    };
+
+    // 对外发布的分位数：p50 / p95 / p99
+    static constexpr std::array<double, 3> PUBLISHED_QUANTILES = {0.5, 0.95, 0.99};
+    using Quantiles = std::array<double, PUBLISHED_QUANTILES.size()>;
+
+    explicit StreamingStats(const Options& options);
+
+    bool enabled() const { return !metrics_.empty(); }
+    void push(const SlidingWindow::Sample& sample);
+
+    // 未启用时调用结果未定义
+    const MetricStats& metric(SlidingWindow::Channel channel) const { return metrics_[channel]; }
+
+    // 分位数查询需要排序，结果缓存到下一次刷新；刷新频率由调用方控制
+    void refreshQuantiles();
+    const Quantiles& quantiles(SlidingWindow::Channel channel) const { return quantiles_[channel]; }
+
+    // 启用状态或草图参数与保存时不同时恢复失败
+    void save(StateWriter& writer) const;
+    bool load(StateReader& reader);
+
+private:
+    std::vector<MetricStats> metrics_;
+    std::array<Quantiles, SlidingWindow::CHANNEL_COUNT> quantiles_{};
+};
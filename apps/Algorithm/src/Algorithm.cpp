@@ -1,129 +1,460 @@
 #include "Algorithm.h"
+#include "ConfigManager.h"
+#include "ThreadPlacement.h"
 #include <iostream>
 #include <algorithm>
 #include <numeric>
 #include <chrono>
 #include <thread>
+#include <unordered_map>
 
-Algorithm::Algorithm() : AppTemplate("Algorithm", 20002) {}
+namespace {
+
+static_assert(static_cast<int>(SlidingWindow::TEMPERATURE) == METRIC_TEMPERATURE &&
+              static_cast<int>(SlidingWindow::HUMIDITY) == METRIC_HUMIDITY &&
+              static_cast<int>(SlidingWindow::PRESSURE) == METRIC_PRESSURE,
+              "SlidingWindow::Channel must match SensorMetric");
+static_assert(static_cast<int>(AnomalyDetector::ZSCORE) == ANOMALY_ZSCORE &&
+              static_cast<int>(AnomalyDetector::CUSUM_HIGH) == ANOMALY_CUSUM_HIGH &&
+              static_cast<int>(AnomalyDetector::CUSUM_LOW) == ANOMALY_CUSUM_LOW &&
+              static_cast<int>(AnomalyDetector::EWMA) == ANOMALY_EWMA,
+              "AnomalyDetector::Kind must match AnomalyKind");
+
+} // namespace
+
+Algorithm::Algorithm()
+    : AppTemplate("Algorithm", 20002), windowSize_(DEFAULT_WINDOW_SIZE), workerCount_(1),
+      maxPending_(SensorWorkerPool::DEFAULT_MAX_PENDING),
+      maxSensors_(SensorWorkerPool::DEFAULT_MAX_SENSORS),
+      quantileInterval_(DEFAULT_QUANTILE_INTERVAL), anomalyCount_(0), eventTimeEnabled_(false),
+      deadband_(ResultDeadband::Options()), publishCounts_{} {}
 
 void Algorithm::initialize() {
     std::cout << "[Algorithm] Initializing algorithm processor" << std::endl;
+    loadWindowConfig();
+    loadStatsConfig();
+    loadAnomalyConfig();
+    loadEventTimeConfig();
+    loadPipelineConfig();
+    loadPublishConfig();
+    loadCheckpointConfig();
+
+    bool kernelVerified = ComfortKernel::selfTest();
+    std::cout << "[Algorithm] Comfort kernel: " << ComfortKernel::isaName(ComfortKernel::activeIsa())
+              << (kernelVerified ? " (verified against scalar)" : " (SIMD mismatch, using scalar)") << std::endl;
+
+    SensorWorkerPool::SensorState::Options stateOptions;
+    stateOptions.windowSize = windowSize_;
+    stateOptions.stats = statsOptions_;
+    stateOptions.anomaly = anomalyOptions_;
+    stateOptions.eventTimeEnabled = eventTimeEnabled_;
+    stateOptions.eventTime = eventTimeOptions_;
+    workers_ = std::make_unique<SensorWorkerPool>(workerCount_, stateOptions,
+        [this](size_t worker, const std::vector<SensorWorkerPool::Touched>& touched) {
+            for (const auto& entry : touched) {
+                if (!entry.state->anomalies.empty()) {
+                    publishAnomalies(*entry.sensorId, *entry.state);
+                }
+            }
+            pipeline_->processRound(worker, touched);
+        });
+    workers_->setMaxPending(maxPending_);
+    workers_->setMaxSensors(maxSensors_);
+    if (pipeline_->hasSampleOperators()) {
+        workers_->setSampleFilter([this](size_t worker, SlidingWindow::Sample& sample) {
+            return pipeline_->processSample(worker, sample);
+        });
+    }
+    if (checkpointOptions_.enabled) {
+        checkpoint_ = std::make_unique<StateCheckpoint>(checkpointOptions_, *workers_);
+        checkpoint_->restore();
+        checkpoint_->start();
+    }
+    pipeline_->start(workers_->workerCount());
+    workers_->start();
     
     // 注册传感器数据处理器
-    registerHandler("sensor.data", [this](const std::string& eventType, const std::string& data) {
-        handleSensorData(eventType, data);
+    subscribe<SensorDataTopic>([this](const sensor::SensorSample& sensorData) {
+        handleSensorData(sensorData);
+    });
+    subscribe<SensorBatchTopic>([this](const SensorBatch& batch) {
+        handleSensorBatch(batch);
     });
+    sensor::subscribeSensorIds(*this);
     
     // 连接到传感器
     connectToPeer("127.0.0.1", 20001);
 }
 
+void Algorithm::loadWindowConfig() {
+    ConfigManager& config = ConfigManager::getInstance();
+    int configured = config.getInt("algorithm", "window_size", static_cast<int>(DEFAULT_WINDOW_SIZE));
+    windowSize_ = static_cast<size_t>(std::max(configured, static_cast<int>(MIN_SAMPLES)));
+    if (windowSize_ > MAX_WINDOW_SIZE) {
+        std::cerr << "[Algorithm] window_size " << windowSize_ << " too large, using " << MAX_WINDOW_SIZE << std::endl;
+        windowSize_ = MAX_WINDOW_SIZE;
+    }
+
+    // 工作线程数：algorithm.workers > threads.app.count > CPU 核数
+    int defaultWorkers = ThreadPlacement::getInstance().threadCount(
+        ThreadRole::App, static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+    workerCount_ = static_cast<size_t>(std::max(1, config.getInt("algorithm", "workers", defaultWorkers)));
+    maxPending_ = static_cast<size_t>(std::max(1, config.getInt("algorithm", "max_pending",
+        static_cast<int>(SensorWorkerPool::DEFAULT_MAX_PENDING))));
+    maxSensors_ = static_cast<size_t>(std::max(1, config.getInt("algorithm", "max_sensors",
+        static_cast<int>(SensorWorkerPool::DEFAULT_MAX_SENSORS))));
+    std::cout << "[Algorithm] Sliding window size: " << windowSize_ << " per sensor, "
+              << workerCount_ << " worker(s), up to " << maxPending_ << " pending job(s) per worker, "
+              << maxSensors_ << " sensor(s)" << std::endl;
+}
+
+void Algorithm::loadStatsConfig() {
+    const rapidjson::Value* algorithmConfig = ConfigManager::getInstance().getObject("algorithm");
+    if (algorithmConfig && algorithmConfig->IsObject() && algorithmConfig->HasMember("stats") &&
+        (*algorithmConfig)["stats"].IsObject()) {
+        const rapidjson::Value& stats = (*algorithmConfig)["stats"];
+        if (stats.HasMember("enabled") && stats["enabled"].IsBool()) {
+            statsOptions_.enabled = stats["enabled"].GetBool();
+        }
+        if (stats.HasMember("ewma_alpha") && stats["ewma_alpha"].IsNumber()) {
+            double alpha = stats["ewma_alpha"].GetDouble();
+            if (alpha > 0.0 && alpha <= 1.0) {
+                statsOptions_.ewmaAlpha = alpha;
+            } else {
+                std::cerr << "[Algorithm] Invalid stats.ewma_alpha " << alpha << ", using " << statsOptions_.ewmaAlpha << std::endl;
+            }
+        }
+        if (stats.HasMember("sketch_k") && stats["sketch_k"].IsUint()) {
+            statsOptions_.sketchK = std::max(stats["sketch_k"].GetUint(), KllSketch::MIN_K);
+        }
+        if (stats.HasMember("quantile_interval_ms") && stats["quantile_interval_ms"].IsUint()) {
+            quantileInterval_ = std::chrono::milliseconds(stats["quantile_interval_ms"].GetUint());
+        }
+    }
+
+    if (statsOptions_.enabled) {
+        std::cout << "[Algorithm] Streaming stats: EWMA alpha " << statsOptions_.ewmaAlpha << ", KLL k "
+                  << statsOptions_.sketchK << ", quantiles every " << quantileInterval_.count() << " ms" << std::endl;
+    } else {
+        std::cout << "[Algorithm] Streaming stats disabled" << std::endl;
+    }
+}
+
+void Algorithm::loadAnomalyConfig() {
+    const rapidjson::Value* algorithmConfig = ConfigManager::getInstance().getObject("algorithm");
+    if (algorithmConfig && algorithmConfig->IsObject() && algorithmConfig->HasMember("anomaly") &&
+        (*algorithmConfig)["anomaly"].IsObject()) {
+        const rapidjson::Value& anomaly = (*algorithmConfig)["anomaly"];
+        auto readPositive = [&anomaly](const char* key, double& target) {
+            if (anomaly.HasMember(key) && anomaly[key].IsNumber()) {
+                double value = anomaly[key].GetDouble();
+                if (value > 0.0) {
+                    target = value;
+                } else {
+                    std::cerr << "[Algorithm] Invalid anomaly." << key << " " << value << ", using " << target << std::endl;
+                }
+            }
+        };
+        if (anomaly.HasMember("enabled") && anomaly["enabled"].IsBool()) {
+            anomalyOptions_.enabled = anomaly["enabled"].GetBool();
+        }
+        readPositive("z_threshold", anomalyOptions_.zThreshold);
+        readPositive("cusum_k", anomalyOptions_.cusumK);
+        readPositive("cusum_h", anomalyOptions_.cusumH);
+        readPositive("ewma_l", anomalyOptions_.ewmaL);
+        readPositive("min_stddev", anomalyOptions_.minStddev);
+        double lambda = anomalyOptions_.ewmaLambda;
+        readPositive("ewma_lambda", lambda);
+        anomalyOptions_.ewmaLambda = std::min(lambda, 1.0);
+        if (anomaly.HasMember("warmup") && anomaly["warmup"].IsUint()) {
+            anomalyOptions_.warmup = anomaly["warmup"].GetUint();
+        }
+    }
+
+    if (anomalyOptions_.enabled) {
+        std::cout << "[Algorithm] Anomaly detection: z > " << anomalyOptions_.zThreshold << ", CUSUM k="
+                  << anomalyOptions_.cusumK << " h=" << anomalyOptions_.cusumH << ", EWMA lambda="
+                  << anomalyOptions_.ewmaLambda << " L=" << anomalyOptions_.ewmaL << ", warmup "
+                  << std::min(anomalyOptions_.warmup, windowSize_) << " samples" << std::endl;
+    } else {
+        std::cout << "[Algorithm] Anomaly detection disabled" << std::endl;
+    }
+}
+
+void Algorithm::loadEventTimeConfig() {
+    const rapidjson::Value* algorithmConfig = ConfigManager::getInstance().getObject("algorithm");
+    if (!algorithmConfig || !algorithmConfig->IsObject() || !algorithmConfig->HasMember("event_time") ||
+        !(*algorithmConfig)["event_time"].IsObject()) {
+        return;
+    }
+    const rapidjson::Value& eventTime = (*algorithmConfig)["event_time"];
+    eventTimeEnabled_ = !(eventTime.HasMember("enabled") && eventTime["enabled"].IsBool()) || eventTime["enabled"].GetBool();
+    if (eventTime.HasMember("size_ms") && eventTime["size_ms"].IsInt64()) {
+        eventTimeOptions_.sizeMs = eventTime["size_ms"].GetInt64();
+    }
+    // 缺省 slide 等于 size，即滚动窗口
+    eventTimeOptions_.slideMs = eventTimeOptions_.sizeMs;
+    if (eventTime.HasMember("slide_ms") && eventTime["slide_ms"].IsInt64()) {
+        eventTimeOptions_.slideMs = eventTime["slide_ms"].GetInt64();
+    }
+    if (eventTime.HasMember("max_delay_ms") && eventTime["max_delay_ms"].IsInt64()) {
+        eventTimeOptions_.maxDelayMs = eventTime["max_delay_ms"].GetInt64();
+    }
+    if (eventTime.HasMember("allowed_lateness_ms") && eventTime["allowed_lateness_ms"].IsInt64()) {
+        eventTimeOptions_.allowedLatenessMs = eventTime["allowed_lateness_ms"].GetInt64();
+    }
+    eventTimeOptions_.normalize();
+
+    if (eventTimeEnabled_) {
+        std::cout << "[Algorithm] Event-time windows: size " << eventTimeOptions_.sizeMs << " ms, slide "
+                  << eventTimeOptions_.slideMs << " ms, max delay " << eventTimeOptions_.maxDelayMs
+                  << " ms, allowed lateness " << eventTimeOptions_.allowedLatenessMs << " ms" << std::endl;
+    }
+}
+
+void Algorithm::loadPipelineConfig() {
+    Pipeline::Context context;
+    context.emit = [this](const RecordBatch& batch) {
+        emitResults(batch);
+    };
+    context.quantileInterval = quantileInterval_;
+    context.minWindowSamples = MIN_SAMPLES;
+    context.stats = statsOptions_.enabled;
+    pipeline_ = std::make_unique<Pipeline>(std::move(context));
+
+    // 算子参数直接引用 ConfigManager 中的文档，配置只在启动时加载一次
+    const rapidjson::Value* algorithmConfig = ConfigManager::getInstance().getObject("algorithm");
+    if (!algorithmConfig || !algorithmConfig->IsObject() || !algorithmConfig->HasMember("pipeline")) {
+        return;
+    }
+    std::string error;
+    if (!pipeline_->configure(&(*algorithmConfig)["pipeline"], error)) {
+        std::cerr << "[Algorithm] Invalid pipeline (" << error << "), using default" << std::endl;
+    }
+}
+
+void Algorithm::loadPublishConfig() {
+    ResultDeadband::Options options;
+    const rapidjson::Value* algorithmConfig = ConfigManager::getInstance().getObject("algorithm");
+    if (algorithmConfig && algorithmConfig->IsObject() && algorithmConfig->HasMember("publish") &&
+        (*algorithmConfig)["publish"].IsObject()) {
+        const rapidjson::Value& publish = (*algorithmConfig)["publish"];
+        if (publish.HasMember("enabled") && publish["enabled"].IsBool()) {
+            options.enabled = publish["enabled"].GetBool();
+        }
+        if (publish.HasMember("epsilon") && publish["epsilon"].IsNumber()) {
+            options.epsilon = std::max(0.0, publish["epsilon"].GetDouble());
+        }
+        if (publish.HasMember("min_interval_ms") && publish["min_interval_ms"].IsUint()) {
+            options.minInterval = std::chrono::milliseconds(publish["min_interval_ms"].GetUint());
+        }
+        if (publish.HasMember("max_interval_ms") && publish["max_interval_ms"].IsUint()) {
+            options.maxInterval = std::chrono::milliseconds(publish["max_interval_ms"].GetUint());
+        }
+    }
+    if (options.maxInterval < options.minInterval) {
+        std::cerr << "[Algorithm] publish.max_interval_ms below min_interval_ms, using " << options.minInterval.count() << std::endl;
+        options.maxInterval = options.minInterval;
+    }
+    deadband_ = ResultDeadband(options);
+
+    if (options.enabled) {
+        std::cout << "[Algorithm] Result deadband: epsilon " << options.epsilon << ", interval "
+                  << options.minInterval.count() << " ~ " << options.maxInterval.count() << " ms" << std::endl;
+    } else {
+        std::cout << "[Algorithm] Result deadband disabled, publishing every result" << std::endl;
+    }
+}
+
+void Algorithm::loadCheckpointConfig() {
+    const rapidjson::Value* algorithmConfig = ConfigManager::getInstance().getObject("algorithm");
+    if (algorithmConfig && algorithmConfig->IsObject() && algorithmConfig->HasMember("checkpoint") &&
+        (*algorithmConfig)["checkpoint"].IsObject()) {
+        const rapidjson::Value& checkpoint = (*algorithmConfig)["checkpoint"];
+        if (checkpoint.HasMember("enabled") && checkpoint["enabled"].IsBool()) {
+            checkpointOptions_.enabled = checkpoint["enabled"].GetBool();
+        }
+        if (checkpoint.HasMember("path") && checkpoint["path"].IsString()) {
+            checkpointOptions_.path = checkpoint["path"].GetString();
+        }
+        if (checkpoint.HasMember("interval_ms") && checkpoint["interval_ms"].IsUint()) {
+            checkpointOptions_.interval = std::chrono::milliseconds(checkpoint["interval_ms"].GetUint());
+        }
+    }
+    // 快照由各工作线程在两批之间异步生成，与日志偏移没有一一对应（已写入日志的样本可能仍在队列中），
+    // 在检查点之上回放日志会重复或遗漏样本，因此两者不能同时启用，以日志回放为准
+    if (checkpointOptions_.enabled && journalReplay_) {
+        std::cerr << "[Algorithm] State checkpoint cannot be combined with eventbus.journal.replay_on_start, "
+                  << "checkpoint disabled" << std::endl;
+        checkpointOptions_.enabled = false;
+    }
+    if (!checkpointOptions_.enabled) {
+        std::cout << "[Algorithm] State checkpoints disabled" << std::endl;
+    }
+}
+
 void Algorithm::run() {
     std::cout << "[Algorithm] Started processing sensor data. Press Ctrl+C to stop." << std::endl;
     
-    while (running_) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-    }
+    runEventLoop();
 }
 
 void Algorithm::cleanup() {
     std::cout << "[Algorithm] Cleaning up..." << std::endl;
+    if (workers_) {
+        // 先停止工作线程，流水线下游阶段再处理完剩余的记录
+        if (checkpoint_) {
+            checkpoint_->stop();
+        }
+        workers_->stop();
+        pipeline_->stop();
+        if (checkpoint_ && checkpoint_->writeFinal()) {
+            std::cout << "[Algorithm] Wrote " << checkpoint_->checkpointCount() << " state checkpoint(s)" << std::endl;
+        }
+        std::cout << "[Algorithm] Processed " << workers_->processedCount() << " samples, "
+                  << anomalyCount_.load() << " anomalies, dropped " << workers_->droppedCount() << " (queue full), "
+                  << workers_->invalidCount() << " (non-finite values), " << workers_->rejectedCount()
+                  << " (sensor limit, " << workers_->sensorCount() << " sensors)" << std::endl;
+        auto count = [this](ResultDeadband::Decision decision) {
+            return publishCounts_[static_cast<size_t>(decision)].load();
+        };
+        uint64_t published = count(ResultDeadband::Decision::FIRST) + count(ResultDeadband::Decision::ALERT_CHANGE) +
+                             count(ResultDeadband::Decision::VALUE_CHANGE) + count(ResultDeadband::Decision::LATE_UPDATE) +
+                             count(ResultDeadband::Decision::HEARTBEAT);
+        std::cout << "[Algorithm] Published " << published << " results (" << count(ResultDeadband::Decision::ALERT_CHANGE)
+                  << " alert changes, " << count(ResultDeadband::Decision::VALUE_CHANGE) << " value changes, "
+                  << count(ResultDeadband::Decision::HEARTBEAT) << " heartbeats), suppressed "
+                  << count(ResultDeadband::Decision::SUPPRESS) << std::endl;
+    }
 }
 
-void Algorithm::handleSensorData(const std::string& eventType, const std::string& data) {
-    SensorData sensorData;
-    if (!sensorData.ParseFromString(data)) {
-        std::cerr << "[Algorithm] Failed to parse sensor data" << std::endl;
+void Algorithm::handleSensorData(const sensor::SensorSample& sensorData) {
+    SlidingWindow::Sample sample;
+    sample.timestamp = sensorData.timestamp();
+    sample.values = {sensorData.temperature(), sensorData.humidity(), sensorData.pressure()};
+    // ID 映射尚未收到的二进制样本按 sensor_key 区分，不会全部合并到空名称下
+    std::string placeholder;
+    workers_->submit(sensorData.sensor_name(placeholder), sample);
+}
+
+void Algorithm::handleSensorBatch(const SensorBatch& batch) {
+    int count = batch.temperature_size();
+    if (count == 0 || batch.humidity_size() != count || batch.pressure_size() != count ||
+        batch.timestamps_us_size() != count) {
+        std::cerr << "[Algorithm] Malformed batch " << batch.sequence() << " from " << batch.sensor_id() << std::endl;
         return;
     }
-    
-    std::cout << "[Algorithm] Received SensorData: "
-            << "T=" << sensorData.temperature()
-            << " H=" << sensorData.humidity()
-            << " P=" << sensorData.pressure()
-            << std::endl;
 
-    std::lock_guard<std::mutex> lock(bufferMutex_);
-    
-    // 添加到缓冲区
-    sensorDataBuffer_.push_back(sensorData);
-    if (sensorDataBuffer_.size() > BUFFER_SIZE) {
-        sensorDataBuffer_.erase(sensorDataBuffer_.begin());
+    // 流式统计和事件时间窗口需要全部样本；否则计数窗口之外的样本不影响结果，直接跳过
+    // 流水线中有逐样本算子时过滤可能丢弃样本，同样需要全部样本
+    bool keepAll = statsOptions_.enabled || eventTimeEnabled_ || pipeline_->hasSampleOperators();
+    int first = keepAll ? 0 : std::max(0, count - static_cast<int>(windowSize_));
+    std::vector<SlidingWindow::Sample> samples(count - first);
+    for (int i = first; i < count; ++i) {
+        SlidingWindow::Sample& sample = samples[i - first];
+        sample.timestamp = batch.timestamps_us(i) / 1000;
+        sample.values = {batch.temperature(i), batch.humidity(i), batch.pressure(i)};
     }
-    
-    std::cout << "[Algorithm] Received sensor data from " << sensorData.sensor_id() 
-              << " (buffer size: " << sensorDataBuffer_.size() << ")" << std::endl;
-    
-    // 如果有足够的数据，进行处理
-    if (sensorDataBuffer_.size() >= 3) {
-        AlgorithmResult result = processData();
-        std::string serializedResult = result.SerializeAsString();
-        //broadcast("algorithm.result", serializedResult);
-        
-        std::cout << "[Algorithm] Processed data - Comfort Index: " << result.comfort_index() 
-                  << ", Alert: " << result.alert_level() << std::endl;
+    workers_->submit(batch.sensor_id(), std::move(samples));
+}
+
+void Algorithm::emitResults(const RecordBatch& batch) {
+    // 同一个键的记录总在同一线程上产生（工作线程按 sensor_id 分片，或单线程阶段），状态按线程保存；
+    // 按键的地址索引，依赖 WindowRecord::key 指向的字符串在运行期间不搬移（见 Pipeline.h）
+    struct KeyState {
+        ResultDeadband::State publish;
+        std::chrono::steady_clock::time_point lastReport;
+        std::chrono::steady_clock::time_point lastSeen;
+    };
+    thread_local AlgorithmResult result;
+    thread_local std::unordered_map<const std::string*, KeyState> keys;
+    thread_local std::chrono::steady_clock::time_point lastPrune = std::chrono::steady_clock::now();
+    // 同一批结果共用一个时间戳
+    auto now = std::chrono::steady_clock::now();
+    int64_t timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    // 定期清理长时间没有结果的键，停止发送的传感器不会一直占用状态；之后再出现时按首个结果发布
+    if (now - lastPrune >= KEY_PRUNE_INTERVAL) {
+        lastPrune = now;
+        for (auto it = keys.begin(); it != keys.end();) {
+            it = now - it->second.lastSeen >= KEY_IDLE_TIMEOUT ? keys.erase(it) : std::next(it);
+        }
+    }
+
+    for (const WindowRecord& record : batch) {
+        KeyState& key = keys[record.key];
+        key.lastSeen = now;
+        ResultDeadband::Decision decision = deadband_.evaluate(key.publish, record.comfortIndex, record.alert, record.late, now);
+        publishCounts_[static_cast<size_t>(decision)].fetch_add(1, std::memory_order_relaxed);
+        // 每个传感器（或聚合分组）每秒最多输出一次，高速或大量传感器时不会刷屏
+        bool report = now - key.lastReport >= REPORT_INTERVAL;
+        if (decision == ResultDeadband::Decision::SUPPRESS && !report) {
+            continue;
+        }
+
+        results_.fill(record, timestampMs, result);
+        if (decision != ResultDeadband::Decision::SUPPRESS) {
+            publish<AlgorithmResultTopic>(result, *record.key);
+        }
+
+        if (report) {
+            key.lastReport = now;
+            std::cout << "[Algorithm] " << *record.key << " (" << record.samples << " samples, window ";
+            if (eventTimeEnabled_) {
+                std::cout << "[" << result.window_start() << ", " << result.window_end() << ") "
+                          << result.sample_count() << (result.late_update() ? " late" : "")
+                          << ", watermark " << record.watermark << ", dropped " << record.dropped;
+            } else {
+                std::cout << result.sample_count();
+            }
+            std::cout << ") - Comfort Index: " << result.comfort_index() << ", Alert: " << result.alert_level() << std::endl;
+        }
     }
 }
 
-AlgorithmResult Algorithm::processData() {
-    // 计算平均值
-    double avgTemp = 0, avgHumidity = 0, avgPressure = 0;
-    for (const auto& data : sensorDataBuffer_) {
-        avgTemp += data.temperature();
-        avgHumidity += data.humidity();
-        avgPressure += data.pressure();
+void Algorithm::publishAnomalies(const std::string& sensorId, SensorWorkerPool::SensorState& state) {
+    thread_local AnomalyEvent event;
+    auto now = std::chrono::steady_clock::now();
+    bool report = now - state.lastAnomalyReport >= REPORT_INTERVAL;
+
+    for (const AnomalyDetector::Event& anomaly : state.anomalies) {
+        event.mutable_sensor_id()->assign(sensorId);
+        event.set_metric(static_cast<SensorMetric>(anomaly.channel));
+        event.set_kind(static_cast<AnomalyKind>(anomaly.kind));
+        event.set_value(anomaly.value);
+        event.set_baseline_mean(anomaly.mean);
+        event.set_baseline_stddev(anomaly.stddev);
+        event.set_score(anomaly.score);
+        event.set_timestamp(anomaly.timestamp);
+        publish<AlgorithmAnomalyTopic>(event, sensorId);
+
+        // 同一传感器每秒最多打印一条异常日志
+        if (report) {
+            report = false;
+            state.lastAnomalyReport = now;
+            std::cout << "[Algorithm] Anomaly " << sensorId << " " << SensorMetric_Name(event.metric()) << " "
+                      << AnomalyDetector::kindName(anomaly.kind) << ": value " << anomaly.value << ", baseline "
+                      << anomaly.mean << " +/- " << anomaly.stddev << ", score " << anomaly.score << std::endl;
+        }
     }
-    
-    avgTemp /= sensorDataBuffer_.size();
-    avgHumidity /= sensorDataBuffer_.size();
-    avgPressure /= sensorDataBuffer_.size();
-    
-    double comfortIndex = calculateComfortIndex(avgTemp, avgHumidity, avgPressure);
-    std::string alertLevel = determineAlertLevel(comfortIndex);
-    std::string recommendation = generateRecommendation(comfortIndex, alertLevel);
-    
-    AlgorithmResult result;
-    result.set_result_id("RESULT_" + std::to_string(std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count()));
-    result.set_comfort_index(comfortIndex);
-    result.set_alert_level(alertLevel);
-    result.set_recommendation(recommendation);
-    result.set_timestamp(std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::system_clock::now().time_since_epoch()).count());
-    result.set_avg_temperature(avgTemp);
-    result.set_avg_humidity(avgHumidity);
-    result.set_avg_pressure(avgPressure);
-    
-    return result;
+    anomalyCount_.fetch_add(state.anomalies.size(), std::memory_order_relaxed);
+    state.anomalies.clear();
 }
 
 double Algorithm::calculateComfortIndex(double temp, double humidity, double pressure) {
-    // 简单的舒适度计算算法
-    double tempScore = 100 - std::abs(temp - 22.0) * 4; // 22°C为最佳温度
-    double humidityScore = 100 - std::abs(humidity - 50.0) * 2; // 50%为最佳湿度
-    double pressureScore = 100 - std::abs(pressure - 1013.25) * 0.1; // 标准大气压
-    
-    // 权重计算
-    double comfortIndex = (tempScore * 0.5 + humidityScore * 0.3 + pressureScore * 0.2);
-    return std::max(0.0, std::min(100.0, comfortIndex));
+    // 公式定义在 ComfortKernel 中，单样本与批量计算结果逐位一致
+    return ComfortKernel::scoreOne(temp, humidity, pressure);
 }
 
-std::string Algorithm::determineAlertLevel(double comfortIndex) {
-    if (comfortIndex >= 80) return "GOOD";
-    if (comfortIndex >= 60) return "MODERATE";
-    if (comfortIndex >= 40) return "POOR";
-    return "CRITICAL";
+AlertLevel Algorithm::determineAlertLevel(double comfortIndex) {
+    return static_cast<AlertLevel>(ComfortKernel::alertOf(comfortIndex));
 }
 
-std::string Algorithm::generateRecommendation(double comfortIndex, const std::string& alertLevel) {
-    if (alertLevel == "GOOD") {
-        return "Environment conditions are optimal";
-    } else if (alertLevel == "MODERATE") {
-        return "Consider adjusting temperature or humidity";
-    } else if (alertLevel == "POOR") {
-        return "Environmental conditions need attention";
-    } else {
-        return "Immediate action required - check HVAC system";
-    }
+const char* Algorithm::alertLevelName(AlertLevel level) {
+    return ResultBuilder::alertLevelName(level);
+}
+
+const char* Algorithm::generateRecommendation(AlertLevel level) {
+    return ResultBuilder::recommendation(level);
 }
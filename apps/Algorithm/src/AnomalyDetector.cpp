@@ -0,0 +1,85 @@
+// AnomalyDetector.cpp
+#include "AnomalyDetector.h"
+#include "StateCodec.h"
+#include <algorithm>
+#include <cmath>
+
+AnomalyDetector::AnomalyDetector(const Options& options)
+    : options_(&options),
+      ewmaLimit_(options.ewmaL * std::sqrt(options.ewmaLambda / (2.0 - options.ewmaLambda))) {}
+
+void AnomalyDetector::update(const SlidingWindow& window, const SlidingWindow::Sample& sample,
+                             std::vector<Event>& events) {
+    const Options& options = *options_;
+    size_t warmup = std::max<size_t>(2, std::min(options.warmup, window.capacity()));
+    if (!options.enabled || window.size() < warmup) {
+        return;
+    }
+
+    for (size_t c = 0; c < SlidingWindow::CHANNEL_COUNT; ++c) {
+        auto channel = static_cast<SlidingWindow::Channel>(c);
+        ChannelState& state = channels_[c];
+        double value = sample.values[c];
+        double mean = window.mean(channel);
+        double stddev = std::max(std::sqrt(window.variance(channel)), options.minStddev);
+        double z = (value - mean) / stddev;
+        if (!std::isfinite(z)) {
+            continue;
+        }
+
+        bool zOut = std::fabs(z) > options.zThreshold;
+        if (zOut && !state.zActive) {
+            events.push_back(Event{sample.timestamp, channel, ZSCORE, value, mean, stddev, z});
+        }
+        state.zActive = zOut;
+
+        state.cusumHigh = std::max(0.0, state.cusumHigh + z - options.cusumK);
+        state.cusumLow = std::max(0.0, state.cusumLow - z - options.cusumK);
+        if (state.cusumHigh > options.cusumH) {
+            events.push_back(Event{sample.timestamp, channel, CUSUM_HIGH, value, mean, stddev, state.cusumHigh});
+            state.cusumHigh = 0;
+        }
+        if (state.cusumLow > options.cusumH) {
+            events.push_back(Event{sample.timestamp, channel, CUSUM_LOW, value, mean, stddev, -state.cusumLow});
+            state.cusumLow = 0;
+        }
+
+        state.ewma += options.ewmaLambda * (z - state.ewma);
+        bool ewmaOut = std::fabs(state.ewma) > ewmaLimit_;
+        if (ewmaOut && !state.ewmaActive) {
+            events.push_back(Event{sample.timestamp, channel, EWMA, value, mean, stddev, state.ewma});
+        }
+        state.ewmaActive = ewmaOut;
+    }
+}
+
+const char* AnomalyDetector::kindName(Kind kind) {
+    switch (kind) {
+        case ZSCORE: return "zscore";
+        case CUSUM_HIGH: return "cusum_high";
+        case CUSUM_LOW: return "cusum_low";
+        case EWMA: return "ewma";
+    }
+    return "unknown";
+}
+
+void AnomalyDetector::save(StateWriter& writer) const {
+    // 逐字段写入，不带结构体填充字节
+    for (const ChannelState& channel : channels_) {
+        writer.write(channel.cusumHigh);
+        writer.write(channel.cusumLow);
+        writer.write(channel.ewma);
+        writer.write(channel.zActive);
+        writer.write(channel.ewmaActive);
+    }
+}
+
+bool AnomalyDetector::load(StateReader& reader) {
+    for (ChannelState& channel : channels_) {
+        if (!reader.read(channel.cusumHigh) || !reader.read(channel.cusumLow) || !reader.read(channel.ewma) ||
+            !reader.read(channel.zActive) || !reader.read(channel.ewmaActive)) {
+            return false;
+        }
+    }
+    return true;
+}
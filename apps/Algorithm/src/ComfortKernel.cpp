@@ -0,0 +1,289 @@
+// ComfortKernel.cpp
+// 本文件需以 -ffp-contract=off 编译（见 CMakeLists.txt），否则编译器可能把乘加合并为 FMA，破坏逐位一致
+#include "ComfortKernel.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define COMFORT_KERNEL_X86 1
+#endif
+
+namespace
+{
+    // 舒适度公式常量：22°C、50%、标准大气压为最佳值
+    constexpr double BEST_TEMPERATURE = 22.0;
+    constexpr double BEST_HUMIDITY = 50.0;
+    constexpr double BEST_PRESSURE = 1013.25;
+    constexpr double TEMPERATURE_PENALTY = 4;
+    constexpr double HUMIDITY_PENALTY = 2;
+    constexpr double PRESSURE_PENALTY = 0.1;
+    constexpr double TEMPERATURE_WEIGHT = 0.5;
+    constexpr double HUMIDITY_WEIGHT = 0.3;
+    constexpr double PRESSURE_WEIGHT = 0.2;
+    constexpr double GOOD_THRESHOLD = 80;
+    constexpr double MODERATE_THRESHOLD = 60;
+    constexpr double POOR_THRESHOLD = 40;
+
+    // -1 表示尚未选择
+    std::atomic<int> selectedIsa{-1};
+
+    void scoreScalar(const double* temperature, const double* humidity, const double* pressure,
+                     size_t count, double* index, uint8_t* alert) {
+        for (size_t i = 0; i < count; ++i) {
+            index[i] = ComfortKernel::scoreOne(temperature[i], humidity[i], pressure[i]);
+            if (alert) {
+                alert[i] = ComfortKernel::alertOf(index[i]);
+            }
+        }
+    }
+
+#ifdef COMFORT_KERNEL_X86
+    // 由三个阈值比较结果得到等级：满足的阈值越多等级越好
+    inline uint8_t alertFromMasks(int good, int moderate, int poor, int lane) {
+        return static_cast<uint8_t>(3 - ((good >> lane) & 1) - ((moderate >> lane) & 1) - ((poor >> lane) & 1));
+    }
+
+    __attribute__((target("sse2")))
+    void scoreSse2(const double* temperature, const double* humidity, const double* pressure,
+                   size_t count, double* index, uint8_t* alert) {
+        const __m128d signMask = _mm_set1_pd(-0.0);
+        const __m128d hundred = _mm_set1_pd(100.0);
+        const __m128d zero = _mm_setzero_pd();
+
+        size_t i = 0;
+        for (; i + 2 <= count; i += 2) {
+            __m128d t = _mm_loadu_pd(temperature + i);
+            __m128d h = _mm_loadu_pd(humidity + i);
+            __m128d p = _mm_loadu_pd(pressure + i);
+
+            __m128d tempScore = _mm_sub_pd(hundred, _mm_mul_pd(
+                _mm_andnot_pd(signMask, _mm_sub_pd(t, _mm_set1_pd(BEST_TEMPERATURE))), _mm_set1_pd(TEMPERATURE_PENALTY)));
+            __m128d humidityScore = _mm_sub_pd(hundred, _mm_mul_pd(
+                _mm_andnot_pd(signMask, _mm_sub_pd(h, _mm_set1_pd(BEST_HUMIDITY))), _mm_set1_pd(HUMIDITY_PENALTY)));
+            __m128d pressureScore = _mm_sub_pd(hundred, _mm_mul_pd(
+                _mm_andnot_pd(signMask, _mm_sub_pd(p, _mm_set1_pd(BEST_PRESSURE))), _mm_set1_pd(PRESSURE_PENALTY)));
+
+            __m128d ci = _mm_add_pd(_mm_add_pd(_mm_mul_pd(tempScore, _mm_set1_pd(TEMPERATURE_WEIGHT)),
+                                               _mm_mul_pd(humidityScore, _mm_set1_pd(HUMIDITY_WEIGHT))),
+                                    _mm_mul_pd(pressureScore, _mm_set1_pd(PRESSURE_WEIGHT)));
+            // 与 std::max(0.0, std::min(100.0, ci)) 相同，NaN 得到 100
+            ci = _mm_max_pd(_mm_min_pd(ci, hundred), zero);
+            _mm_storeu_pd(index + i, ci);
+
+            if (alert) {
+                int good = _mm_movemask_pd(_mm_cmpge_pd(ci, _mm_set1_pd(GOOD_THRESHOLD)));
+                int moderate = _mm_movemask_pd(_mm_cmpge_pd(ci, _mm_set1_pd(MODERATE_THRESHOLD)));
+                int poor = _mm_movemask_pd(_mm_cmpge_pd(ci, _mm_set1_pd(POOR_THRESHOLD)));
+                for (int lane = 0; lane < 2; ++lane) {
+                    alert[i + lane] = alertFromMasks(good, moderate, poor, lane);
+                }
+            }
+        }
+        scoreScalar(temperature + i, humidity + i, pressure + i, count - i, index + i, alert ? alert + i : nullptr);
+    }
+
+    __attribute__((target("avx2")))
+    void scoreAvx2(const double* temperature, const double* humidity, const double* pressure,
+                   size_t count, double* index, uint8_t* alert) {
+        const __m256d signMask = _mm256_set1_pd(-0.0);
+        const __m256d hundred = _mm256_set1_pd(100.0);
+        const __m256d zero = _mm256_setzero_pd();
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            __m256d t = _mm256_loadu_pd(temperature + i);
+            __m256d h = _mm256_loadu_pd(humidity + i);
+            __m256d p = _mm256_loadu_pd(pressure + i);
+
+            __m256d tempScore = _mm256_sub_pd(hundred, _mm256_mul_pd(
+                _mm256_andnot_pd(signMask, _mm256_sub_pd(t, _mm256_set1_pd(BEST_TEMPERATURE))),
+                _mm256_set1_pd(TEMPERATURE_PENALTY)));
+            __m256d humidityScore = _mm256_sub_pd(hundred, _mm256_mul_pd(
+                _mm256_andnot_pd(signMask, _mm256_sub_pd(h, _mm256_set1_pd(BEST_HUMIDITY))),
+                _mm256_set1_pd(HUMIDITY_PENALTY)));
+            __m256d pressureScore = _mm256_sub_pd(hundred, _mm256_mul_pd(
+                _mm256_andnot_pd(signMask, _mm256_sub_pd(p, _mm256_set1_pd(BEST_PRESSURE))),
+                _mm256_set1_pd(PRESSURE_PENALTY)));
+
+            __m256d ci = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(tempScore, _mm256_set1_pd(TEMPERATURE_WEIGHT)),
+                                                     _mm256_mul_pd(humidityScore, _mm256_set1_pd(HUMIDITY_WEIGHT))),
+                                       _mm256_mul_pd(pressureScore, _mm256_set1_pd(PRESSURE_WEIGHT)));
+            ci = _mm256_max_pd(_mm256_min_pd(ci, hundred), zero);
+            _mm256_storeu_pd(index + i, ci);
+
+            if (alert) {
+                int good = _mm256_movemask_pd(_mm256_cmp_pd(ci, _mm256_set1_pd(GOOD_THRESHOLD), _CMP_GE_OQ));
+                int moderate = _mm256_movemask_pd(_mm256_cmp_pd(ci, _mm256_set1_pd(MODERATE_THRESHOLD), _CMP_GE_OQ));
+                int poor = _mm256_movemask_pd(_mm256_cmp_pd(ci, _mm256_set1_pd(POOR_THRESHOLD), _CMP_GE_OQ));
+                for (int lane = 0; lane < 4; ++lane) {
+                    alert[i + lane] = alertFromMasks(good, moderate, poor, lane);
+                }
+            }
+        }
+        scoreScalar(temperature + i, humidity + i, pressure + i, count - i, index + i, alert ? alert + i : nullptr);
+    }
+#endif
+
+    ComfortKernel::Isa bestIsa() {
+        const char* forced = std::getenv("COMFORT_KERNEL_ISA");
+        if (forced) {
+            std::string name = forced;
+            for (ComfortKernel::Isa isa : {ComfortKernel::Isa::Scalar, ComfortKernel::Isa::SSE2, ComfortKernel::Isa::AVX2}) {
+                if (name == ComfortKernel::isaName(isa)) {
+                    if (ComfortKernel::isSupported(isa)) {
+                        return isa;
+                    }
+                    std::cerr << "[ComfortKernel] " << name << " not supported by this CPU, ignoring override" << std::endl;
+                }
+            }
+        }
+        if (ComfortKernel::isSupported(ComfortKernel::Isa::AVX2)) {
+            return ComfortKernel::Isa::AVX2;
+        }
+        if (ComfortKernel::isSupported(ComfortKernel::Isa::SSE2)) {
+            return ComfortKernel::Isa::SSE2;
+        }
+        return ComfortKernel::Isa::Scalar;
+    }
+}
+
+double ComfortKernel::scoreOne(double temperature, double humidity, double pressure) {
+    double tempScore = 100 - std::abs(temperature - BEST_TEMPERATURE) * TEMPERATURE_PENALTY;
+    double humidityScore = 100 - std::abs(humidity - BEST_HUMIDITY) * HUMIDITY_PENALTY;
+    double pressureScore = 100 - std::abs(pressure - BEST_PRESSURE) * PRESSURE_PENALTY;
+
+    double comfortIndex = (tempScore * TEMPERATURE_WEIGHT + humidityScore * HUMIDITY_WEIGHT + pressureScore * PRESSURE_WEIGHT);
+    return std::max(0.0, std::min(100.0, comfortIndex));
+}
+
+ComfortKernel::Alert ComfortKernel::alertOf(double index) {
+    if (index >= GOOD_THRESHOLD) return ALERT_GOOD;
+    if (index >= MODERATE_THRESHOLD) return ALERT_MODERATE;
+    if (index >= POOR_THRESHOLD) return ALERT_POOR;
+    return ALERT_CRITICAL;
+}
+
+const char* ComfortKernel::alertName(Alert alert) {
+    switch (alert) {
+        case ALERT_GOOD: return "GOOD";
+        case ALERT_MODERATE: return "MODERATE";
+        case ALERT_POOR: return "POOR";
+        case ALERT_CRITICAL: return "CRITICAL";
+    }
+    return "CRITICAL";
+}
+
+void ComfortKernel::score(const double* temperature, const double* humidity, const double* pressure,
+                          size_t count, double* index, uint8_t* alert) {
+    scoreWith(activeIsa(), temperature, humidity, pressure, count, index, alert);
+}
+
+void ComfortKernel::scoreWith(Isa isa, const double* temperature, const double* humidity, const double* pressure,
+                              size_t count, double* index, uint8_t* alert) {
+    switch (isa) {
+#ifdef COMFORT_KERNEL_X86
+        case Isa::AVX2:
+            scoreAvx2(temperature, humidity, pressure, count, index, alert);
+            return;
+        case Isa::SSE2:
+            scoreSse2(temperature, humidity, pressure, count, index, alert);
+            return;
+#endif
+        default:
+            scoreScalar(temperature, humidity, pressure, count, index, alert);
+            return;
+    }
+}
+
+ComfortKernel::Isa ComfortKernel::activeIsa() {
+    int isa = selectedIsa.load(std::memory_order_relaxed);
+    if (isa < 0) {
+        isa = static_cast<int>(bestIsa());
+        selectedIsa.store(isa, std::memory_order_relaxed);
+    }
+    return static_cast<Isa>(isa);
+}
+
+bool ComfortKernel::isSupported(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar:
+            return true;
+#ifdef COMFORT_KERNEL_X86
+        case Isa::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case Isa::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+const char* ComfortKernel::isaName(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar: return "scalar";
+        case Isa::SSE2: return "sse2";
+        case Isa::AVX2: return "avx2";
+    }
+    return "scalar";
+}
+
+bool ComfortKernel::selfTest() {
+    Isa isa = activeIsa();
+    if (isa == Isa::Scalar) {
+        return true;
+    }
+
+    // 边界值：最佳点、阈值附近、符号零、无穷、NaN、非规格化数，再补充正常范围和超范围的随机值
+    const double inf = std::numeric_limits<double>::infinity();
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double denormal = std::numeric_limits<double>::denorm_min();
+    std::vector<double> specials = {0.0, -0.0, 22.0, 50.0, 1013.25, 17.0, 27.0, 12.0, 32.0, -40.0, 85.0,
+                                    1e300, -1e300, inf, -inf, nan, denormal, -denormal, 0.1, 99.99};
+    std::vector<double> temperature, humidity, pressure;
+    for (double a : specials) {
+        for (double b : {a, 50.0, 0.0, nan}) {
+            for (double c : {a, 1013.25, 980.0, inf}) {
+                temperature.push_back(a);
+                humidity.push_back(b);
+                pressure.push_back(c);
+            }
+        }
+    }
+    std::mt19937_64 gen(20240601);
+    std::uniform_real_distribution<> tempDis(-20.0, 60.0);
+    std::uniform_real_distribution<> humidityDis(0.0, 100.0);
+    std::uniform_real_distribution<> pressureDis(900.0, 1100.0);
+    for (int i = 0; i < 4099; ++i) {
+        temperature.push_back(tempDis(gen));
+        humidity.push_back(humidityDis(gen));
+        pressure.push_back(pressureDis(gen));
+    }
+
+    size_t count = temperature.size();
+    std::vector<double> expected(count), actual(count);
+    std::vector<uint8_t> expectedAlert(count), actualAlert(count);
+    scoreWith(Isa::Scalar, temperature.data(), humidity.data(), pressure.data(), count,
+              expected.data(), expectedAlert.data());
+    scoreWith(isa, temperature.data(), humidity.data(), pressure.data(), count, actual.data(), actualAlert.data());
+
+    for (size_t i = 0; i < count; ++i) {
+        if (std::memcmp(&expected[i], &actual[i], sizeof(double)) != 0 || expectedAlert[i] != actualAlert[i]) {
+            std::cerr << "[ComfortKernel] " << isaName(isa) << " differs from scalar at (" << temperature[i] << ", "
+                      << humidity[i] << ", " << pressure[i] << "): " << actual[i] << " vs " << expected[i]
+                      << ", falling back to scalar" << std::endl;
+            selectedIsa.store(static_cast<int>(Isa::Scalar), std::memory_order_relaxed);
+            return false;
+        }
+    }
+    return true;
+}
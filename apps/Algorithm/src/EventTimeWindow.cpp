@@ -0,0 +1,213 @@
+// EventTimeWindow.cpp
+#include "EventTimeWindow.h"
+#include "StateCodec.h"
+#include <algorithm>
+#include <limits>
+
+void EventTimeWindow::Options::normalize() {
+    slideMs = std::max<int64_t>(1, slideMs);
+    sizeMs = std::max(sizeMs, slideMs);
+    sizeMs = (sizeMs + slideMs - 1) / slideMs * slideMs;
+    maxDelayMs = std::max<int64_t>(0, maxDelayMs);
+    allowedLatenessMs = std::max<int64_t>(0, allowedLatenessMs);
+}
+
+void EventTimeWindow::Aggregate::add(const SlidingWindow::Sample& sample) {
+    for (size_t c = 0; c < SlidingWindow::CHANNEL_COUNT; ++c) {
+        double value = sample.values[c];
+        sum[c] += value;
+        min[c] = count == 0 ? value : std::min(min[c], value);
+        max[c] = count == 0 ? value : std::max(max[c], value);
+    }
+    ++count;
+}
+
+void EventTimeWindow::Aggregate::merge(const Aggregate& other) {
+    if (other.count == 0) {
+        return;
+    }
+    for (size_t c = 0; c < SlidingWindow::CHANNEL_COUNT; ++c) {
+        sum[c] += other.sum[c];
+        min[c] = count == 0 ? other.min[c] : std::min(min[c], other.min[c]);
+        max[c] = count == 0 ? other.max[c] : std::max(max[c], other.max[c]);
+    }
+    count += other.count;
+}
+
+EventTimeWindow::EventTimeWindow(const Options& options)
+    : options_(&options),
+      panesPerWindow_(options.sizeMs / options.slideMs),
+      watermark_(std::numeric_limits<int64_t>::min()),
+      maxTimestamp_(std::numeric_limits<int64_t>::min()),
+      firstPane_(0),
+      nextWindow_(0),
+      started_(false),
+      paneHead_(0),
+      paneCount_(0),
+      dropped_(0),
+      late_(0) {}
+
+int64_t EventTimeWindow::floorDiv(int64_t value, int64_t divisor) {
+    int64_t quotient = value / divisor;
+    if (value % divisor != 0 && (value < 0) != (divisor < 0)) {
+        --quotient;
+    }
+    return quotient;
+}
+
+EventTimeWindow::Aggregate* EventTimeWindow::pane(int64_t index) {
+    if (index < firstPane_) {
+        return nullptr;
+    }
+    size_t needed = static_cast<size_t>(index - firstPane_) + 1;
+    if (needed > panes_.size()) {
+        // 按 2 的幂扩容并把现有桶按顺序搬到开头
+        size_t capacity = std::max<size_t>(8, panes_.size());
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+        std::vector<Aggregate> grown(capacity);
+        for (size_t i = 0; i < paneCount_; ++i) {
+            grown[i] = panes_[(paneHead_ + i) & (panes_.size() - 1)];
+        }
+        panes_.swap(grown);
+        paneHead_ = 0;
+    }
+    paneCount_ = std::max(paneCount_, needed);
+    return &panes_[(paneHead_ + needed - 1) & (panes_.size() - 1)];
+}
+
+const EventTimeWindow::Aggregate* EventTimeWindow::pane(int64_t index) const {
+    if (index < firstPane_ || index >= firstPane_ + static_cast<int64_t>(paneCount_)) {
+        return nullptr;
+    }
+    return &panes_[(paneHead_ + static_cast<size_t>(index - firstPane_)) & (panes_.size() - 1)];
+}
+
+EventTimeWindow::Accept EventTimeWindow::push(const SlidingWindow::Sample& sample, std::vector<Result>& results) {
+    const Options& options = *options_;
+    int64_t timestamp = sample.timestamp;
+
+    if (!started_) {
+        // 首个样本之前的窗口视为已关闭；保留足以接受 max_delay 内乱序样本的桶
+        started_ = true;
+        maxTimestamp_ = timestamp;
+        watermark_ = timestamp - options.maxDelayMs;
+        firstPane_ = floorDiv(watermark_ - options.allowedLatenessMs, options.slideMs) - panesPerWindow_ + 1;
+        nextWindow_ = floorDiv(watermark_, options.slideMs);
+    } else if (timestamp > maxTimestamp_) {
+        // 先推进水位线再写入：新样本所在窗口的结束时间一定晚于新水位线，不会被提前关闭
+        maxTimestamp_ = timestamp;
+        advanceWatermark(timestamp - options.maxDelayMs, results);
+    }
+
+    int64_t index = floorDiv(timestamp, options.slideMs);
+    Aggregate* target = pane(index);
+    if (!target) {
+        ++dropped_;
+        return Accept::DROPPED;
+    }
+    target->add(sample);
+
+    if (index >= nextWindow_) {
+        return Accept::ON_TIME;
+    }
+
+    // 包含该桶且已关闭的窗口中，仍在 allowed_lateness 内的重新输出
+    ++late_;
+    int64_t lastClosed = std::min(index + panesPerWindow_ - 1, nextWindow_ - 1);
+    for (int64_t window = index; window <= lastClosed; ++window) {
+        if ((window + 1) * options.slideMs + options.allowedLatenessMs > watermark_) {
+            emitWindow(window, true, results);
+        }
+    }
+    return Accept::LATE;
+}
+
+void EventTimeWindow::advanceWatermark(int64_t watermark, std::vector<Result>& results) {
+    const Options& options = *options_;
+    watermark_ = watermark;
+
+    // 关闭结束时间不晚于水位线的窗口；之后的窗口不再包含任何已有的桶时直接跳过（长时间断线后重连）
+    int64_t lastPane = firstPane_ + static_cast<int64_t>(paneCount_) - 1;
+    while ((nextWindow_ + 1) * options.slideMs <= watermark) {
+        if (nextWindow_ - panesPerWindow_ + 1 > lastPane) {
+            nextWindow_ = std::max(nextWindow_, floorDiv(watermark, options.slideMs));
+            break;
+        }
+        emitWindow(nextWindow_, false, results);
+        ++nextWindow_;
+    }
+
+    // 淘汰所有包含它的窗口都已超过 allowed_lateness 的桶
+    int64_t minPane = floorDiv(watermark - options.allowedLatenessMs, options.slideMs) - panesPerWindow_ + 1;
+    while (paneCount_ > 0 && firstPane_ < minPane) {
+        panes_[paneHead_] = Aggregate();
+        paneHead_ = (paneHead_ + 1) & (panes_.size() - 1);
+        --paneCount_;
+        ++firstPane_;
+    }
+    if (paneCount_ == 0) {
+        firstPane_ = std::max(firstPane_, minPane);
+    }
+}
+
+void EventTimeWindow::emitWindow(int64_t lastPane, bool late, std::vector<Result>& results) const {
+    Result result;
+    result.start = (lastPane - panesPerWindow_ + 1) * options_->slideMs;
+    result.end = (lastPane + 1) * options_->slideMs;
+    result.late = late;
+    for (int64_t index = lastPane - panesPerWindow_ + 1; index <= lastPane; ++index) {
+        if (const Aggregate* source = pane(index)) {
+            result.aggregate.merge(*source);
+        }
+    }
+    if (result.aggregate.count > 0) {
+        results.push_back(result);
+    }
+}
+
+void EventTimeWindow::save(StateWriter& writer) const {
+    const Options& options = *options_;
+    writer.write(options.sizeMs);
+    writer.write(options.slideMs);
+    writer.write(options.maxDelayMs);
+    writer.write(options.allowedLatenessMs);
+    writer.write(watermark_);
+    writer.write(maxTimestamp_);
+    writer.write(firstPane_);
+    writer.write(nextWindow_);
+    writer.write(started_);
+    writer.write(dropped_);
+    writer.write(late_);
+    writer.write(static_cast<uint64_t>(paneCount_));
+    for (size_t i = 0; i < paneCount_; ++i) {
+        writer.write(panes_[(paneHead_ + i) & (panes_.size() - 1)]);
+    }
+}
+
+bool EventTimeWindow::load(StateReader& reader) {
+    const Options& options = *options_;
+    Options saved;
+    uint64_t paneCount = 0;
+    if (!reader.read(saved.sizeMs) || !reader.read(saved.slideMs) || !reader.read(saved.maxDelayMs) ||
+        !reader.read(saved.allowedLatenessMs) || saved.sizeMs != options.sizeMs || saved.slideMs != options.slideMs ||
+        saved.maxDelayMs != options.maxDelayMs || saved.allowedLatenessMs != options.allowedLatenessMs ||
+        !reader.read(watermark_) || !reader.read(maxTimestamp_) || !reader.read(firstPane_) ||
+        !reader.read(nextWindow_) || !reader.read(started_) || !reader.read(dropped_) || !reader.read(late_) ||
+        !reader.read(paneCount) || paneCount > reader.remaining() / sizeof(Aggregate)) {
+        return reader.fail();
+    }
+
+    size_t capacity = 8;
+    while (capacity < paneCount) {
+        capacity *= 2;
+    }
+    panes_.assign(capacity, Aggregate());
+    paneHead_ = 0;
+    paneCount_ = static_cast<size_t>(paneCount);
+    for (size_t i = 0; i < paneCount_; ++i) {
+        reader.read(panes_[i]);
+    }
+    return reader.ok();
+}
@@ -0,0 +1,702 @@
+// Pipeline.cpp
+#include "Pipeline.h"
+#include "ComfortKernel.h"
+#include "ThreadPlacement.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <unordered_map>
+
+namespace {
+
+constexpr size_t COMFORT_INDEX = SlidingWindow::CHANNEL_COUNT;
+
+// "metric": "temperature" | "humidity" | "pressure" | "comfort_index"
+bool parseMetric(const Pipeline::OperatorConfig& config, bool allowComfortIndex, size_t& metric, std::string& error) {
+    const rapidjson::Value* params = config.params;
+    if (!params || !params->HasMember("metric") || !(*params)["metric"].IsString()) {
+        error = "missing \"metric\"";
+        return false;
+    }
+    std::string name = (*params)["metric"].GetString();
+    if (name == "temperature") {
+        metric = SlidingWindow::TEMPERATURE;
+    } else if (name == "humidity") {
+        metric = SlidingWindow::HUMIDITY;
+    } else if (name == "pressure") {
+        metric = SlidingWindow::PRESSURE;
+    } else if (name == "comfort_index" && allowComfortIndex) {
+        metric = COMFORT_INDEX;
+    } else {
+        error = "unsupported metric \"" + name + "\"";
+        return false;
+    }
+    return true;
+}
+
+double numberOr(const rapidjson::Value* params, const char* key, double defaultValue) {
+    if (params && params->HasMember(key) && (*params)[key].IsNumber()) {
+        return (*params)[key].GetDouble();
+    }
+    return defaultValue;
+}
+
+// 丢弃指标不在 [min, max] 内的样本或窗口记录（NaN 同样丢弃）
+class FilterOperator : public PipelineOperator {
+public:
+    FilterOperator(size_t metric, double min, double max) : metric_(metric), min_(min), max_(max) {}
+
+    bool processSample(SlidingWindow::Sample& sample) override {
+        double value = sample.values[metric_];
+        return value >= min_ && value <= max_;
+    }
+
+    void processBatch(RecordBatch& batch) override {
+        batch.erase(std::remove_if(batch.begin(), batch.end(), [this](const WindowRecord& record) {
+            double value = metric_ == COMFORT_INDEX ? record.comfortIndex : record.mean[metric_];
+            return !(value >= min_ && value <= max_);
+        }), batch.end());
+    }
+
+private:
+    size_t metric_;
+    double min_;
+    double max_;
+};
+
+// 线性变换 value * scale + offset（单位换算、传感器校准）；窗口记录的统计量一并变换。
+// 负的 scale 会把 p95 / p99 变成 p5 / p1，记录中没有对应的分位数，因此启用统计时窗口之后只接受非负 scale
+class MapOperator : public PipelineOperator {
+public:
+    MapOperator(size_t metric, double scale, double offset) : metric_(metric), scale_(scale), offset_(offset) {}
+
+    bool processSample(SlidingWindow::Sample& sample) override {
+        sample.values[metric_] = sample.values[metric_] * scale_ + offset_;
+        return true;
+    }
+
+    void processBatch(RecordBatch& batch) override {
+        for (WindowRecord& record : batch) {
+            record.mean[metric_] = apply(record.mean[metric_]);
+            double low = apply(record.min[metric_]);
+            double high = apply(record.max[metric_]);
+            record.min[metric_] = std::min(low, high);
+            record.max[metric_] = std::max(low, high);
+
+            MetricSnapshot& stats = record.stats[metric_];
+            stats.ewma = apply(stats.ewma);
+            stats.stddev *= std::abs(scale_);
+            for (double& quantile : stats.quantiles) {
+                quantile = apply(quantile);
+            }
+        }
+    }
+
+private:
+    double apply(double value) const { return value * scale_ + offset_; }
+
+    size_t metric_;
+    double scale_;
+    double offset_;
+};
+
+// 对整批记录调用一次 ComfortKernel 批量评分
+class ScoreOperator : public PipelineOperator {
+public:
+    void processBatch(RecordBatch& batch) override {
+        size_t count = batch.size();
+        temperature_.resize(count);
+        humidity_.resize(count);
+        pressure_.resize(count);
+        comfortIndex_.resize(count);
+        alerts_.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            temperature_[i] = batch[i].mean[SlidingWindow::TEMPERATURE];
+            humidity_[i] = batch[i].mean[SlidingWindow::HUMIDITY];
+            pressure_[i] = batch[i].mean[SlidingWindow::PRESSURE];
+        }
+        ComfortKernel::score(temperature_.data(), humidity_.data(), pressure_.data(), count,
+                             comfortIndex_.data(), alerts_.data());
+        for (size_t i = 0; i < count; ++i) {
+            batch[i].scored = true;
+            batch[i].comfortIndex = comfortIndex_[i];
+            batch[i].alert = alerts_[i];
+        }
+    }
+
+private:
+    std::vector<double> temperature_, humidity_, pressure_, comfortIndex_;
+    std::vector<uint8_t> alerts_;
+};
+
+// 把记录交给 Context::emit（生成并发布 AlgorithmResult）
+class EmitOperator : public PipelineOperator {
+public:
+    explicit EmitOperator(const Pipeline::Context* context) : context_(context) {}
+
+    void processBatch(RecordBatch& batch) override {
+        if (!batch.empty() && context_->emit) {
+            context_->emit(batch);
+        }
+    }
+
+private:
+    const Pipeline::Context* context_;
+};
+
+// 按分组汇总所有传感器的窗口记录，每个周期输出一条分组记录：
+//   分组名为 sensor_id 中最后一个分隔符之前的部分（"LOAD_000123" → "LOAD"），separator 为空时全部归为 "*"
+//   均值按样本数加权，极值取所有窗口的极值；输入记录被吸收，不再向后传递
+class AggregateOperator : public PipelineOperator {
+public:
+    AggregateOperator(std::string separator, std::chrono::milliseconds interval)
+        : separator_(std::move(separator)), interval_(interval), lastFlush_(std::chrono::steady_clock::now()) {}
+
+    Placement placement() const override { return Placement::Global; }
+
+    void processBatch(RecordBatch& batch) override {
+        for (const WindowRecord& record : batch) {
+            Group& group = groupOf(record.key);
+            if (group.count == 0) {
+                group.min = record.min;
+                group.max = record.max;
+                group.start = record.start;
+                group.end = record.end;
+            }
+            for (size_t c = 0; c < SlidingWindow::CHANNEL_COUNT; ++c) {
+                group.weightedSum[c] += record.mean[c] * static_cast<double>(record.count);
+                group.min[c] = std::min(group.min[c], record.min[c]);
+                group.max[c] = std::max(group.max[c], record.max[c]);
+            }
+            group.count += record.count;
+            group.samples += record.samples;
+            group.start = std::min(group.start, record.start);
+            group.end = std::max(group.end, record.end);
+            group.late = group.late || record.late;
+        }
+        batch.clear();
+    }
+
+    std::chrono::steady_clock::time_point flushDeadline() const override { return lastFlush_ + interval_; }
+
+    void flush(RecordBatch& out, std::chrono::steady_clock::time_point now) override {
+        if (now != std::chrono::steady_clock::time_point::max() && now - lastFlush_ < interval_) {
+            return;
+        }
+        lastFlush_ = now;
+        for (auto& entry : groups_) {
+            Group& group = *entry.second;
+            if (group.count == 0) {
+                continue;
+            }
+            WindowRecord& record = out.emplace_back();
+            record.key = &entry.first;
+            for (size_t c = 0; c < SlidingWindow::CHANNEL_COUNT; ++c) {
+                record.mean[c] = group.weightedSum[c] / static_cast<double>(group.count);
+            }
+            record.min = group.min;
+            record.max = group.max;
+            record.count = group.count;
+            record.samples = group.samples;
+            record.start = group.start;
+            record.end = group.end;
+            record.late = group.late;
+            record.watermark = 0;
+            record.dropped = 0;
+            record.hasStats = false;
+            record.scored = false;
+            record.comfortIndex = 0;
+            record.alert = 0;
+            group.reset();
+        }
+    }
+
+private:
+    struct Group {
+        std::array<double, SlidingWindow::CHANNEL_COUNT> weightedSum{};
+        std::array<double, SlidingWindow::CHANNEL_COUNT> min{};
+        std::array<double, SlidingWindow::CHANNEL_COUNT> max{};
+        uint64_t count = 0;
+        uint64_t samples = 0;
+        int64_t start = 0;
+        int64_t end = 0;
+        bool late = false;
+
+        void reset() { *this = Group(); }
+    };
+
+    Group& groupOf(const std::string* key) {
+        // 传感器键的地址在流水线运行期间不变，按地址缓存分组，避免每条记录构造分组名
+        auto cached = bySensor_.find(key);
+        if (cached != bySensor_.end()) {
+            return *cached->second;
+        }
+        std::string name = "*";
+        if (!separator_.empty()) {
+            size_t position = key->rfind(separator_);
+            name = position == std::string::npos ? *key : key->substr(0, position);
+        }
+        auto& group = groups_[name];
+        if (!group) {
+            group = std::make_unique<Group>();
+        }
+        bySensor_.emplace(key, group.get());
+        return *group;
+    }
+
+    std::string separator_;
+    std::chrono::milliseconds interval_;
+    std::chrono::steady_clock::time_point lastFlush_;
+    std::map<std::string, std::unique_ptr<Group>> groups_;
+    std::unordered_map<const std::string*, Group*> bySensor_;
+};
+
+} // namespace
+
+std::map<std::string, Pipeline::Factory>& Pipeline::registry() {
+    static std::map<std::string, Factory> factories = {
+        {"filter", [](const OperatorConfig& config, std::string& error) -> std::unique_ptr<PipelineOperator> {
+            size_t metric;
+            if (!parseMetric(config, !config.beforeWindow && config.scored, metric, error)) {
+                return nullptr;
+            }
+            return std::make_unique<FilterOperator>(metric,
+                numberOr(config.params, "min", -std::numeric_limits<double>::infinity()),
+                numberOr(config.params, "max", std::numeric_limits<double>::infinity()));
+        }},
+        {"map", [](const OperatorConfig& config, std::string& error) -> std::unique_ptr<PipelineOperator> {
+            size_t metric;
+            if (!parseMetric(config, false, metric, error)) {
+                return nullptr;
+            }
+            double scale = numberOr(config.params, "scale", 1.0);
+            if (scale < 0 && !config.beforeWindow && config.context->stats) {
+                error = "map after window requires a non-negative scale when stats are enabled";
+                return nullptr;
+            }
+            return std::make_unique<MapOperator>(metric, scale, numberOr(config.params, "offset", 0.0));
+        }},
+        {"score", [](const OperatorConfig& config, std::string& error) -> std::unique_ptr<PipelineOperator> {
+            if (config.beforeWindow) {
+                error = "score must come after window";
+                return nullptr;
+            }
+            return std::make_unique<ScoreOperator>();
+        }},
+        {"emit", [](const OperatorConfig& config, std::string& error) -> std::unique_ptr<PipelineOperator> {
+            if (config.beforeWindow || !config.scored) {
+                error = "emit requires score before it";
+                return nullptr;
+            }
+            return std::make_unique<EmitOperator>(config.context);
+        }},
+        {"aggregate", [](const OperatorConfig& config, std::string& error) -> std::unique_ptr<PipelineOperator> {
+            if (config.beforeWindow) {
+                error = "aggregate must come after window";
+                return nullptr;
+            }
+            std::string separator = "_";
+            if (config.params && config.params->HasMember("separator") && (*config.params)["separator"].IsString()) {
+                separator = (*config.params)["separator"].GetString();
+            }
+            double interval = std::max(1.0, numberOr(config.params, "interval_ms", 1000));
+            return std::make_unique<AggregateOperator>(separator,
+                std::chrono::milliseconds(static_cast<int64_t>(interval)));
+        }},
+    };
+    return factories;
+}
+
+void Pipeline::registerOperator(const std::string& name, Factory factory) {
+    registry()[name] = std::move(factory);
+}
+
+void Pipeline::Waker::notify() {
+    // 与消费者先置 sleeping 再检查队列的顺序配对，保证不会错过唤醒
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        condition.notify_one();
+    }
+}
+
+Pipeline::Pipeline(Context context)
+    : context_(std::move(context)), windowIndex_(0), stageCount_(1), running_(false) {
+    std::string error;
+    configure(nullptr, error);
+}
+
+Pipeline::~Pipeline() {
+    stop();
+}
+
+bool Pipeline::configure(const rapidjson::Value* operators, std::string& error) {
+    std::vector<Spec> specs;
+    bool valid = true;
+
+    if (!operators) {
+        for (const char* name : {"window", "score", "emit"}) {
+            specs.push_back(Spec{name, nullptr, false, false, 0});
+        }
+    } else if (!operators->IsArray()) {
+        error = "pipeline must be an array of operators";
+        valid = false;
+    } else {
+        for (rapidjson::SizeType i = 0; i < operators->Size() && valid; ++i) {
+            const rapidjson::Value& entry = (*operators)[i];
+            if (!entry.IsObject() || !entry.HasMember("op") || !entry["op"].IsString()) {
+                error = "operator " + std::to_string(i) + " has no \"op\"";
+                valid = false;
+                break;
+            }
+            specs.push_back(Spec{entry["op"].GetString(), &entry, false, false, 0});
+        }
+    }
+
+    // 校验并划分阶段：window 之前的算子在工作线程上逐样本执行；之后的算子默认融合到当前阶段，
+    // Global 算子不能运行在多线程的工作线程阶段，"thread": true 显式切分
+    size_t windowCount = 0;
+    size_t windowIndex = 0;
+    size_t stage = 0;
+    bool scored = false;
+    for (size_t i = 0; i < specs.size() && valid; ++i) {
+        Spec& spec = specs[i];
+        if (spec.name == "window") {
+            if (++windowCount > 1) {
+                error = "pipeline has more than one window";
+                valid = false;
+            }
+            windowIndex = i;
+            continue;
+        }
+        auto factory = registry().find(spec.name);
+        if (factory == registry().end()) {
+            error = "unknown operator \"" + spec.name + "\"";
+            valid = false;
+            break;
+        }
+        spec.beforeWindow = windowCount == 0;
+        spec.scored = scored;
+        OperatorConfig config{spec.params, spec.beforeWindow, scored, &context_};
+        std::string operatorError;
+        std::unique_ptr<PipelineOperator> probe = factory->second(config, operatorError);
+        if (!probe) {
+            error = spec.name + ": " + operatorError;
+            valid = false;
+            break;
+        }
+        if (spec.beforeWindow) {
+            if (probe->placement() == PipelineOperator::Placement::Global) {
+                error = spec.name + " must come after window";
+                valid = false;
+            }
+            continue;
+        }
+
+        bool newThread = spec.params && spec.params->HasMember("thread") && (*spec.params)["thread"].IsBool() &&
+                         (*spec.params)["thread"].GetBool();
+        if (newThread || (probe->placement() == PipelineOperator::Placement::Global && stage == 0)) {
+            ++stage;
+        }
+        spec.stage = stage;
+        // score 之后记录带评分；aggregate 输出新的分组记录，需要重新评分
+        if (spec.name == "score") {
+            scored = true;
+        } else if (spec.name == "aggregate") {
+            scored = false;
+        }
+    }
+    if (valid && windowCount == 0) {
+        error = "pipeline has no window";
+        valid = false;
+    }
+
+    if (!valid) {
+        if (operators) {
+            configure(nullptr, error);
+        }
+        return false;
+    }
+    specs_ = std::move(specs);
+    windowIndex_ = windowIndex;
+    stageCount_ = stage + 1;
+    return true;
+}
+
+std::vector<std::unique_ptr<PipelineOperator>> Pipeline::instantiate(size_t stage, bool beforeWindow) {
+    std::vector<std::unique_ptr<PipelineOperator>> ops;
+    for (const Spec& spec : specs_) {
+        if (spec.name == "window" || spec.beforeWindow != beforeWindow || (!beforeWindow && spec.stage != stage)) {
+            continue;
+        }
+        std::string error;
+        OperatorConfig config{spec.params, spec.beforeWindow, spec.scored, &context_};
+        ops.push_back(registry()[spec.name](config, error));
+    }
+    return ops;
+}
+
+void Pipeline::start(size_t workers) {
+    if (running_.exchange(true)) {
+        return;
+    }
+
+    for (size_t stage = 1; stage < stageCount_; ++stage) {
+        auto thread = std::make_unique<StageThread>();
+        thread->ops = instantiate(stage, false);
+        stages_.push_back(std::move(thread));
+    }
+    for (size_t i = 0; i < workers; ++i) {
+        auto worker = std::make_unique<Worker>();
+        worker->sampleOps = instantiate(0, true);
+        worker->ops = instantiate(0, false);
+        if (!stages_.empty()) {
+            edges_.push_back(std::make_unique<Edge>());
+            worker->out = edges_.back().get();
+            stages_[0]->inputs.push_back(worker->out);
+        }
+        workers_.push_back(std::move(worker));
+    }
+    for (size_t i = 0; i + 1 < stages_.size(); ++i) {
+        edges_.push_back(std::make_unique<Edge>());
+        stages_[i]->out = edges_.back().get();
+        stages_[i + 1]->inputs.push_back(stages_[i]->out);
+    }
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        stages_[i]->thread = std::thread(&Pipeline::stageLoop, this, i);
+    }
+    std::cout << "[Pipeline] " << describe() << std::endl;
+}
+
+void Pipeline::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    // 按阶段顺序停止：上游线程退出后下游才能确认不会再有新批次
+    for (auto& stage : stages_) {
+        stage->upstreamDone.store(true, std::memory_order_release);
+        {
+            std::lock_guard<std::mutex> lock(stage->waker.mutex);
+            stage->waker.condition.notify_all();
+        }
+        if (stage->thread.joinable()) {
+            stage->thread.join();
+        }
+    }
+}
+
+bool Pipeline::processSample(size_t worker, SlidingWindow::Sample& sample) {
+    for (auto& op : workers_[worker]->sampleOps) {
+        if (!op->processSample(sample)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Pipeline::processRound(size_t worker, const std::vector<SensorWorkerPool::Touched>& touched) {
+    Worker& state = *workers_[worker];
+    collectWindows(touched, state.batch);
+    runOps(state.ops, state.batch);
+    if (state.out && !state.batch.empty()) {
+        send(*state.out, *stages_[0], state.batch);
+    } else {
+        state.batch.clear();
+    }
+}
+
+void Pipeline::collectWindows(const std::vector<SensorWorkerPool::Touched>& touched, RecordBatch& batch) {
+    // 事件时间模式下输出刚关闭（或被迟到样本更新）的窗口，否则为各传感器的计数窗口
+    auto now = std::chrono::steady_clock::now();
+    for (const auto& entry : touched) {
+        SensorWorkerPool::SensorState& state = *entry.state;
+        size_t first = batch.size();
+
+        if (state.eventWindow) {
+            for (const EventTimeWindow::Result& closed : state.closedWindows) {
+                WindowRecord& record = batch.emplace_back();
+                record.count = closed.aggregate.count;
+                for (size_t c = 0; c < SlidingWindow::CHANNEL_COUNT; ++c) {
+                    record.mean[c] = closed.aggregate.mean(static_cast<SlidingWindow::Channel>(c));
+                    record.min[c] = closed.aggregate.min[c];
+                    record.max[c] = closed.aggregate.max[c];
+                }
+                record.start = closed.start;
+                record.end = closed.end;
+                record.late = closed.late;
+                record.watermark = state.eventWindow->watermark();
+                record.dropped = state.eventWindow->droppedCount();
+            }
+            state.closedWindows.clear();
+        } else if (state.window.size() >= context_.minWindowSamples) {
+            // 如果有足够的数据，进行处理
+            const SlidingWindow& window = state.window;
+            WindowRecord& record = batch.emplace_back();
+            record.count = window.size();
+            for (size_t c = 0; c < SlidingWindow::CHANNEL_COUNT; ++c) {
+                auto channel = static_cast<SlidingWindow::Channel>(c);
+                record.mean[c] = window.mean(channel);
+                record.min[c] = window.min(channel);
+                record.max[c] = window.max(channel);
+            }
+            record.start = window.oldest().timestamp;
+            record.end = window.latest().timestamp;
+            record.late = false;
+            record.watermark = 0;
+            record.dropped = 0;
+        }
+        if (batch.size() == first) {
+            continue;
+        }
+
+        // 分位数查询需要排序，按间隔刷新，其余记录沿用上次的值
+        bool hasStats = state.stats.enabled();
+        if (hasStats && now - state.lastQuantiles >= context_.quantileInterval) {
+            state.lastQuantiles = now;
+            state.stats.refreshQuantiles();
+        }
+        for (size_t i = first; i < batch.size(); ++i) {
+            WindowRecord& record = batch[i];
+            record.key = entry.sensorId;
+            record.samples = state.samples;
+            record.scored = false;
+            record.comfortIndex = 0;
+            record.alert = 0;
+            record.hasStats = hasStats;
+            if (!hasStats) {
+                continue;
+            }
+            for (size_t c = 0; c < SlidingWindow::CHANNEL_COUNT; ++c) {
+                const MetricStats& metric = state.stats.metric(static_cast<SlidingWindow::Channel>(c));
+                MetricSnapshot& snapshot = record.stats[c];
+                snapshot.ewma = metric.ewma.value();
+                snapshot.stddev = metric.variance.stddev();
+                snapshot.quantiles = state.stats.quantiles(static_cast<SlidingWindow::Channel>(c));
+                snapshot.count = metric.variance.count();
+            }
+        }
+    }
+}
+
+void Pipeline::runOps(std::vector<std::unique_ptr<PipelineOperator>>& ops, RecordBatch& batch) {
+    for (auto& op : ops) {
+        if (batch.empty()) {
+            return;
+        }
+        op->processBatch(batch);
+    }
+}
+
+void Pipeline::send(Edge& edge, StageThread& consumer, RecordBatch& batch) {
+    while (!edge.forward.tryPush(std::move(batch))) {
+        consumer.waker.notify();
+        std::this_thread::yield();
+    }
+    consumer.waker.notify();
+    // 换回下游处理完的批次（保留容量），没有时新建
+    if (edge.recycle.tryPop(batch)) {
+        batch.clear();
+    } else {
+        batch = RecordBatch();
+    }
+}
+
+void Pipeline::stageLoop(size_t index) {
+    ThreadPlacement::getInstance().apply(ThreadRole::App, "algo-pipe-" + std::to_string(index + 1));
+    StageThread& stage = *stages_[index];
+    StageThread* next = index + 1 < stages_.size() ? stages_[index + 1].get() : nullptr;
+    bool hasGlobal = std::any_of(stage.ops.begin(), stage.ops.end(), [](const auto& op) {
+        return op->placement() == PipelineOperator::Placement::Global;
+    });
+    RecordBatch batch;
+
+    auto forward = [&](RecordBatch& output) {
+        if (next && !output.empty()) {
+            send(*stage.out, *next, output);
+        }
+        output.clear();
+    };
+    auto flushDeadline = [&]() {
+        auto deadline = std::chrono::steady_clock::time_point::max();
+        for (const auto& op : stage.ops) {
+            deadline = std::min(deadline, op->flushDeadline());
+        }
+        return deadline;
+    };
+    auto flush = [&](std::chrono::steady_clock::time_point now) {
+        // Global 算子的输出只经过它之后的算子
+        for (size_t i = 0; i < stage.ops.size(); ++i) {
+            stage.pending.clear();
+            stage.ops[i]->flush(stage.pending, now);
+            for (size_t j = i + 1; j < stage.ops.size() && !stage.pending.empty(); ++j) {
+                stage.ops[j]->processBatch(stage.pending);
+            }
+            forward(stage.pending);
+        }
+    };
+
+    while (true) {
+        // 先读取停止标志再清空队列：标志置位时上游已退出，之后不会再有新批次
+        bool stopping = stage.upstreamDone.load(std::memory_order_acquire);
+        bool worked = false;
+        for (Edge* input : stage.inputs) {
+            while (input->forward.tryPop(batch)) {
+                worked = true;
+                runOps(stage.ops, batch);
+                forward(batch);
+                input->recycle.tryPush(std::move(batch));
+            }
+        }
+        if (hasGlobal) {
+            // 只在有算子到期时 flush，而不是每次被唤醒都 flush
+            auto now = std::chrono::steady_clock::now();
+            if (now >= flushDeadline()) {
+                flush(now);
+            }
+        }
+        if (stopping && !worked) {
+            if (hasGlobal) {
+                flush(std::chrono::steady_clock::time_point::max());
+            }
+            break;
+        }
+        if (worked) {
+            continue;
+        }
+
+        // 空闲时不定时轮询：没有 Global 算子时一直睡到有输入或停止，否则最多睡到最早的 flush 截止时间。
+        // 在锁内检查队列：生产者看到 sleeping 后要先拿锁才能通知，检查与等待之间不会漏掉唤醒
+        stage.waker.sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        {
+            auto ready = [&stage]() {
+                return stage.upstreamDone.load(std::memory_order_acquire) ||
+                       !std::all_of(stage.inputs.begin(), stage.inputs.end(), [](Edge* input) {
+                           return input->forward.empty();
+                       });
+            };
+            auto deadline = hasGlobal ? flushDeadline() : std::chrono::steady_clock::time_point::max();
+            std::unique_lock<std::mutex> lock(stage.waker.mutex);
+            if (deadline == std::chrono::steady_clock::time_point::max()) {
+                stage.waker.condition.wait(lock, ready);
+            } else {
+                stage.waker.condition.wait_until(lock, deadline, ready);
+            }
+        }
+        stage.waker.sleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+std::string Pipeline::describe() const {
+    std::string description;
+    size_t stage = 0;
+    for (const Spec& spec : specs_) {
+        if (!description.empty()) {
+            description += spec.stage != stage ? " =[thread]=> " : " -> ";
+        }
+        stage = spec.stage;
+        description += spec.name;
+    }
+    return description + " (" + std::to_string(stageCount_ - 1) + " pipeline thread(s))";
+}
@@ -0,0 +1,94 @@
+// ResultBuilder.cpp
+#include "ResultBuilder.h"
+#include "ComfortKernel.h"
+#include <charconv>
+
+namespace {
+
+// 按 AlertLevel 数值索引的静态表，结果字段直接引用，不构造临时字符串
+struct AlertLevelInfo {
+    const char* name;
+    const char* recommendation;
+};
+
+constexpr AlertLevelInfo ALERT_LEVELS[] = {
+    {"GOOD", "Environment conditions are optimal"},
+    {"MODERATE", "Consider adjusting temperature or humidity"},
+    {"POOR", "Environmental conditions need attention"},
+    {"CRITICAL", "Immediate action required - check HVAC system"},
+};
+
+static_assert(sizeof(ALERT_LEVELS) / sizeof(ALERT_LEVELS[0]) == AlertLevel_ARRAYSIZE, "AlertLevel table out of sync");
+static_assert(static_cast<int>(ComfortKernel::ALERT_GOOD) == ALERT_LEVEL_GOOD &&
+              static_cast<int>(ComfortKernel::ALERT_MODERATE) == ALERT_LEVEL_MODERATE &&
+              static_cast<int>(ComfortKernel::ALERT_POOR) == ALERT_LEVEL_POOR &&
+              static_cast<int>(ComfortKernel::ALERT_CRITICAL) == ALERT_LEVEL_CRITICAL,
+              "ComfortKernel::Alert must match AlertLevel");
+
+const AlertLevelInfo& alertLevelInfo(AlertLevel level) {
+    int index = static_cast<int>(level);
+    return ALERT_LEVELS[(index >= 0 && index < AlertLevel_ARRAYSIZE) ? index : ALERT_LEVEL_CRITICAL];
+}
+
+} // namespace
+
+void ResultBuilder::fill(const WindowRecord& record, int64_t timestampMs, AlgorithmResult& result) {
+    // 窗口统计已增量维护，不再遍历样本；舒适度指数已由 score 算子批量算出
+    AlertLevel level = static_cast<AlertLevel>(record.alert);
+    const AlertLevelInfo& info = alertLevelInfo(level);
+
+    // 结果 ID 单调递增，格式化到栈上缓冲区；字符串字段用 assign 覆盖已有缓冲区
+    // （set_xxx(const char*) 会先构造临时 std::string）
+    char id[32] = "RESULT_";
+    constexpr size_t prefixLength = sizeof("RESULT_") - 1;
+    auto formatted = std::to_chars(id + prefixLength, id + sizeof(id),
+                                   nextResultId_.fetch_add(1, std::memory_order_relaxed));
+    result.mutable_result_id()->assign(id, formatted.ptr);
+    result.mutable_sensor_id()->assign(*record.key);
+
+    result.set_comfort_index(record.comfortIndex);
+    result.set_level(level);
+    result.mutable_alert_level()->assign(info.name);
+    result.mutable_recommendation()->assign(info.recommendation);
+    result.set_timestamp(timestampMs);
+    result.set_avg_temperature(record.mean[SlidingWindow::TEMPERATURE]);
+    result.set_avg_humidity(record.mean[SlidingWindow::HUMIDITY]);
+    result.set_avg_pressure(record.mean[SlidingWindow::PRESSURE]);
+    result.set_min_temperature(record.min[SlidingWindow::TEMPERATURE]);
+    result.set_max_temperature(record.max[SlidingWindow::TEMPERATURE]);
+    result.set_min_humidity(record.min[SlidingWindow::HUMIDITY]);
+    result.set_max_humidity(record.max[SlidingWindow::HUMIDITY]);
+    result.set_min_pressure(record.min[SlidingWindow::PRESSURE]);
+    result.set_max_pressure(record.max[SlidingWindow::PRESSURE]);
+    result.set_sample_count(record.count);
+    result.set_window_start(record.start);
+    result.set_window_end(record.end);
+    result.set_late_update(record.late);
+
+    if (record.hasStats) {
+        fillSummary(record.stats[SlidingWindow::TEMPERATURE], *result.mutable_temperature_stats());
+        fillSummary(record.stats[SlidingWindow::HUMIDITY], *result.mutable_humidity_stats());
+        fillSummary(record.stats[SlidingWindow::PRESSURE], *result.mutable_pressure_stats());
+    } else {
+        result.clear_temperature_stats();
+        result.clear_humidity_stats();
+        result.clear_pressure_stats();
+    }
+}
+
+const char* ResultBuilder::alertLevelName(AlertLevel level) {
+    return alertLevelInfo(level).name;
+}
+
+const char* ResultBuilder::recommendation(AlertLevel level) {
+    return alertLevelInfo(level).recommendation;
+}
+
+void ResultBuilder::fillSummary(const MetricSnapshot& snapshot, MetricSummary& summary) {
+    summary.set_ewma(snapshot.ewma);
+    summary.set_stddev(snapshot.stddev);
+    summary.set_p50(snapshot.quantiles[0]);
+    summary.set_p95(snapshot.quantiles[1]);
+    summary.set_p99(snapshot.quantiles[2]);
+    summary.set_count(snapshot.count);
+}
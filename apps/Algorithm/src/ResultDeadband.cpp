@@ -0,0 +1,35 @@
+// ResultDeadband.cpp
+#include "ResultDeadband.h"
+#include <cmath>
+
+ResultDeadband::Decision ResultDeadband::evaluate(State& state, double comfortIndex, uint8_t alert, bool late,
+                                                  std::chrono::steady_clock::time_point now) const {
+    Decision decision;
+    if (!state.published || !options_.enabled) {
+        decision = Decision::FIRST;
+    } else {
+        // 警报等级变化和迟到窗口更新不受 min_interval 限制：它们本身稀少，而被抑制后
+        // 可能要等到下一个同样有变化的结果才会发出，甚至再也不会发出
+        auto elapsed = now - state.lastPublish;
+        // NaN 与任何值比较都不相等，按变化处理
+        double delta = std::abs(comfortIndex - state.comfortIndex);
+        if (alert != state.alert) {
+            decision = Decision::ALERT_CHANGE;
+        } else if (late) {
+            decision = Decision::LATE_UPDATE;
+        } else if (elapsed < options_.minInterval) {
+            return Decision::SUPPRESS;
+        } else if (!(delta <= options_.epsilon)) {
+            decision = Decision::VALUE_CHANGE;
+        } else if (elapsed >= options_.maxInterval) {
+            decision = Decision::HEARTBEAT;
+        } else {
+            return Decision::SUPPRESS;
+        }
+    }
+    state.published = true;
+    state.alert = alert;
+    state.comfortIndex = comfortIndex;
+    state.lastPublish = now;
+    return decision;
+}
@@ -0,0 +1,297 @@
+// SensorWorkerPool.cpp
+#include "SensorWorkerPool.h"
+#include "StateCodec.h"
+#include "ThreadPlacement.h"
+#include <algorithm>
+#include <iostream>
+
+void SensorWorkerPool::SensorState::save(StateWriter& writer) const {
+    writer.write(samples);
+    window.save(writer);
+    stats.save(writer);
+    detector.save(writer);
+    writer.write(static_cast<uint8_t>(eventWindow ? 1 : 0));
+    if (eventWindow) {
+        eventWindow->save(writer);
+    }
+}
+
+bool SensorWorkerPool::SensorState::load(StateReader& reader) {
+    uint8_t hasEventWindow = 0;
+    if (!reader.read(samples) || !window.load(reader) || !stats.load(reader) || !detector.load(reader) ||
+        !reader.read(hasEventWindow) || hasEventWindow != (eventWindow ? 1 : 0)) {
+        return false;
+    }
+    return !eventWindow || eventWindow->load(reader);
+}
+
+SensorWorkerPool::SensorWorkerPool(size_t workers, const SensorState::Options& options, Processor processor)
+    : options_(options), processor_(std::move(processor)), maxPending_(DEFAULT_MAX_PENDING),
+      maxSensors_(DEFAULT_MAX_SENSORS), sensorCount_(0), sensorLimitReported_(false), dropped_(0), running_(false) {
+    workers = std::max<size_t>(1, workers);
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+}
+
+SensorWorkerPool::~SensorWorkerPool() {
+    stop();
+}
+
+void SensorWorkerPool::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        workers_[i]->thread = std::thread(&SensorWorkerPool::workerLoop, this, i);
+    }
+    std::cout << "[SensorWorkerPool] Processing on " << workers_.size() << " worker thread(s)" << std::endl;
+}
+
+void SensorWorkerPool::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    for (auto& worker : workers_) {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->condition.notify_all();
+    }
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+size_t SensorWorkerPool::shardOf(const std::string& sensorId) const {
+    return std::hash<std::string>()(sensorId) % workers_.size();
+}
+
+uint64_t SensorWorkerPool::processedCount() const {
+    uint64_t total = 0;
+    for (const auto& worker : workers_) {
+        total += worker->processed.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t SensorWorkerPool::invalidCount() const {
+    uint64_t total = 0;
+    for (const auto& worker : workers_) {
+        total += worker->invalid.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t SensorWorkerPool::rejectedCount() const {
+    uint64_t total = 0;
+    for (const auto& worker : workers_) {
+        total += worker->rejected.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+bool SensorWorkerPool::reserveSensor() {
+    size_t count = sensorCount_.load(std::memory_order_relaxed);
+    while (count < maxSensors_) {
+        if (sensorCount_.compare_exchange_weak(count, count + 1, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    if (!sensorLimitReported_.exchange(true)) {
+        std::cerr << "[SensorWorkerPool] Sensor limit " << maxSensors_ << " reached, samples from new sensors are dropped"
+                  << std::endl;
+    }
+    return false;
+}
+
+bool SensorWorkerPool::submit(const std::string& sensorId, const SlidingWindow::Sample& sample) {
+    Job job;
+    job.sensorId = sensorId;
+    job.sample = sample;
+    return enqueue(std::move(job));
+}
+
+bool SensorWorkerPool::submit(const std::string& sensorId, std::vector<SlidingWindow::Sample> samples) {
+    if (samples.empty()) {
+        return true;
+    }
+    Job job;
+    job.sensorId = sensorId;
+    job.batch = std::move(samples);
+    return enqueue(std::move(job));
+}
+
+bool SensorWorkerPool::enqueue(Job job) {
+    if (!running_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    Worker& worker = *workers_[shardOf(job.sensorId)];
+    bool wasEmpty;
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (worker.pending.size() >= maxPending_) {
+            // 工作线程跟不上：丢弃新样本而不是让队列无限增长，按 2 的幂次输出日志避免刷屏
+            uint64_t count = job.batch.empty() ? 1 : job.batch.size();
+            uint64_t total = dropped_.fetch_add(count, std::memory_order_relaxed) + count;
+            if ((total & (total - 1)) == 0 || count >= total) {
+                std::cerr << "[SensorWorkerPool] Worker queue full, dropped " << total << " sample(s)" << std::endl;
+            }
+            return false;
+        }
+        wasEmpty = worker.pending.empty();
+        worker.pending.push_back(std::move(job));
+    }
+    // 队列非空说明工作线程已被唤醒或正在处理，无需再次通知
+    if (wasEmpty) {
+        worker.condition.notify_one();
+    }
+    return true;
+}
+
+void SensorWorkerPool::workerLoop(size_t index) {
+    ThreadPlacement::getInstance().apply(ThreadRole::App, "algo-worker-" + std::to_string(index));
+    Worker& worker = *workers_[index];
+    std::vector<Job> jobs;
+    std::vector<Touched> touched;
+    uint64_t round = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(worker.mutex);
+            worker.condition.wait(lock, [this, &worker]() {
+                return !worker.pending.empty() || !running_.load() ||
+                       worker.snapshotRequested.load(std::memory_order_acquire) != worker.snapshotTaken;
+            });
+            if (worker.pending.empty() && !running_.load()) {
+                break;
+            }
+            // 整批交换，持锁时间与任务数量无关
+            jobs.swap(worker.pending);
+        }
+
+        uint64_t processed = 0;
+        uint64_t invalid = 0;
+        uint64_t rejected = 0;
+        ++round;
+        for (Job& job : jobs) {
+            auto it = worker.sensors.find(job.sensorId);
+            if (it == worker.sensors.end()) {
+                if (!reserveSensor()) {
+                    rejected += job.batch.empty() ? 1 : job.batch.size();
+                    continue;
+                }
+                it = worker.sensors.emplace(job.sensorId, std::make_unique<SensorState>(options_)).first;
+            }
+            SensorState& state = *it->second;
+
+            size_t count = job.batch.empty() ? 1 : job.batch.size();
+            const SlidingWindow::Sample* samples = job.batch.empty() ? &job.sample : job.batch.data();
+            size_t accepted = 0;
+            for (size_t i = 0; i < count; ++i) {
+                SlidingWindow::Sample filtered;
+                const SlidingWindow::Sample* sample = &samples[i];
+                if (sampleFilter_) {
+                    filtered = samples[i];
+                    if (!sampleFilter_(index, filtered)) {
+                        continue;
+                    }
+                    sample = &filtered;
+                }
+                if (state.push(*sample)) {
+                    ++accepted;
+                } else {
+                    ++invalid;
+                }
+            }
+            state.samples += accepted;
+            processed += count;
+
+            // 样本全部被过滤时窗口没有变化，不交给处理器
+            if (accepted > 0 && state.lastRound != round) {
+                state.lastRound = round;
+                touched.push_back(Touched{&it->first, &state});
+            }
+        }
+
+        try {
+            if (!touched.empty()) {
+                processor_(index, touched);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "[SensorWorkerPool] Error processing " << touched.size() << " sensor(s): " << e.what() << std::endl;
+        }
+        worker.processed.fetch_add(processed, std::memory_order_relaxed);
+        if (invalid > 0) {
+            worker.invalid.fetch_add(invalid, std::memory_order_relaxed);
+        }
+        if (rejected > 0) {
+            worker.rejected.fetch_add(rejected, std::memory_order_relaxed);
+        }
+        jobs.clear();
+        touched.clear();
+
+        // 在两批之间快照，所有状态都停在批次边界上
+        uint64_t generation = worker.snapshotRequested.load(std::memory_order_acquire);
+        if (generation != worker.snapshotTaken) {
+            takeSnapshot(index, generation);
+        }
+    }
+}
+
+void SensorWorkerPool::requestSnapshot(uint64_t generation) {
+    for (auto& worker : workers_) {
+        worker->snapshotRequested.store(generation, std::memory_order_release);
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        worker->condition.notify_one();
+    }
+}
+
+void SensorWorkerPool::snapshot(uint64_t generation) {
+    if (running_.load()) {
+        return;
+    }
+    for (size_t i = 0; i < workers_.size(); ++i) {
+        takeSnapshot(i, generation);
+    }
+}
+
+void SensorWorkerPool::takeSnapshot(size_t index, uint64_t generation) {
+    Worker& worker = *workers_[index];
+    worker.snapshotTaken = generation;
+    if (!snapshotSink_) {
+        return;
+    }
+
+    std::string data;
+    StateWriter writer(data);
+    for (const auto& entry : worker.sensors) {
+        writer.writeString(entry.first);
+        size_t lengthPos = writer.size();
+        writer.write(uint32_t(0));
+        entry.second->save(writer);
+        writer.patch(lengthPos, static_cast<uint32_t>(writer.size() - lengthPos - sizeof(uint32_t)));
+    }
+    snapshotSink_(index, generation, std::move(data));
+}
+
+bool SensorWorkerPool::restore(const std::string& sensorId, const char* data, size_t size) {
+    if (running_.load()) {
+        return false;
+    }
+    auto state = std::make_unique<SensorState>(options_);
+    StateReader reader(data, size);
+    if (!state->load(reader) || reader.remaining() != 0) {
+        return false;
+    }
+    auto& sensors = workers_[shardOf(sensorId)]->sensors;
+    auto it = sensors.find(sensorId);
+    if (it == sensors.end()) {
+        if (!reserveSensor()) {
+            return false;
+        }
+        it = sensors.emplace(sensorId, nullptr).first;
+    }
+    it->second = std::move(state);
+    return true;
+}
@@ -0,0 +1,209 @@
+// SlidingWindow.cpp
+#include "SlidingWindow.h"
+#include "StateCodec.h"
+#include <algorithm>
+#include <cmath>
+
+void SlidingWindow::MonotonicQueue::reset(size_t capacity) {
+    slots_.assign(capacity, 0);
+    head_ = 0;
+    size_ = 0;
+}
+
+void SlidingWindow::MonotonicQueue::grow(size_t capacity) {
+    std::vector<uint32_t> slots(std::max(capacity, slots_.size()), 0);
+    for (size_t i = 0; i < size_; ++i) {
+        size_t index = head_ + i;
+        slots[i] = slots_[index >= slots_.size() ? index - slots_.size() : index];
+    }
+    slots_.swap(slots);
+    head_ = 0;
+}
+
+void SlidingWindow::RunningSum::add(double value) {
+    // Neumaier：补偿项记录每次加法丢失的低位
+    // 用选择代替分支，输入随机时不会产生分支预测失败
+    double total = sum + value;
+    bool sumLarger = std::fabs(sum) >= std::fabs(value);
+    double larger = sumLarger ? sum : value;
+    double smaller = sumLarger ? value : sum;
+    compensation += (larger - total) + smaller;
+    sum = total;
+}
+
+SlidingWindow::SlidingWindow(size_t capacity) : capacity_(0), size_(0), writePos_(0), sinceRebase_(0) {
+    setCapacity(capacity);
+}
+
+void SlidingWindow::setCapacity(size_t capacity) {
+    capacity_ = std::min(std::max<size_t>(1, capacity), MAX_CAPACITY);
+    std::vector<Sample>().swap(samples_);
+    clear();
+}
+
+void SlidingWindow::clear() {
+    size_ = 0;
+    writePos_ = 0;
+    sinceRebase_ = 0;
+    for (size_t c = 0; c < CHANNEL_COUNT; ++c) {
+        shifts_[c] = 0;
+        sums_[c] = RunningSum();
+        squares_[c] = RunningSum();
+        minQueues_[c].reset(samples_.size());
+        maxQueues_[c].reset(samples_.size());
+    }
+}
+
+void SlidingWindow::grow() {
+    size_t storage = std::min(capacity_, std::max(INITIAL_STORAGE, samples_.size() * 2));
+    samples_.resize(storage);
+    for (size_t c = 0; c < CHANNEL_COUNT; ++c) {
+        minQueues_[c].grow(storage);
+        maxQueues_[c].grow(storage);
+    }
+}
+
+void SlidingWindow::push(const Sample& sample) {
+    if (size_ == samples_.size() && size_ < capacity_) {
+        grow();
+    }
+    uint32_t slot = static_cast<uint32_t>(writePos_);
+    Sample& stored = samples_[slot];
+
+    if (size_ == capacity_) {
+        // 移出最旧样本（即将被覆盖的槽位）：从滚动和中减去，仍在队首的出队
+        for (size_t c = 0; c < CHANNEL_COUNT; ++c) {
+            double offset = stored.values[c] - shifts_[c];
+            sums_[c].add(-offset);
+            squares_[c].add(-offset * offset);
+            if (!minQueues_[c].empty() && minQueues_[c].front() == slot) {
+                minQueues_[c].popFront();
+            }
+            if (!maxQueues_[c].empty() && maxQueues_[c].front() == slot) {
+                maxQueues_[c].popFront();
+            }
+        }
+    } else {
+        if (size_ == 0) {
+            shifts_ = sample.values;
+        }
+        ++size_;
+    }
+
+    stored = sample;
+    writePos_ = writePos_ + 1 == capacity_ ? 0 : writePos_ + 1;
+
+    for (size_t c = 0; c < CHANNEL_COUNT; ++c) {
+        double value = sample.values[c];
+        double offset = value - shifts_[c];
+        sums_[c].add(offset);
+        squares_[c].add(offset * offset);
+
+        // 新样本比队尾更优时，队尾在剩余生命周期内都不可能成为极值
+        auto& minQueue = minQueues_[c];
+        while (!minQueue.empty() && samples_[minQueue.back()].values[c] >= value) {
+            minQueue.popBack();
+        }
+        minQueue.pushBack(slot);
+
+        auto& maxQueue = maxQueues_[c];
+        while (!maxQueue.empty() && samples_[maxQueue.back()].values[c] <= value) {
+            maxQueue.popBack();
+        }
+        maxQueue.pushBack(slot);
+    }
+
+    if (++sinceRebase_ >= std::max<size_t>(capacity_ * 4, MIN_REBASE_INTERVAL)) {
+        rebase();
+    }
+}
+
+void SlidingWindow::rebase() {
+    // 定期以当前均值为基准重算滚动和（间隔不小于窗口容量的 4 倍，均摊 O(1)）：
+    // 数据整体漂移后偏移量不会变大，增量累加的舍入误差也随之清零
+    sinceRebase_ = 0;
+    for (size_t c = 0; c < CHANNEL_COUNT; ++c) {
+        double shift = mean(static_cast<Channel>(c));
+        RunningSum sum, squares;
+        for (size_t i = 0; i < size_; ++i) {
+            double offset = samples_[i].values[c] - shift;
+            sum.add(offset);
+            squares.add(offset * offset);
+        }
+        shifts_[c] = shift;
+        sums_[c] = sum;
+        squares_[c] = squares;
+    }
+}
+
+double SlidingWindow::mean(Channel channel) const {
+    return shifts_[channel] + sums_[channel].value() / static_cast<double>(size_);
+}
+
+double SlidingWindow::variance(Channel channel) const {
+    if (size_ < 2) {
+        return 0.0;
+    }
+    double n = static_cast<double>(size_);
+    double sum = sums_[channel].value();
+    double squares = squares_[channel].value() - sum * sum / n;
+    return squares > 0.0 ? squares / (n - 1.0) : 0.0;
+}
+
+double SlidingWindow::min(Channel channel) const {
+    return samples_[minQueues_[channel].front()].values[channel];
+}
+
+double SlidingWindow::max(Channel channel) const {
+    return samples_[maxQueues_[channel].front()].values[channel];
+}
+
+const SlidingWindow::Sample& SlidingWindow::latest() const {
+    return samples_[writePos_ == 0 ? capacity_ - 1 : writePos_ - 1];
+}
+
+const SlidingWindow::Sample& SlidingWindow::oldest() const {
+    return samples_[size_ == capacity_ ? writePos_ : 0];
+}
+
+void SlidingWindow::save(StateWriter& writer) const {
+    writer.write(static_cast<uint64_t>(size_));
+    size_t first = size_ == capacity_ ? writePos_ : 0;
+    for (size_t i = 0; i < size_; ++i) {
+        size_t slot = first + i;
+        writer.write(samples_[slot >= capacity_ ? slot - capacity_ : slot]);
+    }
+    writer.write(static_cast<uint64_t>(sinceRebase_));
+    writer.write(shifts_);
+    writer.write(sums_);
+    writer.write(squares_);
+}
+
+bool SlidingWindow::load(StateReader& reader) {
+    clear();
+    uint64_t count = 0;
+    if (!reader.read(count) || count > reader.remaining() / sizeof(Sample)) {
+        return reader.fail();
+    }
+    Sample sample;
+    for (uint64_t i = 0; i < count; ++i) {
+        reader.read(sample);
+        push(sample);
+    }
+
+    // 重新加入样本已重建单调队列；样本全部保留时再换回保存的滚动和，结果与保存前逐位一致
+    uint64_t sinceRebase = 0;
+    std::array<double, CHANNEL_COUNT> shifts;
+    std::array<RunningSum, CHANNEL_COUNT> sums;
+    std::array<RunningSum, CHANNEL_COUNT> squares;
+    if (!reader.read(sinceRebase) || !reader.read(shifts) || !reader.read(sums) || !reader.read(squares)) {
+        return false;
+    }
+    if (count == size_) {
+        sinceRebase_ = static_cast<size_t>(sinceRebase);
+        shifts_ = shifts;
+        sums_ = sums;
+        squares_ = squares;
+    }
+    return true;
+}
@@ -0,0 +1,237 @@
+// StateCheckpoint.cpp
+#include "StateCheckpoint.h"
+#include "Crc32.h"
+#include "StateCodec.h"
+#include "ThreadPlacement.h"
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <errno.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace {
+    bool writeAll(int fd, const char* data, size_t length) {
+        while (length > 0) {
+            ssize_t written = ::write(fd, data, length);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            data += written;
+            length -= static_cast<size_t>(written);
+        }
+        return true;
+    }
+}
+
+StateCheckpoint::StateCheckpoint(const Options& options, SensorWorkerPool& pool)
+    : options_(options), pool_(pool), received_(0), generation_(0), running_(false), checkpoints_(0) {
+    options_.interval = std::max(options_.interval, std::chrono::milliseconds(100));
+}
+
+StateCheckpoint::~StateCheckpoint() {
+    stop();
+}
+
+bool StateCheckpoint::restore() {
+    auto started = std::chrono::steady_clock::now();
+    int fd = ::open(options_.path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        if (errno != ENOENT) {
+            std::cerr << "[StateCheckpoint] Failed to open " << options_.path << ": " << strerror(errno) << std::endl;
+        }
+        return false;
+    }
+
+    struct stat st;
+    std::string data;
+    if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(FileHeader))) {
+        data.resize(static_cast<size_t>(st.st_size));
+        size_t offset = 0;
+        while (offset < data.size()) {
+            ssize_t bytes = ::read(fd, &data[offset], data.size() - offset);
+            if (bytes <= 0) {
+                break;
+            }
+            offset += static_cast<size_t>(bytes);
+        }
+        data.resize(offset);
+    }
+    ::close(fd);
+
+    FileHeader header{};
+    if (data.size() >= sizeof(header)) {
+        std::memcpy(&header, data.data(), sizeof(header));
+    }
+    const char* body = data.data() + sizeof(header);
+    if (data.size() < sizeof(header) || header.magic != MAGIC || header.version != VERSION ||
+        header.bodyLength != data.size() - sizeof(header) ||
+        crc32(0, body, static_cast<size_t>(header.bodyLength)) != header.checksum) {
+        std::cerr << "[StateCheckpoint] Ignoring invalid checkpoint " << options_.path << std::endl;
+        return false;
+    }
+
+    size_t restored = 0;
+    size_t discarded = 0;
+    StateReader reader(body, static_cast<size_t>(header.bodyLength));
+    std::string sensorId;
+    while (reader.remaining() > 0) {
+        uint32_t length = 0;
+        const char* state = nullptr;
+        if (!reader.readString(sensorId) || !reader.read(length) || !(state = reader.skip(length))) {
+            std::cerr << "[StateCheckpoint] Truncated record in " << options_.path << std::endl;
+            break;
+        }
+        if (pool_.restore(sensorId, state, length)) {
+            ++restored;
+        } else {
+            ++discarded;
+        }
+    }
+    generation_ = header.generation;
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+    std::cout << "[StateCheckpoint] Restored " << restored << " sensor(s) from " << options_.path << " ("
+              << data.size() << " bytes, generation " << header.generation << ") in " << elapsed.count() / 1000.0
+              << " ms";
+    if (discarded > 0) {
+        std::cout << ", discarded " << discarded << " incompatible with the current configuration";
+    }
+    std::cout << std::endl;
+    return restored > 0;
+}
+
+void StateCheckpoint::start() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    pool_.setSnapshotSink([this](size_t worker, uint64_t generation, std::string&& data) {
+        collect(worker, generation, std::move(data));
+    });
+    running_ = true;
+    thread_ = std::thread(&StateCheckpoint::run, this);
+    std::cout << "[StateCheckpoint] Writing " << options_.path << " every " << options_.interval.count() << " ms"
+              << std::endl;
+}
+
+void StateCheckpoint::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    condition_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool StateCheckpoint::writeFinal() {
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        generation = ++generation_;
+        parts_.assign(pool_.workerCount(), std::string());
+        received_ = 0;
+    }
+    // 线程池已停止，sink 在当前线程上被依次调用
+    pool_.snapshot(generation);
+    std::vector<std::string> parts;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (received_ != parts_.size()) {
+            return false;
+        }
+        parts.swap(parts_);
+    }
+    return write(generation, parts);
+}
+
+void StateCheckpoint::collect(size_t worker, uint64_t generation, std::string&& data) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 过期的快照（上一代超时后才到达）直接丢弃
+        if (generation != generation_ || worker >= parts_.size()) {
+            return;
+        }
+        parts_[worker] = std::move(data);
+        ++received_;
+    }
+    condition_.notify_all();
+}
+
+void StateCheckpoint::run() {
+    ThreadPlacement::getInstance().apply(ThreadRole::App, "algo-checkpoint");
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        if (condition_.wait_for(lock, options_.interval, [this]() { return !running_; })) {
+            break;
+        }
+
+        uint64_t generation = ++generation_;
+        parts_.assign(pool_.workerCount(), std::string());
+        received_ = 0;
+        lock.unlock();
+        pool_.requestSnapshot(generation);
+        lock.lock();
+
+        // 空闲的工作线程被唤醒后立即快照，繁忙的在当前批次结束后快照
+        bool complete = condition_.wait_for(lock, options_.interval, [this]() {
+            return !running_ || received_ == parts_.size();
+        });
+        if (!running_) {
+            break;
+        }
+        if (!complete) {
+            std::cerr << "[StateCheckpoint] Snapshot " << generation << " timed out (" << received_ << "/"
+                      << parts_.size() << " workers)" << std::endl;
+            continue;
+        }
+
+        // 写文件期间不持锁，迟到的快照不会阻塞在 sink 上
+        std::vector<std::string> parts;
+        parts.swap(parts_);
+        lock.unlock();
+        write(generation, parts);
+        lock.lock();
+    }
+}
+
+bool StateCheckpoint::write(uint64_t generation, const std::vector<std::string>& parts) {
+    FileHeader header{};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.generation = generation;
+    header.createdMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    header.checksum = 0;
+    for (const std::string& part : parts) {
+        header.bodyLength += part.size();
+        header.checksum = crc32(header.checksum, part.data(), part.size());
+    }
+
+    std::string temporary = options_.path + ".tmp";
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "[StateCheckpoint] Failed to create " << temporary << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    bool ok = writeAll(fd, reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const std::string& part : parts) {
+        ok = ok && writeAll(fd, part.data(), part.size());
+    }
+    ok = ok && fsync(fd) == 0;
+    ::close(fd);
+    if (!ok || std::rename(temporary.c_str(), options_.path.c_str()) != 0) {
+        std::cerr << "[StateCheckpoint] Failed to write " << options_.path << ": " << strerror(errno) << std::endl;
+        unlink(temporary.c_str());
+        return false;
+    }
+    checkpoints_.fetch_add(1);
+    return true;
+}
@@ -0,0 +1,286 @@
+// StreamingStats.cpp
+#include "StreamingStats.h"
+#include "StateCodec.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+void WelfordVariance::update(double value) {
+    ++count_;
+    double delta = value - mean_;
+    mean_ += delta / static_cast<double>(count_);
+    m2_ += delta * (value - mean_);
+}
+
+void WelfordVariance::merge(const WelfordVariance& other) {
+    if (other.count_ == 0) {
+        return;
+    }
+    if (count_ == 0) {
+        *this = other;
+        return;
+    }
+    double total = static_cast<double>(count_ + other.count_);
+    double delta = other.mean_ - mean_;
+    mean_ += delta * static_cast<double>(other.count_) / total;
+    m2_ += other.m2_ + delta * delta * static_cast<double>(count_) * static_cast<double>(other.count_) / total;
+    count_ += other.count_;
+}
+
+double WelfordVariance::variance() const {
+    return count_ > 1 ? m2_ / static_cast<double>(count_ - 1) : 0.0;
+}
+
+double WelfordVariance::stddev() const {
+    return std::sqrt(variance());
+}
+
+void WelfordVariance::save(StateWriter& writer) const {
+    writer.write(count_);
+    writer.write(mean_);
+    writer.write(m2_);
+}
+
+bool WelfordVariance::load(StateReader& reader) {
+    return reader.read(count_) && reader.read(mean_) && reader.read(m2_);
+}
+
+void Ewma::save(StateWriter& writer) const {
+    writer.write(value_);
+    writer.write(initialized_);
+}
+
+bool Ewma::load(StateReader& reader) {
+    return reader.read(value_) && reader.read(initialized_);
+}
+
+KllSketch::KllSketch(uint32_t k, uint64_t seed)
+    : k_(std::max(k, MIN_K)), rng_(seed ? seed : 1), count_(0), retained_(0), capacity_(0) {
+    clear();
+}
+
+void KllSketch::clear() {
+    count_ = 0;
+    retained_ = 0;
+    min_ = std::numeric_limits<double>::infinity();
+    max_ = -std::numeric_limits<double>::infinity();
+    levels_.assign(1, std::vector<double>());
+    updateCapacity();
+}
+
+void KllSketch::updateCapacity() {
+    // 顶层容量为 k，往下每层乘 2/3，最小为 2；只在层数变化时重新计算
+    capacities_.resize(levels_.size());
+    capacity_ = 0;
+    double capacity = static_cast<double>(k_);
+    for (size_t level = levels_.size(); level-- > 0;) {
+        capacities_[level] = std::max<uint32_t>(2, static_cast<uint32_t>(std::ceil(capacity)));
+        capacity_ += capacities_[level];
+        capacity *= 2.0 / 3.0;
+    }
+}
+
+bool KllSketch::nextBit() {
+    // xorshift64*，只用于选择保留奇数位还是偶数位
+    rng_ ^= rng_ >> 12;
+    rng_ ^= rng_ << 25;
+    rng_ ^= rng_ >> 27;
+    return ((rng_ * 0x2545F4914F6CDD1DULL) >> 63) != 0;
+}
+
+void KllSketch::update(double value) {
+    if (std::isnan(value)) {
+        return;
+    }
+    ++count_;
+    min_ = std::min(min_, value);
+    max_ = std::max(max_, value);
+    levels_[0].push_back(value);
+    if (++retained_ >= capacity_) {
+        compress();
+    }
+}
+
+void KllSketch::merge(const KllSketch& other) {
+    if (other.count_ == 0) {
+        return;
+    }
+    if (levels_.size() < other.levels_.size()) {
+        levels_.resize(other.levels_.size());
+        updateCapacity();
+    }
+    for (size_t level = 0; level < other.levels_.size(); ++level) {
+        levels_[level].insert(levels_[level].end(), other.levels_[level].begin(), other.levels_[level].end());
+    }
+    count_ += other.count_;
+    retained_ += other.retained_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    while (retained_ >= capacity_) {
+        compress();
+    }
+}
+
+void KllSketch::compress() {
+    // 压缩最低的超容量层：排序后两两配对，每对随机保留一个并提升到上一层（权重翻倍）
+    // 样本数为奇数时最小值留在本层，总权重保持不变
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        if (levels_[level].size() < capacities_[level]) {
+            continue;
+        }
+        if (level + 1 == levels_.size()) {
+            levels_.emplace_back();
+            updateCapacity();
+        }
+
+        std::vector<double>& items = levels_[level];
+        std::vector<double>& above = levels_[level + 1];
+        std::sort(items.begin(), items.end());
+        size_t start = items.size() % 2;
+        size_t offset = nextBit() ? 1 : 0;
+        for (size_t i = start + offset; i < items.size(); i += 2) {
+            above.push_back(items[i]);
+        }
+        retained_ -= (items.size() - start) / 2;
+        items.resize(start);
+        return;
+    }
+}
+
+void KllSketch::save(StateWriter& writer) const {
+    writer.write(k_);
+    writer.write(rng_);
+    writer.write(count_);
+    writer.write(min_);
+    writer.write(max_);
+    writer.write(static_cast<uint32_t>(levels_.size()));
+    for (const auto& level : levels_) {
+        writer.writeVector(level);
+    }
+}
+
+bool KllSketch::load(StateReader& reader) {
+    uint32_t k = 0;
+    uint32_t levelCount = 0;
+    if (!reader.read(k) || k != k_ || !reader.read(rng_) || !reader.read(count_) || !reader.read(min_) ||
+        !reader.read(max_) || !reader.read(levelCount) || levelCount == 0 || levelCount > MAX_LEVELS) {
+        clear();
+        return reader.fail();
+    }
+    levels_.resize(levelCount);
+    retained_ = 0;
+    for (auto& level : levels_) {
+        if (!reader.readVector(level)) {
+            clear();
+            return false;
+        }
+        retained_ += level.size();
+    }
+    updateCapacity();
+    while (retained_ >= capacity_) {
+        compress();
+    }
+    return true;
+}
+
+double KllSketch::quantile(double q) const {
+    double result = 0;
+    quantiles(&q, &result, 1);
+    return result;
+}
+
+void KllSketch::quantiles(const double* q, double* out, size_t count) const {
+    if (count_ == 0) {
+        std::fill(out, out + count, 0.0);
+        return;
+    }
+
+    sorted_.clear();
+    sorted_.reserve(retained_);
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        uint64_t weight = uint64_t(1) << level;
+        for (double value : levels_[level]) {
+            sorted_.emplace_back(value, weight);
+        }
+    }
+    std::sort(sorted_.begin(), sorted_.end(),
+              [](const std::pair<double, uint64_t>& a, const std::pair<double, uint64_t>& b) {
+                  return a.first < b.first;
+              });
+    uint64_t cumulative = 0;
+    for (auto& entry : sorted_) {
+        cumulative += entry.second;
+        entry.second = cumulative;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!(q[i] > 0.0)) {
+            out[i] = min_;
+            continue;
+        }
+        if (q[i] >= 1.0) {
+            out[i] = max_;
+            continue;
+        }
+        // 第一个累计权重达到目标秩的样本
+        uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q[i] * static_cast<double>(count_))));
+        auto it = std::lower_bound(sorted_.begin(), sorted_.end(), rank,
+                                   [](const std::pair<double, uint64_t>& entry, uint64_t target) {
+                                       return entry.second < target;
+                                   });
+        out[i] = it == sorted_.end() ? max_ : it->first;
+    }
+}
+
+StreamingStats::StreamingStats(const Options& options) {
+    if (!options.enabled) {
+        return;
+    }
+    metrics_.reserve(SlidingWindow::CHANNEL_COUNT);
+    for (size_t c = 0; c < SlidingWindow::CHANNEL_COUNT; ++c) {
+        metrics_.emplace_back(options.ewmaAlpha, options.sketchK, c + 1);
+    }
+}
+
+void StreamingStats::push(const SlidingWindow::Sample& sample) {
+    for (size_t c = 0; c < metrics_.size(); ++c) {
+        metrics_[c].update(sample.values[c]);
+    }
+}
+
+void StreamingStats::refreshQuantiles() {
+    for (size_t c = 0; c < metrics_.size(); ++c) {
+        metrics_[c].sketch.quantiles(PUBLISHED_QUANTILES.data(), quantiles_[c].data(), PUBLISHED_QUANTILES.size());
+    }
+}
+
+void MetricStats::save(StateWriter& writer) const {
+    ewma.save(writer);
+    variance.save(writer);
+    sketch.save(writer);
+}
+
+bool MetricStats::load(StateReader& reader) {
+    return ewma.load(reader) && variance.load(reader) && sketch.load(reader);
+}
+
+void StreamingStats::save(StateWriter& writer) const {
+    writer.write(static_cast<uint8_t>(metrics_.size()));
+    for (const auto& metric : metrics_) {
+        metric.save(writer);
+    }
+}
+
+bool StreamingStats::load(StateReader& reader) {
+    uint8_t count = 0;
+    if (!reader.read(count) || count != metrics_.size()) {
+        return reader.fail();
+    }
+    for (auto& metric : metrics_) {
+        if (!metric.load(reader)) {
+            return false;
+        }
+    }
+    refreshQuantiles();
+    return true;
+}
@@ -0,0 +1,153 @@
+// ComfortKernelTest.cpp
+// 用边界输入（NaN、符号零、非规格化数、无穷、警报等级分界点两侧）逐位比较 AVX2、SSE2 与标量实现；
+// 每个起始偏移和长度都跑一遍，覆盖未对齐访问和尾部标量处理
+#include "ComfortKernel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const char* what) {
+        if (!condition) {
+            std::cerr << "[ComfortKernelTest] FAILED: " << what << std::endl;
+            ++failures;
+        }
+    }
+
+    // 每个值及其上下相邻的 double，分界点两侧都能覆盖到
+    std::vector<double> withNeighbours(std::initializer_list<double> values) {
+        std::vector<double> result;
+        for (double value : values) {
+            result.push_back(value);
+            result.push_back(std::nextafter(value, -std::numeric_limits<double>::infinity()));
+            result.push_back(std::nextafter(value, std::numeric_limits<double>::infinity()));
+        }
+        return result;
+    }
+
+    std::vector<double> specials() {
+        const double inf = std::numeric_limits<double>::infinity();
+        const double nan = std::numeric_limits<double>::quiet_NaN();
+        const double denormal = std::numeric_limits<double>::denorm_min();
+        const double smallest = std::numeric_limits<double>::min();
+        return {0.0, -0.0, nan, -nan, inf, -inf, denormal, -denormal, smallest, -smallest, 1e300, -1e300};
+    }
+
+    // 其余两项取最佳值时，以下输入正好落在 80 / 60 / 40 分界上（温度每偏离 1 度扣 2 分，气压每偏离 1 hPa 扣 0.02 分）
+    std::vector<double> temperatures() {
+        std::vector<double> values = withNeighbours({22.0, 12.0, 32.0, 2.0, 42.0, -8.0, 52.0, 72.0, -28.0});
+        for (double value : specials()) {
+            values.push_back(value);
+        }
+        return values;
+    }
+
+    std::vector<double> humidities() {
+        std::vector<double> values = withNeighbours({50.0, 50.0 - 100.0 / 3.0, 50.0 + 100.0 / 3.0, 0.0, 100.0});
+        for (double value : specials()) {
+            values.push_back(value);
+        }
+        return values;
+    }
+
+    std::vector<double> pressures() {
+        std::vector<double> values = withNeighbours({1013.25, 13.25, 2013.25, -986.75, 3013.25, 4013.25});
+        for (double value : specials()) {
+            values.push_back(value);
+        }
+        return values;
+    }
+
+    bool sameBits(const std::vector<double>& a, const std::vector<double>& b, size_t first, size_t count) {
+        return count == 0 || std::memcmp(a.data() + first, b.data() + first, count * sizeof(double)) == 0;
+    }
+
+    bool sameAlerts(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, size_t first, size_t count) {
+        return count == 0 || std::memcmp(a.data() + first, b.data() + first, count) == 0;
+    }
+}
+
+int main() {
+    // 标量参考实现本身的分界判定
+    check(ComfortKernel::scoreOne(32.0, 50.0, 1013.25) == 80.0, "scoreOne at GOOD boundary");
+    check(ComfortKernel::alertOf(80.0) == ComfortKernel::ALERT_GOOD, "80 is GOOD");
+    check(ComfortKernel::alertOf(std::nextafter(80.0, 0.0)) == ComfortKernel::ALERT_MODERATE, "below 80 is MODERATE");
+    check(ComfortKernel::alertOf(60.0) == ComfortKernel::ALERT_MODERATE, "60 is MODERATE");
+    check(ComfortKernel::alertOf(std::nextafter(60.0, 0.0)) == ComfortKernel::ALERT_POOR, "below 60 is POOR");
+    check(ComfortKernel::alertOf(40.0) == ComfortKernel::ALERT_POOR, "40 is POOR");
+    check(ComfortKernel::alertOf(std::nextafter(40.0, 0.0)) == ComfortKernel::ALERT_CRITICAL, "below 40 is CRITICAL");
+    check(ComfortKernel::scoreOne(std::numeric_limits<double>::quiet_NaN(), 50.0, 1013.25) == 100.0, "NaN clamps to 100");
+
+    std::vector<double> temperature, humidity, pressure;
+    for (double t : temperatures()) {
+        for (double h : humidities()) {
+            for (double p : pressures()) {
+                temperature.push_back(t);
+                humidity.push_back(h);
+                pressure.push_back(p);
+            }
+        }
+    }
+    size_t total = temperature.size();
+
+    std::vector<double> expected(total);
+    std::vector<uint8_t> expectedAlert(total);
+    ComfortKernel::scoreWith(ComfortKernel::Isa::Scalar, temperature.data(), humidity.data(), pressure.data(), total,
+                             expected.data(), expectedAlert.data());
+
+    for (ComfortKernel::Isa isa : {ComfortKernel::Isa::SSE2, ComfortKernel::Isa::AVX2}) {
+        if (!ComfortKernel::isSupported(isa)) {
+            std::cout << "[ComfortKernelTest] " << ComfortKernel::isaName(isa) << " not supported, skipped" << std::endl;
+            continue;
+        }
+
+        std::vector<double> actual(total);
+        std::vector<uint8_t> actualAlert(total);
+        ComfortKernel::scoreWith(isa, temperature.data(), humidity.data(), pressure.data(), total,
+                                 actual.data(), actualAlert.data());
+        size_t mismatches = 0;
+        for (size_t i = 0; i < total; ++i) {
+            if (std::memcmp(&expected[i], &actual[i], sizeof(double)) != 0 || expectedAlert[i] != actualAlert[i]) {
+                if (++mismatches <= 10) {
+                    std::cerr << "[ComfortKernelTest] " << ComfortKernel::isaName(isa) << " differs at (" << temperature[i]
+                              << ", " << humidity[i] << ", " << pressure[i] << "): " << actual[i] << " vs "
+                              << expected[i] << std::endl;
+                }
+            }
+        }
+        check(mismatches == 0, "SIMD results bitwise equal to scalar");
+
+        // 不同起始偏移和长度：未对齐的加载/存储，以及 1 ~ 3 个元素的尾部
+        for (size_t first = 0; first < 8; ++first) {
+            for (size_t count = 0; count <= 9; ++count) {
+                std::fill(actual.begin(), actual.end(), -1.0);
+                std::fill(actualAlert.begin(), actualAlert.end(), 0xff);
+                ComfortKernel::scoreWith(isa, temperature.data() + first, humidity.data() + first,
+                                         pressure.data() + first, count, actual.data() + first, nullptr);
+                check(sameBits(expected, actual, first, count), "unaligned slice bitwise equal to scalar");
+                check(first + count >= total || actual[first + count] == -1.0, "no write past the slice");
+                ComfortKernel::scoreWith(isa, temperature.data() + first, humidity.data() + first,
+                                         pressure.data() + first, count, actual.data() + first,
+                                         actualAlert.data() + first);
+                check(sameAlerts(expectedAlert, actualAlert, first, count), "unaligned slice alerts equal to scalar");
+            }
+        }
+        std::cout << "[ComfortKernelTest] " << ComfortKernel::isaName(isa) << ": " << total << " inputs checked"
+                  << std::endl;
+    }
+
+    check(ComfortKernel::selfTest(), "selfTest passes for the active ISA");
+
+    if (failures > 0) {
+        std::cerr << "[ComfortKernelTest] " << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "[ComfortKernelTest] All checks passed" << std::endl;
+    return 0;
+}
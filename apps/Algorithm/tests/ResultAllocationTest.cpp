@@ -0,0 +1,153 @@
+// ResultAllocationTest.cpp
+// 替换全局 operator new 统计堆分配：预热后，稳态下的结果生成（死区判断 + 填充复用的 AlgorithmResult
+// + 序列化到复用的缓冲区，即 emitResults 在 EventBus::broadcast 之前的全部工作）必须不产生堆分配
+#include "ResultBuilder.h"
+#include "ComfortKernel.h"
+#include "ResultDeadband.h"
+#include "TypedTopic.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <unordered_map>
+
+namespace
+{
+    std::atomic<bool> counting{false};
+    std::atomic<uint64_t> allocations{0};
+
+    void* allocate(std::size_t size) {
+        if (counting.load(std::memory_order_relaxed)) {
+            allocations.fetch_add(1, std::memory_order_relaxed);
+        }
+        void* pointer = std::malloc(size == 0 ? 1 : size);
+        if (!pointer) {
+            throw std::bad_alloc();
+        }
+        return pointer;
+    }
+}
+
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return allocate(size);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept { return operator new(size, tag); }
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+
+namespace
+{
+    constexpr int ROUNDS = 100000;
+    constexpr size_t SENSORS = 8;
+
+    // 模拟 emitResults 的一个工作线程：按键保存死区状态，复用结果消息和序列化缓冲区
+    struct Emitter {
+        ResultBuilder builder;
+        ResultDeadband deadband{ResultDeadband::Options()};
+        std::unordered_map<const std::string*, ResultDeadband::State> keys;
+        AlgorithmResult result;
+        std::string buffer;
+        uint64_t published = 0;
+        const std::string* lastKey = nullptr;
+
+        void emit(const WindowRecord& record, std::chrono::steady_clock::time_point now) {
+            ResultDeadband::State& state = keys[record.key];
+            if (deadband.evaluate(state, record.comfortIndex, record.alert, record.late, now) ==
+                ResultDeadband::Decision::SUPPRESS) {
+                return;
+            }
+            builder.fill(record, 1700000000000, result);
+            PayloadCodec<AlgorithmResult>::encode(result, buffer);
+            published += buffer.empty() ? 0 : 1;
+            lastKey = record.key;
+        }
+    };
+
+    WindowRecord makeRecord(const std::string* key, int round, bool hasStats) {
+        WindowRecord record{};
+        record.key = key;
+        for (size_t c = 0; c < SlidingWindow::CHANNEL_COUNT; ++c) {
+            record.mean[c] = 20.0 + c + (round % 7) * 0.5;
+            record.min[c] = record.mean[c] - 1.0;
+            record.max[c] = record.mean[c] + 1.0;
+            record.stats[c].ewma = record.mean[c];
+            record.stats[c].stddev = 0.5;
+            record.stats[c].quantiles = {record.mean[c], record.max[c], record.max[c]};
+            record.stats[c].count = 1000;
+        }
+        record.count = 50;
+        record.samples = 1000;
+        record.start = 1700000000000;
+        record.end = 1700000005000;
+        record.late = round % 97 == 0;
+        record.hasStats = hasStats;
+        record.scored = true;
+        // 指数在各等级之间往返，同一键连续三轮取相同值，覆盖警报变化、数值变化和抑制三种路径
+        record.comfortIndex = 30.0 + (round / (SENSORS * 3) % 13) * 5.0;
+        record.alert = static_cast<uint8_t>(ComfortKernel::alertOf(record.comfortIndex));
+        return record;
+    }
+
+    bool steadyStateIsAllocationFree(bool hasStats) {
+        std::array<std::string, SENSORS> sensorIds;
+        for (size_t i = 0; i < SENSORS; ++i) {
+            // 超过短字符串优化长度，确保 result 中的字符串字段走堆缓冲区
+            sensorIds[i] = "sensor-with-a-long-name-" + std::to_string(i);
+        }
+        Emitter emitter;
+        auto now = std::chrono::steady_clock::now();
+
+        // 预热：建立每个键的状态、消息子对象和缓冲区容量；结果 ID 在测量期间保持相同位数
+        for (int round = 0; round < ROUNDS; ++round) {
+            now += std::chrono::milliseconds(50);
+            emitter.emit(makeRecord(&sensorIds[round % SENSORS], round, hasStats), now);
+        }
+
+        uint64_t publishedBefore = emitter.published;
+        allocations.store(0);
+        counting.store(true);
+        for (int round = 0; round < ROUNDS; ++round) {
+            now += std::chrono::milliseconds(50);
+            emitter.emit(makeRecord(&sensorIds[round % SENSORS], round, hasStats), now);
+        }
+        counting.store(false);
+
+        std::cout << "[ResultAllocationTest] stats " << (hasStats ? "on" : "off") << ": "
+                  << emitter.published - publishedBefore << " of " << ROUNDS << " results published, "
+                  << allocations.load() << " allocation(s)" << std::endl;
+        if (emitter.published == publishedBefore) {
+            std::cerr << "[ResultAllocationTest] FAILED: nothing was published" << std::endl;
+            return false;
+        }
+        if (!emitter.lastKey || emitter.result.sensor_id() != *emitter.lastKey) {
+            std::cerr << "[ResultAllocationTest] FAILED: sensor_id does not match the record key" << std::endl;
+            return false;
+        }
+        if (allocations.load() != 0) {
+            std::cerr << "[ResultAllocationTest] FAILED: steady-state result path allocated" << std::endl;
+            return false;
+        }
+        return true;
+    }
+}
+
+int main() {
+    bool withStats = steadyStateIsAllocationFree(true);
+    bool withoutStats = steadyStateIsAllocationFree(false);
+    if (!withStats || !withoutStats) {
+        return 1;
+    }
+    std::cout << "[ResultAllocationTest] All checks passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,119 @@
+// ResultDeadbandTest.cpp
+// ResultDeadband 决策表：每行给出距上次发布的时间、指数变化量、警报等级是否变化、是否迟到，以及期望的决策
+#include "ResultDeadband.h"
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace
+{
+    using Decision = ResultDeadband::Decision;
+    using Clock = std::chrono::steady_clock;
+
+    int failures = 0;
+
+    const char* nameOf(Decision decision) {
+        switch (decision) {
+            case Decision::SUPPRESS: return "SUPPRESS";
+            case Decision::FIRST: return "FIRST";
+            case Decision::ALERT_CHANGE: return "ALERT_CHANGE";
+            case Decision::VALUE_CHANGE: return "VALUE_CHANGE";
+            case Decision::LATE_UPDATE: return "LATE_UPDATE";
+            case Decision::HEARTBEAT: return "HEARTBEAT";
+        }
+        return "?";
+    }
+
+    struct Row {
+        const char* name;
+        int elapsedMs;   // 距上次发布
+        double delta;    // 相对上次发布的指数变化
+        bool alertChange;
+        bool late;
+        Decision expected;
+    };
+
+    // 缺省选项：epsilon 1.0，min_interval 100 ms，max_interval 10000 ms
+    const Row TABLE[] = {
+        {"no change inside min_interval", 10, 0.0, false, false, Decision::SUPPRESS},
+        {"value change inside min_interval", 10, 5.0, false, false, Decision::SUPPRESS},
+        {"alert change inside min_interval", 10, 0.0, true, false, Decision::ALERT_CHANGE},
+        {"late update inside min_interval", 10, 0.0, false, true, Decision::LATE_UPDATE},
+        {"alert change and late inside min_interval", 10, 5.0, true, true, Decision::ALERT_CHANGE},
+        {"no change after min_interval", 200, 0.0, false, false, Decision::SUPPRESS},
+        {"change within epsilon", 200, 1.0, false, false, Decision::SUPPRESS},
+        {"change beyond epsilon", 200, 1.5, false, false, Decision::VALUE_CHANGE},
+        {"NaN index counts as change", 200, std::numeric_limits<double>::quiet_NaN(), false, false,
+         Decision::VALUE_CHANGE},
+        {"value change exactly at min_interval", 100, 5.0, false, false, Decision::VALUE_CHANGE},
+        {"alert change after min_interval", 200, 5.0, true, false, Decision::ALERT_CHANGE},
+        {"late update after min_interval", 200, 0.0, false, true, Decision::LATE_UPDATE},
+        {"no change before max_interval", 9999, 0.0, false, false, Decision::SUPPRESS},
+        {"no change at max_interval", 10000, 0.0, false, false, Decision::HEARTBEAT},
+    };
+
+    void check(bool condition, const std::string& what) {
+        if (!condition) {
+            std::cerr << "[ResultDeadbandTest] FAILED: " << what << std::endl;
+            ++failures;
+        }
+    }
+
+    void runTable() {
+        ResultDeadband deadband{ResultDeadband::Options()};
+        for (const Row& row : TABLE) {
+            ResultDeadband::State state;
+            Clock::time_point start = Clock::now();
+            check(deadband.evaluate(state, 70.0, 1, false, start) == Decision::FIRST, std::string(row.name) + ": first");
+
+            uint8_t alert = row.alertChange ? 2 : 1;
+            Clock::time_point now = start + std::chrono::milliseconds(row.elapsedMs);
+            Decision decision = deadband.evaluate(state, 70.0 + row.delta, alert, row.late, now);
+            check(decision == row.expected, std::string(row.name) + ": got " + nameOf(decision) + ", expected " +
+                                                nameOf(row.expected));
+
+            // 发布时 state 记录新的基准，抑制时保持不变
+            bool published = decision != Decision::SUPPRESS;
+            check(state.lastPublish == (published ? now : start), std::string(row.name) + ": lastPublish");
+            check(state.alert == (published ? alert : 1), std::string(row.name) + ": alert baseline");
+        }
+    }
+
+    // 被抑制的数值变化在 min_interval 过后的下一个结果中发布，比较基准是上一次发布的值
+    void suppressedChangeIsPublishedLater() {
+        ResultDeadband deadband{ResultDeadband::Options()};
+        ResultDeadband::State state;
+        Clock::time_point start = Clock::now();
+        deadband.evaluate(state, 70.0, 1, false, start);
+        check(deadband.evaluate(state, 75.0, 1, false, start + std::chrono::milliseconds(50)) == Decision::SUPPRESS,
+              "change inside min_interval suppressed");
+        check(deadband.evaluate(state, 75.0, 1, false, start + std::chrono::milliseconds(150)) == Decision::VALUE_CHANGE,
+              "suppressed change published after min_interval");
+        check(state.comfortIndex == 75.0, "baseline moves to the published value");
+    }
+
+    void disabledPublishesEverything() {
+        ResultDeadband::Options options;
+        options.enabled = false;
+        ResultDeadband deadband(options);
+        ResultDeadband::State state;
+        Clock::time_point now = Clock::now();
+        for (int i = 0; i < 3; ++i) {
+            check(deadband.evaluate(state, 70.0, 1, false, now) == Decision::FIRST, "disabled deadband publishes");
+        }
+    }
+}
+
+int main() {
+    runTable();
+    suppressedChangeIsPublishedLater();
+    disabledPublishesEverything();
+
+    if (failures > 0) {
+        std::cerr << "[ResultDeadbandTest] " << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "[ResultDeadbandTest] All checks passed" << std::endl;
+    return 0;
+}
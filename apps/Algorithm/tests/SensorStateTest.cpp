@@ -0,0 +1,87 @@
+// SensorStateTest.cpp
+// 非有限样本不能进入传感器状态：否则窗口滚动和在样本移出后仍为 NaN，均值与舒适度指数永久失效；
+// 传感器数达到上限后新传感器的样本被丢弃，已有传感器照常处理
+#include "SensorWorkerPool.h"
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <string>
+
+namespace
+{
+    int failures = 0;
+
+    void check(bool condition, const std::string& what) {
+        if (!condition) {
+            std::cerr << "[SensorStateTest] FAILED: " << what << std::endl;
+            ++failures;
+        }
+    }
+
+    SlidingWindow::Sample sampleOf(int64_t timestamp, double temperature) {
+        SlidingWindow::Sample sample;
+        sample.timestamp = timestamp;
+        sample.values = {temperature, 50.0, 1013.25};
+        return sample;
+    }
+
+    // 10 个正常样本、1 个坏样本、再 20000 个正常样本（窗口 5，跨过多次 rebase）
+    void badSampleDoesNotPoisonState(const char* name, double bad) {
+        SensorWorkerPool::SensorState::Options options;
+        options.windowSize = 5;
+        SensorWorkerPool::SensorState state(options);
+        int64_t timestamp = 0;
+        for (int i = 0; i < 10; ++i) {
+            check(state.push(sampleOf(++timestamp, 20.0)), std::string(name) + ": good sample accepted");
+        }
+        check(!state.push(sampleOf(++timestamp, bad)), std::string(name) + ": bad sample rejected");
+        for (int i = 0; i < 20000; ++i) {
+            state.push(sampleOf(++timestamp, 20.0));
+        }
+
+        double mean = state.window.mean(SlidingWindow::TEMPERATURE);
+        check(mean == 20.0, std::string(name) + ": window mean " + std::to_string(mean));
+        check(state.window.variance(SlidingWindow::TEMPERATURE) == 0.0, std::string(name) + ": window variance");
+        check(state.window.min(SlidingWindow::TEMPERATURE) == 20.0 && state.window.max(SlidingWindow::TEMPERATURE) == 20.0,
+              std::string(name) + ": window extrema");
+        const MetricStats& stats = state.stats.metric(SlidingWindow::TEMPERATURE);
+        check(std::isfinite(stats.ewma.value()) && std::isfinite(stats.variance.mean()),
+              std::string(name) + ": streaming stats finite");
+        check(stats.variance.count() == 20010, std::string(name) + ": bad sample not counted");
+    }
+
+    void sensorLimitDropsNewSensors() {
+        SensorWorkerPool::SensorState::Options options;
+        options.windowSize = 5;
+        SensorWorkerPool pool(2, options, [](size_t, const std::vector<SensorWorkerPool::Touched>&) {});
+        pool.setMaxSensors(3);
+        pool.start();
+        int64_t timestamp = 0;
+        for (int round = 0; round < 10; ++round) {
+            for (int sensor = 0; sensor < 5; ++sensor) {
+                pool.submit("sensor-" + std::to_string(sensor), sampleOf(++timestamp, 20.0));
+            }
+        }
+        pool.stop();
+
+        check(pool.sensorCount() == 3, "sensor count capped at 3, got " + std::to_string(pool.sensorCount()));
+        check(pool.rejectedCount() == 20, "samples from 2 extra sensors rejected, got " +
+              std::to_string(pool.rejectedCount()));
+        check(pool.processedCount() == 30, "samples from admitted sensors processed, got " +
+              std::to_string(pool.processedCount()));
+    }
+}
+
+int main() {
+    badSampleDoesNotPoisonState("NaN", std::numeric_limits<double>::quiet_NaN());
+    badSampleDoesNotPoisonState("+Inf", std::numeric_limits<double>::infinity());
+    badSampleDoesNotPoisonState("-Inf", -std::numeric_limits<double>::infinity());
+    sensorLimitDropsNewSensors();
+
+    if (failures > 0) {
+        std::cerr << "[SensorStateTest] " << failures << " check(s) failed" << std::endl;
+        return 1;
+    }
+    std::cout << "[SensorStateTest] All checks passed" << std::endl;
+    return 0;
+}
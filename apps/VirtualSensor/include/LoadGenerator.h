@@ -0,0 +1,156 @@
+// LoadGenerator.h
+#pragma once
+#include "SensorCodec.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sensor
+{
+    // xoshiro256+ 的 4 路并行版本：状态按通道交错存放（SoA），
+    // 每一步对 4 个独立序列执行相同的运算，编译器可以直接向量化为 SIMD 指令
+    class Xoshiro256x4 {
+    public:
+        static constexpr size_t LANES = 4;
+
+        explicit Xoshiro256x4(uint64_t seed = 0) { reseed(seed); }
+
+        // 用 splitmix64 展开种子，保证各通道状态非零且互不相关
+        void reseed(uint64_t seed) {
+            for (size_t word = 0; word < 4; ++word) {
+                for (size_t lane = 0; lane < LANES; ++lane) {
+                    state_[word][lane] = splitmix64(seed);
+                }
+            }
+        }
+
+        void next(uint64_t out[LANES]) {
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                out[lane] = state_[0][lane] + state_[3][lane];
+                uint64_t t = state_[1][lane] << 17;
+                state_[2][lane] ^= state_[0][lane];
+                state_[3][lane] ^= state_[1][lane];
+                state_[1][lane] ^= state_[2][lane];
+                state_[0][lane] ^= state_[3][lane];
+                state_[2][lane] ^= t;
+                state_[3][lane] = (state_[3][lane] << 45) | (state_[3][lane] >> 19);
+            }
+        }
+
+        // [0, 1) 均匀分布，取高 53 位
+        void uniform(double out[LANES]) {
+            uint64_t bits[LANES];
+            next(bits);
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                out[lane] = static_cast<double>(bits[lane] >> 11) * 0x1.0p-53;
+            }
+        }
+
+        // 近似标准正态：4 个均匀数之和（Irwin-Hall）归一化，全程无分支、无超越函数
+        void gaussian(double out[LANES]) {
+            double sum[LANES] = {};
+            double u[LANES];
+            for (int k = 0; k < 4; ++k) {
+                uniform(u);
+                for (size_t lane = 0; lane < LANES; ++lane) {
+                    sum[lane] += u[lane];
+                }
+            }
+            for (size_t lane = 0; lane < LANES; ++lane) {
+                out[lane] = (sum[lane] - 2.0) * 1.7320508075688772;  // sqrt(3)
+            }
+        }
+
+        static uint64_t splitmix64(uint64_t& x) {
+            uint64_t z = (x += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+    private:
+        alignas(32) uint64_t state_[4][LANES];
+    };
+
+    // 传感器行为模板，按权重分配给各传感器
+    //   rate_hz - 每个传感器的发送频率
+    //   drift   - 每秒漂移量（三个通道各自的单位），到达正常范围边界后反向
+    //   noise   - 高斯噪声标准差
+    struct SensorProfile {
+        std::string name = "default";
+        double weight = 1.0;
+        double rateHz = 1.0;
+        double drift = 0.01;
+        double noise = 0.1;
+    };
+
+    // 多传感器负载生成器：传感器按编号均分给若干生成线程，
+    // 每个线程独占自己的分片状态和随机数发生器，线程间不共享可变数据
+    // 各分片按 (到期时间, 编号) 的顺序发送，噪声的抽取顺序与调度抖动无关：
+    // 相同 seed 下各传感器的基准值、模板和相位与线程数无关；噪声序列在 seed 与线程数都相同时可复现
+    class LoadGenerator {
+    public:
+        // 由生成线程调用，需线程安全
+        using Publisher = std::function<void(const std::string& sensorId, const std::string& payload)>;
+
+        struct Options {
+            size_t sensors = 10000;
+            int threads = 1;
+            uint64_t seed = 1;
+            int tickMs = 10;
+            std::string prefix = "LOAD_";
+            SensorEncoding encoding = SensorEncoding::Binary;
+            std::vector<SensorProfile> profiles;
+        };
+
+        LoadGenerator(const Options& options, Publisher publisher);
+        ~LoadGenerator();
+
+        LoadGenerator(const LoadGenerator&) = delete;
+        LoadGenerator& operator=(const LoadGenerator&) = delete;
+
+        void start();
+        void stop();
+
+        std::string sensorName(size_t index) const;
+        size_t sensorCount() const { return options_.sensors; }
+
+        // 自上次调用以来发送的样本数
+        uint64_t takeSentCount();
+
+    private:
+        // 单个线程负责的一段传感器，所有字段按列存放
+        struct Shard {
+            size_t first = 0;
+            std::vector<std::string> names;
+            std::vector<uint32_t> keys;
+            std::vector<uint8_t> binary;    // ID 与其他传感器冲突时为 0，改用 Protobuf 发布
+            std::vector<double> level[3];   // 温度、湿度、气压的当前值（不含噪声）
+            std::vector<double> drift[3];   // 每秒漂移量，带符号
+            std::vector<double> noise;
+            std::vector<int64_t> periodUs;
+            std::vector<int64_t> lastUs;
+            std::vector<std::pair<int64_t, uint32_t>> schedule;  // 最小堆：(下次到期时间, 分片内下标)
+            Xoshiro256x4 rng;
+            std::thread thread;
+        };
+
+        void buildShard(Shard& shard, size_t first, size_t count, size_t shardIndex);
+        void shardLoop(size_t shardIndex);
+        size_t pickProfile(double u) const;
+
+        Options options_;
+        Publisher publisher_;
+        std::vector<Shard> shards_;
+        double totalWeight_;
+        std::atomic<bool> running_;
+        std::atomic<uint64_t> sent_;
+
+        static constexpr double RANGE_MIN[3] = {18.0, 30.0, 980.0};
+        static constexpr double RANGE_MAX[3] = {28.0, 80.0, 1030.0};
+    };
+}
@@ -0,0 +1,298 @@
+// SensorCodec.h
+#pragma once
+#include "AppTemplate.h"
+#include "Topics.h"
+#include "sensor_data.pb.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <shared_mutex>
+#include <iostream>
+#include <type_traits>
+
+// 传感器数据的两种编码：
+//   Protobuf - SensorData 消息（默认，兼容旧版本）
+//   Binary   - 固定布局小端记录，接收端直接在接收缓冲区上读取字段，无需解码
+// 接收端通过 SensorSample 按魔数自动识别编码，两种发布端可以混用
+namespace sensor
+{
+    enum class SensorEncoding {
+        Protobuf,
+        Binary
+    };
+
+    // 线上布局（小端，48 字节，字段自然对齐）
+    struct SensorRecord {
+        uint32_t magic;        // RECORD_MAGIC
+        uint16_t version;      // RECORD_VERSION
+        uint16_t flags;        // 保留
+        uint32_t sensorKey;    // 传感器 ID 的 32 位驻留值，名称通过 "sensor.ids" 主题解析
+        uint32_t reserved;
+        int64_t timestamp;
+        double temperature;
+        double humidity;
+        double pressure;
+
+        static constexpr uint32_t RECORD_MAGIC = 0x43455253;  // "SREC"
+        static constexpr uint16_t RECORD_VERSION = 1;
+    };
+    static_assert(sizeof(SensorRecord) == 48, "SensorRecord wire layout changed");
+    static_assert(std::is_trivially_copyable_v<SensorRecord>, "SensorRecord must be trivially copyable");
+
+    namespace detail
+    {
+        // 按小端读写，小端主机上编译为普通 load/store，不要求对齐
+        template <typename T>
+        inline T loadLE(const char* data) {
+            T value;
+            std::memcpy(&value, data, sizeof(T));
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            char* bytes = reinterpret_cast<char*>(&value);
+            for (size_t i = 0; i < sizeof(T) / 2; ++i) {
+                std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+            }
+#endif
+            return value;
+        }
+
+        template <typename T>
+        inline void storeLE(char* data, T value) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            char* bytes = reinterpret_cast<char*>(&value);
+            for (size_t i = 0; i < sizeof(T) / 2; ++i) {
+                std::swap(bytes[i], bytes[sizeof(T) - 1 - i]);
+            }
+#endif
+            std::memcpy(data, &value, sizeof(T));
+        }
+    }
+
+    // 传感器 ID 驻留表：ID 使用名称的 FNV-1a 哈希，各发布端无需协调即可得到一致的值
+    // 两个名称哈希冲突时先定义者保留该 ID，后者不能使用二进制编码（回退到 Protobuf）
+    class SensorIdRegistry {
+    public:
+        static SensorIdRegistry& getInstance() {
+            static SensorIdRegistry instance;
+            return instance;
+        }
+
+        static uint32_t hash(const std::string& name) {
+            uint32_t value = 2166136261u;
+            for (unsigned char c : name) {
+                value = (value ^ c) * 16777619u;
+            }
+            return value;
+        }
+
+        uint32_t intern(const std::string& name) {
+            uint32_t key = hash(name);
+            define(key, name);
+            return key;
+        }
+
+        // 名称独占其哈希 ID 时返回 true，可以用二进制编码发布
+        bool tryIntern(const std::string& name, uint32_t& key) {
+            key = hash(name);
+            return define(key, name);
+        }
+
+        // ID 已被其他名称占用时记录冲突并返回 false，已有映射不变
+        bool define(uint32_t key, const std::string& name) {
+            {
+                std::shared_lock<std::shared_mutex> lock(mutex_);
+                auto it = names_.find(key);
+                if (it != names_.end() && it->second == name) {
+                    return true;
+                }
+            }
+            std::unique_lock<std::shared_mutex> lock(mutex_);
+            auto result = names_.emplace(key, name);
+            if (!result.second && result.first->second != name) {
+                std::cerr << "[SensorIdRegistry] ID " << key << " collision: '" << name
+                          << "' conflicts with '" << result.first->second << "'" << std::endl;
+                return false;
+            }
+            return true;
+        }
+
+        // 未知 ID（映射尚未收到或冲突）的占位名称 "#xxxxxxxx"，不同 ID 不会合并到同一名称下
+        static std::string placeholderName(uint32_t key) {
+            static const char digits[] = "0123456789abcdef";
+            std::string name(9, '#');
+            for (int i = 0; i < 8; ++i) {
+                name[8 - i] = digits[(key >> (i * 4)) & 0xf];
+            }
+            return name;
+        }
+
+        // 返回的引用在进程生命周期内有效；未知 ID 返回空字符串
+        const std::string& name(uint32_t key) const {
+            static const std::string unknown;
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            auto it = names_.find(key);
+            return it != names_.end() ? it->second : unknown;
+        }
+
+    private:
+        SensorIdRegistry() = default;
+
+        std::unordered_map<uint32_t, std::string> names_;
+        mutable std::shared_mutex mutex_;
+    };
+
+    class SensorCodec {
+    public:
+        static bool isBinary(const char* data, size_t size) {
+            return size == sizeof(SensorRecord) &&
+                   detail::loadLE<uint32_t>(data + offsetof(SensorRecord, magic)) == SensorRecord::RECORD_MAGIC;
+        }
+
+        static std::string encodeBinary(uint32_t sensorKey, int64_t timestamp,
+                                        double temperature, double humidity, double pressure) {
+            std::string out;
+            encodeBinary(out, sensorKey, timestamp, temperature, humidity, pressure);
+            return out;
+        }
+
+        // 覆盖 out 的内容，容量足够时不分配
+        static void encodeBinary(std::string& out, uint32_t sensorKey, int64_t timestamp,
+                                 double temperature, double humidity, double pressure) {
+            out.assign(sizeof(SensorRecord), '\0');
+            char* data = &out[0];
+            detail::storeLE<uint32_t>(data + offsetof(SensorRecord, magic), SensorRecord::RECORD_MAGIC);
+            detail::storeLE<uint16_t>(data + offsetof(SensorRecord, version), SensorRecord::RECORD_VERSION);
+            detail::storeLE<uint32_t>(data + offsetof(SensorRecord, sensorKey), sensorKey);
+            detail::storeLE<int64_t>(data + offsetof(SensorRecord, timestamp), timestamp);
+            detail::storeLE<double>(data + offsetof(SensorRecord, temperature), temperature);
+            detail::storeLE<double>(data + offsetof(SensorRecord, humidity), humidity);
+            detail::storeLE<double>(data + offsetof(SensorRecord, pressure), pressure);
+        }
+
+        static std::string encode(const SensorData& data, SensorEncoding encoding) {
+            uint32_t key = 0;
+            if (encoding == SensorEncoding::Protobuf ||
+                !SensorIdRegistry::getInstance().tryIntern(data.sensor_id(), key)) {
+                return data.SerializeAsString();
+            }
+            return encodeBinary(key, data.timestamp(), data.temperature(), data.humidity(), data.pressure());
+        }
+
+        static bool parseEncoding(const std::string& name, SensorEncoding& encoding) {
+            if (name == "binary") {
+                encoding = SensorEncoding::Binary;
+                return true;
+            }
+            if (name == "protobuf") {
+                encoding = SensorEncoding::Protobuf;
+                return true;
+            }
+            return false;
+        }
+    };
+
+    // 订阅端负载类型：二进制记录直接引用接收缓冲区，Protobuf 则解码到内部消息
+    // 访问器与 SensorData 同名；二进制模式下只在处理器调用期间有效，需要保存时复制字段（toProto() 会分配）
+    class SensorSample {
+    public:
+        bool decode(const std::string& data) {
+            if (SensorCodec::isBinary(data.data(), data.size())) {
+                if (detail::loadLE<uint16_t>(data.data() + offsetof(SensorRecord, version)) != SensorRecord::RECORD_VERSION) {
+                    return false;
+                }
+                record_ = data.data();
+                return true;
+            }
+            record_ = nullptr;
+            return proto_.ParseFromString(data);
+        }
+
+        bool isBinary() const { return record_ != nullptr; }
+
+        uint32_t sensor_key() const {
+            return record_ ? field<uint32_t>(offsetof(SensorRecord, sensorKey))
+                           : SensorIdRegistry::hash(proto_.sensor_id());
+        }
+        const std::string& sensor_id() const {
+            return record_ ? SensorIdRegistry::getInstance().name(sensor_key()) : proto_.sensor_id();
+        }
+        // 用于分片和存储的名称：ID 未知时把占位名称写入 placeholder 并返回它（不超过 SSO 长度，不分配）
+        const std::string& sensor_name(std::string& placeholder) const {
+            const std::string& id = sensor_id();
+            if (!record_ || !id.empty()) {
+                return id;
+            }
+            placeholder = SensorIdRegistry::placeholderName(sensor_key());
+            return placeholder;
+        }
+        double temperature() const {
+            return record_ ? field<double>(offsetof(SensorRecord, temperature)) : proto_.temperature();
+        }
+        double humidity() const {
+            return record_ ? field<double>(offsetof(SensorRecord, humidity)) : proto_.humidity();
+        }
+        double pressure() const {
+            return record_ ? field<double>(offsetof(SensorRecord, pressure)) : proto_.pressure();
+        }
+        int64_t timestamp() const {
+            return record_ ? field<int64_t>(offsetof(SensorRecord, timestamp)) : proto_.timestamp();
+        }
+
+        SensorData toProto() const {
+            if (!record_) {
+                return proto_;
+            }
+            SensorData data;
+            data.set_sensor_id(sensor_id());
+            data.set_temperature(temperature());
+            data.set_humidity(humidity());
+            data.set_pressure(pressure());
+            data.set_timestamp(timestamp());
+            return data;
+        }
+
+    private:
+        template <typename T>
+        T field(size_t offset) const {
+            return detail::loadLE<T>(record_ + offset);
+        }
+
+        const char* record_ = nullptr;
+        SensorData proto_;
+    };
+
+    // 发布端：二进制模式下通过保留消息公布 ID -> 名称映射，晚加入的订阅者也能解析
+    // ID 冲突时不公布，该传感器以 Protobuf 发布，返回 false
+    inline bool announceSensorId(AppTemplate& app, const std::string& sensorId) {
+        uint32_t key = 0;
+        if (!SensorIdRegistry::getInstance().tryIntern(sensorId, key)) {
+            return false;
+        }
+        app.broadcast(topics::SENSOR_IDS, sensorId, std::to_string(key));
+        return true;
+    }
+
+    // 订阅端：接收 ID 映射
+    inline void subscribeSensorIds(AppTemplate& app) {
+        app.registerHandler(topics::SENSOR_IDS, [](const std::string&, const std::string& name) {
+            SensorIdRegistry::getInstance().intern(name);
+        });
+    }
+}
+
+// SensorSample 通过 TypedTopic 的编解码扩展点接入
+template <>
+struct PayloadCodec<sensor::SensorSample> {
+    static bool decode(const std::string& data, sensor::SensorSample& payload) {
+        return payload.decode(data);
+    }
+    static std::string encode(const sensor::SensorSample& payload) {
+        return sensor::SensorCodec::encodeBinary(payload.sensor_key(), payload.timestamp(),
+                                                 payload.temperature(), payload.humidity(), payload.pressure());
+    }
+    static void encode(const sensor::SensorSample& payload, std::string& out) {
+        sensor::SensorCodec::encodeBinary(out, payload.sensor_key(), payload.timestamp(),
+                                          payload.temperature(), payload.humidity(), payload.pressure());
+    }
+};
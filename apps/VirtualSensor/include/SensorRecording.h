@@ -0,0 +1,103 @@
+// SensorRecording.h
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// 传感器流量录制/回放文件（小端）：
+//   文件头：magic "SRPL" u32 | version u16 | reserved u16 | 录制开始时间（微秒，墙钟）i64
+//   记录：  varint 距上一条的间隔（微秒）| 主题 | 键 | varint 负载长度 | 负载
+//   主题和键使用字符串表：varint 0 后跟 varint 长度 + 字节表示新字符串（依次编号），
+//   非 0 值 n 表示引用第 n 个字符串。传感器 ID 和主题在每条记录中只占 1~3 字节
+namespace sensor
+{
+    class SensorRecorder {
+    public:
+        SensorRecorder() = default;
+        ~SensorRecorder();
+
+        SensorRecorder(const SensorRecorder&) = delete;
+        SensorRecorder& operator=(const SensorRecorder&) = delete;
+
+        bool open(const std::string& path);
+        void close();
+        bool isOpen() const { return fd_ >= 0; }
+
+        // 线程安全，间隔以调用时刻计算
+        void record(const std::string& topic, const std::string& key, const std::string& payload);
+
+        uint64_t recordCount() const { return records_; }
+
+    private:
+        void appendString(const std::string& value);
+        bool flushLocked();
+
+        static constexpr size_t FLUSH_THRESHOLD = 1024 * 1024;
+
+        std::mutex mutex_;
+        int fd_ = -1;
+        std::string path_;
+        std::string buffer_;
+        std::unordered_map<std::string, uint64_t> strings_;
+        int64_t lastUs_ = 0;
+        uint64_t records_ = 0;
+    };
+
+    class SensorReplayer {
+    public:
+        struct Options {
+            std::string path;
+            double speed = 1.0;     // 回放倍速，<= 0 表示不等待、尽快发送
+            int64_t maxGapMs = 0;   // > 0 时将超过该值的间隔压缩为该值
+            bool loop = false;      // 到达文件末尾后从头开始
+        };
+
+        using Publisher = std::function<void(const std::string& topic, const std::string& payload, const std::string& key)>;
+
+        SensorReplayer(const Options& options, Publisher publisher);
+        ~SensorReplayer();
+
+        SensorReplayer(const SensorReplayer&) = delete;
+        SensorReplayer& operator=(const SensorReplayer&) = delete;
+
+        // 映射并校验文件头
+        bool open();
+        void start();
+        void stop();
+
+        bool isFinished() const { return finished_.load(); }
+        uint64_t replayedCount() const { return replayed_.load(); }
+
+    private:
+        struct Cursor {
+            const char* data;
+            const char* end;
+            std::vector<std::string> strings;
+        };
+
+        void replayLoop();
+        bool replayPass();
+        bool readRecord(Cursor& cursor, uint64_t& deltaUs, const std::string*& topic,
+                        const std::string*& key, std::string& payload);
+        bool readString(Cursor& cursor, size_t& index);
+        bool waitUntil(std::chrono::steady_clock::time_point deadline);
+
+        Options options_;
+        Publisher publisher_;
+        char* data_;
+        size_t size_;
+        std::thread thread_;
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        std::atomic<bool> running_;
+        std::atomic<bool> finished_;
+        std::atomic<uint64_t> replayed_;
+    };
+}
@@ -0,0 +1,13 @@
+// Topics.h
+#pragma once
+
+// 应用之间约定的主题名，VirtualSensor / Algorithm / WebApp 共用；负载类型由各应用结合 proto 声明：
+//   using SensorDataTopic = Topic<topics::SENSOR_DATA, SensorData>;
+// EventBus 库（TypedTopic.h）只提供 Topic<> / PayloadCodec 机制，不包含具体应用的主题
+namespace topics {
+    inline constexpr char SENSOR_DATA[] = "sensor.data";
+    inline constexpr char ALGORITHM_RESULT[] = "algorithm.result";
+    inline constexpr char SENSOR_IDS[] = "sensor.ids";
+    inline constexpr char SENSOR_BATCH[] = "sensor.batch";
+    inline constexpr char ALGORITHM_ANOMALY[] = "algorithm.anomaly";
+}
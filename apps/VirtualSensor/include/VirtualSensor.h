@@ -1,11 +1,20 @@
 #pragma once
 #include "AppTemplate.h"
 #include "sensor_data.pb.h"
+#include "SensorCodec.h"
+#include "Topics.h"
+#include "LoadGenerator.h"
+#include "SensorRecording.h"
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <memory>
 
 namespace sensor
 {
+    using SensorDataTopic = Topic<topics::SENSOR_DATA, SensorData>;
+    using SensorBatchTopic = Topic<topics::SENSOR_BATCH, SensorBatch>;
+
     class VirtualSensor : public AppTemplate
     {
     public:
@@ -18,11 +27,54 @@ namespace sensor
         void cleanup() override;
 
     private:
+        void loadSamplingConfig();
+
+        // 所有发出的事件都经过这里，录制开启时同时写入录制文件
+        void emit(const std::string& eventType, const std::string& data, const std::string& key);
+        void announce(const std::string& sensorId);
+
+        // "sensor": { "record": "sensor.rec" } 录制；"mode": "replay" 回放
+        void openRecorder();
+        bool openReplayer();
         void generateSensorData();
         SensorData createRandomSensorData();
+        void sampleValues(double& temperature, double& humidity, double& pressure);
+
+        // 批量模式：按采样率补齐到当前时刻的样本，按数量或时间刷新
+        void acquireBatch();
+        void flushBatch();
+        void reportBatchRate();
+
+        // 负载模式：模拟大量传感器，由 LoadGenerator 的线程直接发布
+        LoadGenerator::Options loadGeneratorOptions() const;
+        void startLoadGenerator();
+        void reportLoadRate();
 
-        std::thread sensorThread_;
-        std::atomic<bool> generating_;
+        EventLoop::TimerId sampleTimer_;
+        EventLoop::TimerId reportTimer_;
         std::string sensorId_;
+        SensorEncoding encoding_;
+
+        // "sensor": { "mode": "batch", "sample_rate_hz": 100000, "batch_size": 1000, "batch_max_age_ms": 50 }
+        std::string mode_;
+        bool batchMode_;
+        double sampleRateHz_;
+        size_t batchSize_;
+        int batchMaxAgeMs_;
+
+        SensorBatch batch_;
+        std::chrono::steady_clock::time_point acquisitionStart_;
+        std::chrono::steady_clock::time_point batchOpened_;
+        int64_t acquisitionStartUs_;
+        uint64_t samplesAcquired_;
+        uint64_t samplesSinceReport_;
+        uint64_t batchesSinceReport_;
+
+        std::unique_ptr<LoadGenerator> loadGenerator_;
+        std::unique_ptr<SensorRecorder> recorder_;
+        std::unique_ptr<SensorReplayer> replayer_;
+
+        static constexpr int SAMPLE_INTERVAL_MS = 2000;
+        static constexpr double MAX_SAMPLE_RATE_HZ = 100000.0;
     };
-}
\ No newline at end of file
+}
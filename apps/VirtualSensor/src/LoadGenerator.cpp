@@ -0,0 +1,228 @@
+// LoadGenerator.cpp
+#include "LoadGenerator.h"
+#include "ThreadPlacement.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+
+namespace sensor
+{
+    namespace
+    {
+        // 生成线程落后超过该时长时丢弃积压，不再逐条补发
+        constexpr int64_t MAX_BACKLOG_US = 1000000;
+
+        // 按需取用的高斯噪声缓冲区，每次整块填充以便向量化
+        class GaussianBuffer {
+        public:
+            explicit GaussianBuffer(Xoshiro256x4& rng) : rng_(rng), cursor_(SIZE) {}
+
+            double next() {
+                if (cursor_ == SIZE) {
+                    for (size_t i = 0; i < SIZE; i += Xoshiro256x4::LANES) {
+                        rng_.gaussian(&values_[i]);
+                    }
+                    cursor_ = 0;
+                }
+                return values_[cursor_++];
+            }
+
+        private:
+            static constexpr size_t SIZE = 256;
+            Xoshiro256x4& rng_;
+            size_t cursor_;
+            double values_[SIZE];
+        };
+    }
+
+    LoadGenerator::LoadGenerator(const Options& options, Publisher publisher)
+        : options_(options), publisher_(std::move(publisher)), totalWeight_(0), running_(false), sent_(0) {
+        if (options_.profiles.empty()) {
+            options_.profiles.push_back(SensorProfile());
+        }
+        for (const auto& profile : options_.profiles) {
+            totalWeight_ += std::max(0.0, profile.weight);
+        }
+        options_.sensors = std::max<size_t>(1, options_.sensors);
+        options_.threads = static_cast<int>(std::min<size_t>(std::max(1, options_.threads), options_.sensors));
+        options_.tickMs = std::max(1, options_.tickMs);
+
+        // 传感器按编号连续划分，前 remainder 个分片各多一个
+        shards_.resize(options_.threads);
+        size_t perShard = options_.sensors / shards_.size();
+        size_t remainder = options_.sensors % shards_.size();
+        size_t first = 0;
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            size_t count = perShard + (i < remainder ? 1 : 0);
+            buildShard(shards_[i], first, count, i);
+            first += count;
+        }
+    }
+
+    LoadGenerator::~LoadGenerator() {
+        stop();
+    }
+
+    std::string LoadGenerator::sensorName(size_t index) const {
+        size_t width = std::max<size_t>(6, std::to_string(options_.sensors - 1).size());
+        std::string digits = std::to_string(index);
+        return options_.prefix + std::string(width - std::min(width, digits.size()), '0') + digits;
+    }
+
+    size_t LoadGenerator::pickProfile(double u) const {
+        double target = u * totalWeight_;
+        for (size_t i = 0; i < options_.profiles.size(); ++i) {
+            target -= std::max(0.0, options_.profiles[i].weight);
+            if (target < 0) {
+                return i;
+            }
+        }
+        return options_.profiles.size() - 1;
+    }
+
+    void LoadGenerator::buildShard(Shard& shard, size_t first, size_t count, size_t shardIndex) {
+        shard.first = first;
+        shard.names.reserve(count);
+        shard.keys.reserve(count);
+        shard.binary.reserve(count);
+        for (int c = 0; c < 3; ++c) {
+            shard.level[c].resize(count);
+            shard.drift[c].resize(count);
+        }
+        shard.noise.resize(count);
+        shard.periodUs.resize(count);
+        shard.lastUs.resize(count);
+        shard.schedule.reserve(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            size_t index = first + i;
+            // 每个传感器的静态参数只由 seed 和编号决定
+            uint64_t x = options_.seed * 0x9e3779b97f4a7c15ull + index;
+            auto uniform = [&x]() {
+                return static_cast<double>(Xoshiro256x4::splitmix64(x) >> 11) * 0x1.0p-53;
+            };
+
+            const SensorProfile& profile = options_.profiles[pickProfile(uniform())];
+            shard.names.push_back(sensorName(index));
+            uint32_t key = 0;
+            bool unique = SensorIdRegistry::getInstance().tryIntern(shard.names.back(), key);
+            shard.keys.push_back(key);
+            shard.binary.push_back(unique ? 1 : 0);
+            for (int c = 0; c < 3; ++c) {
+                shard.level[c][i] = RANGE_MIN[c] + (RANGE_MAX[c] - RANGE_MIN[c]) * (0.2 + 0.6 * uniform());
+                shard.drift[c][i] = uniform() < 0.5 ? -profile.drift : profile.drift;
+            }
+            shard.noise[i] = profile.noise;
+            shard.periodUs[i] = std::max<int64_t>(1, static_cast<int64_t>(1e6 / std::max(1e-6, profile.rateHz)));
+            // 随机相位，避免所有传感器在同一时刻发送
+            shard.lastUs[i] = static_cast<int64_t>(uniform() * shard.periodUs[i]);
+            shard.schedule.emplace_back(shard.lastUs[i], static_cast<uint32_t>(i));
+        }
+        std::make_heap(shard.schedule.begin(), shard.schedule.end(), std::greater<>());
+
+        uint64_t shardSeed = options_.seed ^ ((shardIndex + 1) * 0xd1b54a32d192ed03ull);
+        shard.rng.reseed(shardSeed);
+    }
+
+    void LoadGenerator::start() {
+        if (running_.exchange(true)) {
+            return;
+        }
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            shards_[i].thread = std::thread(&LoadGenerator::shardLoop, this, i);
+        }
+        std::cout << "[LoadGenerator] Simulating " << options_.sensors << " sensors on "
+                  << shards_.size() << " thread(s)" << std::endl;
+    }
+
+    void LoadGenerator::stop() {
+        if (!running_.exchange(false)) {
+            return;
+        }
+        for (auto& shard : shards_) {
+            if (shard.thread.joinable()) {
+                shard.thread.join();
+            }
+        }
+    }
+
+    uint64_t LoadGenerator::takeSentCount() {
+        return sent_.exchange(0);
+    }
+
+    void LoadGenerator::shardLoop(size_t shardIndex) {
+        ThreadPlacement::getInstance().apply(ThreadRole::App, "loadgen-" + std::to_string(shardIndex));
+        Shard& shard = shards_[shardIndex];
+        GaussianBuffer gaussian(shard.rng);
+        SensorData message;
+
+        auto start = std::chrono::steady_clock::now();
+        int64_t wallStartMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        auto tick = std::chrono::milliseconds(options_.tickMs);
+        auto deadline = start;
+
+        while (running_.load()) {
+            int64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start).count();
+            uint64_t sent = 0;
+
+            while (!shard.schedule.empty() && shard.schedule.front().first <= nowUs && running_.load(std::memory_order_relaxed)) {
+                std::pop_heap(shard.schedule.begin(), shard.schedule.end(), std::greater<>());
+                auto& entry = shard.schedule.back();
+                int64_t dueUs = entry.first;
+                uint32_t i = entry.second;
+
+                if (nowUs - dueUs > MAX_BACKLOG_US) {
+                    dueUs += (nowUs - dueUs) / shard.periodUs[i] * shard.periodUs[i];
+                    shard.lastUs[i] = dueUs;
+                }
+
+                double dt = (dueUs - shard.lastUs[i]) * 1e-6;
+                double values[3];
+                for (int c = 0; c < 3; ++c) {
+                    double level = shard.level[c][i] + shard.drift[c][i] * dt;
+                    if (level < RANGE_MIN[c]) {
+                        level = RANGE_MIN[c];
+                        shard.drift[c][i] = std::fabs(shard.drift[c][i]);
+                    } else if (level > RANGE_MAX[c]) {
+                        level = RANGE_MAX[c];
+                        shard.drift[c][i] = -std::fabs(shard.drift[c][i]);
+                    }
+                    shard.level[c][i] = level;
+                    values[c] = level + shard.noise[i] * gaussian.next();
+                }
+
+                int64_t timestamp = wallStartMs + dueUs / 1000;
+                if (options_.encoding == SensorEncoding::Binary && shard.binary[i]) {
+                    publisher_(shard.names[i], SensorCodec::encodeBinary(shard.keys[i], timestamp,
+                                                                         values[0], values[1], values[2]));
+                } else {
+                    message.set_sensor_id(shard.names[i]);
+                    message.set_temperature(values[0]);
+                    message.set_humidity(values[1]);
+                    message.set_pressure(values[2]);
+                    message.set_timestamp(timestamp);
+                    publisher_(shard.names[i], message.SerializeAsString());
+                }
+
+                shard.lastUs[i] = dueUs;
+                entry.first = dueUs + shard.periodUs[i];
+                std::push_heap(shard.schedule.begin(), shard.schedule.end(), std::greater<>());
+                ++sent;
+            }
+            sent_.fetch_add(sent, std::memory_order_relaxed);
+
+            // 按固定节拍推进，处理耗时超过一个节拍时立即进入下一轮
+            deadline += tick;
+            auto now = std::chrono::steady_clock::now();
+            if (deadline > now) {
+                std::this_thread::sleep_until(deadline);
+            } else {
+                deadline = now;
+            }
+        }
+    }
+}
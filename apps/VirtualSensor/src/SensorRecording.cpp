@@ -0,0 +1,319 @@
+// SensorRecording.cpp
+#include "SensorRecording.h"
+#include "SensorCodec.h"
+#include "ThreadPlacement.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <cstring>
+#include <iostream>
+
+namespace sensor
+{
+    namespace
+    {
+        constexpr uint32_t RECORDING_MAGIC = 0x4C505253;  // "SRPL"
+        constexpr uint16_t RECORDING_VERSION = 1;
+        constexpr size_t HEADER_SIZE = 16;
+
+        int64_t steadyUs() {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        void appendVarint(std::string& out, uint64_t value) {
+            while (value >= 0x80) {
+                out.push_back(static_cast<char>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<char>(value));
+        }
+
+        bool readVarint(const char*& data, const char* end, uint64_t& value) {
+            value = 0;
+            for (int shift = 0; shift < 64 && data < end; shift += 7) {
+                uint8_t byte = static_cast<uint8_t>(*data++);
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if (!(byte & 0x80)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    // ---------------- SensorRecorder ----------------
+
+    SensorRecorder::~SensorRecorder() {
+        close();
+    }
+
+    bool SensorRecorder::open(const std::string& path) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fd_ >= 0) {
+            return true;
+        }
+
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd_ < 0) {
+            std::cerr << "[SensorRecorder] Failed to open " << path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        path_ = path;
+
+        char header[HEADER_SIZE] = {};
+        detail::storeLE<uint32_t>(header, RECORDING_MAGIC);
+        detail::storeLE<uint16_t>(header + 4, RECORDING_VERSION);
+        detail::storeLE<int64_t>(header + 8, std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        buffer_.assign(header, HEADER_SIZE);
+        buffer_.reserve(FLUSH_THRESHOLD * 2);
+        strings_.clear();
+        lastUs_ = steadyUs();
+        records_ = 0;
+
+        std::cout << "[SensorRecorder] Recording to " << path << std::endl;
+        return true;
+    }
+
+    void SensorRecorder::close() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fd_ < 0) {
+            return;
+        }
+        flushLocked();
+        ::close(fd_);
+        fd_ = -1;
+        std::cout << "[SensorRecorder] Recorded " << records_ << " event(s) to " << path_ << std::endl;
+    }
+
+    void SensorRecorder::record(const std::string& topic, const std::string& key, const std::string& payload) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (fd_ < 0) {
+            return;
+        }
+
+        int64_t now = steadyUs();
+        appendVarint(buffer_, static_cast<uint64_t>(std::max<int64_t>(0, now - lastUs_)));
+        lastUs_ = now;
+        appendString(topic);
+        appendString(key);
+        appendVarint(buffer_, payload.size());
+        buffer_.append(payload);
+        ++records_;
+
+        if (buffer_.size() >= FLUSH_THRESHOLD && !flushLocked()) {
+            ::close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    void SensorRecorder::appendString(const std::string& value) {
+        auto it = strings_.find(value);
+        if (it != strings_.end()) {
+            appendVarint(buffer_, it->second);
+            return;
+        }
+        uint64_t id = strings_.size() + 1;
+        strings_.emplace(value, id);
+        appendVarint(buffer_, 0);
+        appendVarint(buffer_, value.size());
+        buffer_.append(value);
+    }
+
+    bool SensorRecorder::flushLocked() {
+        size_t written = 0;
+        while (written < buffer_.size()) {
+            ssize_t n = ::write(fd_, buffer_.data() + written, buffer_.size() - written);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                std::cerr << "[SensorRecorder] Write to " << path_ << " failed: " << strerror(errno)
+                          << ", recording stopped" << std::endl;
+                buffer_.clear();
+                return false;
+            }
+            written += static_cast<size_t>(n);
+        }
+        buffer_.clear();
+        return true;
+    }
+
+    // ---------------- SensorReplayer ----------------
+
+    SensorReplayer::SensorReplayer(const Options& options, Publisher publisher)
+        : options_(options), publisher_(std::move(publisher)), data_(nullptr), size_(0),
+          running_(false), finished_(false), replayed_(0) {}
+
+    SensorReplayer::~SensorReplayer() {
+        stop();
+        if (data_) {
+            munmap(data_, size_);
+        }
+    }
+
+    bool SensorReplayer::open() {
+        int fd = ::open(options_.path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "[SensorReplayer] Failed to open " << options_.path << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < HEADER_SIZE) {
+            std::cerr << "[SensorReplayer] " << options_.path << " is not a recording" << std::endl;
+            ::close(fd);
+            return false;
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        void* mapped = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "[SensorReplayer] Failed to map " << options_.path << ": " << strerror(errno) << std::endl;
+            size_ = 0;
+            return false;
+        }
+        data_ = static_cast<char*>(mapped);
+        madvise(data_, size_, MADV_SEQUENTIAL);
+
+        if (detail::loadLE<uint32_t>(data_) != RECORDING_MAGIC ||
+            detail::loadLE<uint16_t>(data_ + 4) != RECORDING_VERSION) {
+            std::cerr << "[SensorReplayer] " << options_.path << " has an unsupported header" << std::endl;
+            munmap(data_, size_);
+            data_ = nullptr;
+            size_ = 0;
+            return false;
+        }
+        return true;
+    }
+
+    void SensorReplayer::start() {
+        if (!data_ || running_.exchange(true)) {
+            return;
+        }
+        thread_ = std::thread(&SensorReplayer::replayLoop, this);
+    }
+
+    void SensorReplayer::stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_.store(false);
+        }
+        condition_.notify_all();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    void SensorReplayer::replayLoop() {
+        ThreadPlacement::getInstance().apply(ThreadRole::App, "replay");
+        std::cout << "[SensorReplayer] Replaying " << options_.path << " at "
+                  << (options_.speed > 0 ? std::to_string(options_.speed) + "x" : std::string("max"))
+                  << " speed" << std::endl;
+
+        do {
+            auto begin = std::chrono::steady_clock::now();
+            uint64_t before = replayed_.load();
+            if (!replayPass()) {
+                break;
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            uint64_t count = replayed_.load() - before;
+            std::cout << "[SensorReplayer] Replayed " << count << " event(s) in " << seconds << " s ("
+                      << static_cast<uint64_t>(seconds > 0 ? count / seconds : 0) << " events/s)" << std::endl;
+        } while (options_.loop && running_.load());
+
+        finished_.store(true);
+    }
+
+    bool SensorReplayer::replayPass() {
+        Cursor cursor{data_ + HEADER_SIZE, data_ + size_, {}};
+        auto base = std::chrono::steady_clock::now();
+        int64_t elapsedUs = 0;
+        int64_t maxGapUs = options_.maxGapMs * 1000;
+        std::string payload;
+
+        while (running_.load() && cursor.data < cursor.end) {
+            uint64_t deltaUs;
+            const std::string* topic;
+            const std::string* key;
+            if (!readRecord(cursor, deltaUs, topic, key, payload)) {
+                std::cerr << "[SensorReplayer] Truncated or corrupt record at byte "
+                          << (cursor.data - data_) << ", stopping" << std::endl;
+                return false;
+            }
+
+            int64_t gap = static_cast<int64_t>(deltaUs);
+            if (maxGapUs > 0 && gap > maxGapUs) {
+                gap = maxGapUs;
+            }
+            elapsedUs += gap;
+            if (options_.speed > 0) {
+                auto deadline = base + std::chrono::microseconds(static_cast<int64_t>(elapsedUs / options_.speed));
+                if (deadline > std::chrono::steady_clock::now() && !waitUntil(deadline)) {
+                    return false;
+                }
+            }
+
+            publisher_(*topic, payload, *key);
+            replayed_.fetch_add(1, std::memory_order_relaxed);
+        }
+        return running_.load();
+    }
+
+    bool SensorReplayer::readRecord(Cursor& cursor, uint64_t& deltaUs, const std::string*& topic,
+                                    const std::string*& key, std::string& payload) {
+        if (!readVarint(cursor.data, cursor.end, deltaUs)) {
+            return false;
+        }
+
+        size_t topicIndex, keyIndex;
+        if (!readString(cursor, topicIndex) || !readString(cursor, keyIndex)) {
+            return false;
+        }
+        // 两个字符串都读完后再取地址，新增字符串可能使 vector 扩容
+        topic = &cursor.strings[topicIndex];
+        key = &cursor.strings[keyIndex];
+
+        uint64_t length;
+        if (!readVarint(cursor.data, cursor.end, length) ||
+            length > static_cast<uint64_t>(cursor.end - cursor.data)) {
+            return false;
+        }
+        payload.assign(cursor.data, length);
+        cursor.data += length;
+        return true;
+    }
+
+    bool SensorReplayer::readString(Cursor& cursor, size_t& index) {
+        uint64_t ref;
+        if (!readVarint(cursor.data, cursor.end, ref)) {
+            return false;
+        }
+        if (ref == 0) {
+            uint64_t length;
+            if (!readVarint(cursor.data, cursor.end, length) ||
+                length > static_cast<uint64_t>(cursor.end - cursor.data)) {
+                return false;
+            }
+            cursor.strings.emplace_back(cursor.data, length);
+            cursor.data += length;
+            index = cursor.strings.size() - 1;
+            return true;
+        }
+        if (ref > cursor.strings.size()) {
+            return false;
+        }
+        index = ref - 1;
+        return true;
+    }
+
+    bool SensorReplayer::waitUntil(std::chrono::steady_clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_.wait_until(lock, deadline, [this]() { return !running_.load(); });
+        return running_.load();
+    }
+}
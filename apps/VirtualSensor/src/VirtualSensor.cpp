@@ -1,14 +1,20 @@
 // VirtualSensor.cpp - Fixed version
 #include "VirtualSensor.h"
+#include "ConfigManager.h"
+#include "ThreadPlacement.h"
 #include <iostream>
 #include <random>
 #include <chrono>
 #include <thread>
+#include <algorithm>
 
 namespace sensor
 {
     VirtualSensor::VirtualSensor() 
-        : AppTemplate("VirtualSensor", 20001), generating_(false), sensorId_("SENSOR_001") {}
+        : AppTemplate("VirtualSensor", 20001), sampleTimer_(0), reportTimer_(0), sensorId_("SENSOR_001"),
+          encoding_(SensorEncoding::Protobuf), mode_("single"), batchMode_(false), sampleRateHz_(1000.0 / SAMPLE_INTERVAL_MS),
+          batchSize_(1000), batchMaxAgeMs_(50), acquisitionStartUs_(0), samplesAcquired_(0),
+          samplesSinceReport_(0), batchesSinceReport_(0) {}
 
     VirtualSensor::~VirtualSensor() {
         cleanup();
@@ -16,6 +22,26 @@ namespace sensor
 
     void VirtualSensor::initialize() {
         std::cout << "[VirtualSensor] Initializing sensor " << sensorId_ << std::endl;
+
+        // "sensor": { "encoding": "binary" } 使用固定布局二进制记录
+        std::string encoding = ConfigManager::getInstance().getString("sensor", "encoding", "protobuf");
+        if (!SensorCodec::parseEncoding(encoding, encoding_)) {
+            std::cerr << "[VirtualSensor] Unknown encoding '" << encoding << "', using protobuf" << std::endl;
+        }
+        loadSamplingConfig();
+        if (mode_ == "replay") {
+            if (!openReplayer()) {
+                std::cerr << "[VirtualSensor] Replay unavailable, no data will be sent" << std::endl;
+            }
+        } else {
+            openRecorder();
+            if (encoding_ == SensorEncoding::Binary) {
+                announce(sensorId_);
+            }
+            if (mode_ == "load") {
+                startLoadGenerator();
+            }
+        }
         
         // 连接到其他应用（假设它们运行在默认端口）
         // Add delay and retry logic for connections
@@ -24,77 +50,350 @@ namespace sensor
             connectToPeer("127.0.0.1", 20002); // Algorithm
             connectToPeer("127.0.0.1", 20005); // WebApp
             // connectToPeer("127.0.0.1", 20003); // GUI
+
+            // 回放在对端连接之后开始，保证每次运行消费端收到的输入完全相同
+            if (replayer_ && isRunning()) {
+                replayer_->start();
+            }
         });
         connectionThread.detach();
     }
 
+    void VirtualSensor::loadSamplingConfig() {
+        ConfigManager& config = ConfigManager::getInstance();
+        mode_ = config.getString("sensor", "mode", "single");
+        batchMode_ = mode_ == "batch";
+        sampleRateHz_ = config.getDouble("sensor", "sample_rate_hz", sampleRateHz_);
+        if (sampleRateHz_ <= 0 || sampleRateHz_ > MAX_SAMPLE_RATE_HZ) {
+            std::cerr << "[VirtualSensor] sample_rate_hz out of range, clamping to (0, "
+                      << MAX_SAMPLE_RATE_HZ << "]" << std::endl;
+            sampleRateHz_ = sampleRateHz_ <= 0 ? 1000.0 / SAMPLE_INTERVAL_MS : MAX_SAMPLE_RATE_HZ;
+        }
+        batchSize_ = static_cast<size_t>(std::max(1, config.getInt("sensor", "batch_size", static_cast<int>(batchSize_))));
+        batchMaxAgeMs_ = std::max(1, config.getInt("sensor", "batch_max_age_ms", batchMaxAgeMs_));
+
+        if (batchMode_) {
+            std::cout << "[VirtualSensor] Batch mode: " << sampleRateHz_ << " Hz, flush at "
+                      << batchSize_ << " samples or " << batchMaxAgeMs_ << " ms" << std::endl;
+        }
+    }
+
+    void VirtualSensor::emit(const std::string& eventType, const std::string& data, const std::string& key) {
+        broadcast(eventType, data, key);
+        if (recorder_) {
+            recorder_->record(eventType, key, data);
+        }
+    }
+
+    void VirtualSensor::announce(const std::string& sensorId) {
+        if (!announceSensorId(*this, sensorId)) {
+            return;
+        }
+        if (recorder_) {
+            recorder_->record(topics::SENSOR_IDS, std::to_string(SensorIdRegistry::hash(sensorId)), sensorId);
+        }
+    }
+
+    void VirtualSensor::openRecorder() {
+        std::string path = ConfigManager::getInstance().getString("sensor", "record", "");
+        if (path.empty()) {
+            return;
+        }
+        auto recorder = std::make_unique<SensorRecorder>();
+        if (recorder->open(path)) {
+            recorder_ = std::move(recorder);
+        }
+    }
+
+    bool VirtualSensor::openReplayer() {
+        // "sensor": { "mode": "replay", "replay": { "file": "sensor.rec", "speed": 1.0, "max_gap_ms": 0, "loop": false } }
+        // speed 为 0 时不等待，以最快速度回放
+        SensorReplayer::Options options;
+        const rapidjson::Value* sensorConfig = ConfigManager::getInstance().getObject("sensor");
+        if (sensorConfig && sensorConfig->IsObject() && sensorConfig->HasMember("replay") &&
+            (*sensorConfig)["replay"].IsObject()) {
+            const rapidjson::Value& replay = (*sensorConfig)["replay"];
+            if (replay.HasMember("file") && replay["file"].IsString()) {
+                options.path = replay["file"].GetString();
+            }
+            if (replay.HasMember("speed") && replay["speed"].IsNumber()) {
+                options.speed = replay["speed"].GetDouble();
+            }
+            if (replay.HasMember("max_gap_ms") && replay["max_gap_ms"].IsInt()) {
+                options.maxGapMs = replay["max_gap_ms"].GetInt();
+            }
+            if (replay.HasMember("loop") && replay["loop"].IsBool()) {
+                options.loop = replay["loop"].GetBool();
+            }
+        }
+        if (options.path.empty()) {
+            std::cerr << "[VirtualSensor] sensor.replay.file is not set" << std::endl;
+            return false;
+        }
+
+        auto replayer = std::make_unique<SensorReplayer>(options, [this](const std::string& eventType,
+                                                                         const std::string& data,
+                                                                         const std::string& key) {
+            broadcast(eventType, data, key);
+        });
+        if (!replayer->open()) {
+            return false;
+        }
+        replayer_ = std::move(replayer);
+        return true;
+    }
+
     void VirtualSensor::run() {
-        generating_.store(true);
-        sensorThread_ = std::thread(&VirtualSensor::generateSensorData, this);
+        if (mode_ == "replay") {
+            // 回放线程在对端连接后启动，这里只运行事件循环
+        } else if (loadGenerator_) {
+            loadGenerator_->start();
+            reportTimer_ = runEvery(std::chrono::seconds(1), [this]() { reportLoadRate(); });
+        } else if (batchMode_) {
+            batch_.set_sensor_id(sensorId_);
+            batch_.set_sample_rate_hz(sampleRateHz_);
+            batch_.mutable_timestamps_us()->Reserve(static_cast<int>(batchSize_));
+            batch_.mutable_temperature()->Reserve(static_cast<int>(batchSize_));
+            batch_.mutable_humidity()->Reserve(static_cast<int>(batchSize_));
+            batch_.mutable_pressure()->Reserve(static_cast<int>(batchSize_));
+
+            acquisitionStart_ = std::chrono::steady_clock::now();
+            batchOpened_ = acquisitionStart_;
+            acquisitionStartUs_ = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+
+            // 定时器最小 1ms，高采样率时每次触发补齐这段时间内的全部样本
+            int tickMs = static_cast<int>(1000.0 / sampleRateHz_);
+            tickMs = std::max(1, std::min(tickMs, batchMaxAgeMs_));
+            sampleTimer_ = runEvery(std::chrono::milliseconds(tickMs), [this]() { acquireBatch(); });
+            reportTimer_ = runEvery(std::chrono::seconds(1), [this]() { reportBatchRate(); });
+        } else {
+            // 立即产生第一条数据，之后由事件循环定时触发
+            int intervalMs = std::max(1, static_cast<int>(1000.0 / sampleRateHz_));
+            post([this]() { generateSensorData(); });
+            sampleTimer_ = runEvery(std::chrono::milliseconds(intervalMs), [this]() {
+                generateSensorData();
+            });
+        }
         
         std::cout << "[VirtualSensor] Started generating sensor data. Press Ctrl+C to stop." << std::endl;
         
-        // 主线程等待
-        while (isRunning()) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        }
+        runEventLoop();
     }
 
     void VirtualSensor::cleanup() {
         std::cout << "[VirtualSensor] Cleaning up..." << std::endl;
-        generating_.store(false);
-        
-        if (sensorThread_.joinable()) {
-            sensorThread_.join();
+        if (sampleTimer_) {
+            cancelTimer(sampleTimer_);
+            sampleTimer_ = 0;
+        }
+        if (reportTimer_) {
+            cancelTimer(reportTimer_);
+            reportTimer_ = 0;
+        }
+        if (loadGenerator_) {
+            loadGenerator_->stop();
+        }
+        if (replayer_) {
+            replayer_->stop();
+        }
+        if (recorder_) {
+            recorder_->close();
         }
     }
 
     void VirtualSensor::generateSensorData() {
-        while (generating_.load() && isRunning()) {
-            try {
-                SensorData data = createRandomSensorData();
-                
-                // 序列化数据
-                std::string serializedData = data.SerializeAsString();
-                
-                // 广播传感器数据 - using try-catch to handle connection issues
-                try {
-                    broadcast("sensor.data", serializedData);
-                    
-                    std::cout << "[VirtualSensor] Sent: T=" << data.temperature() 
-                            << "°C, H=" << data.humidity() 
-                            << "%, P=" << data.pressure() << "hPa" << std::endl;
-                } catch (const std::exception& e) {
-                    std::cerr << "[VirtualSensor] Error broadcasting data: " << e.what() << std::endl;
-                    // Continue running even if broadcast fails
+        // 广播传感器数据 - using try-catch to handle connection issues
+        try {
+            SensorData data = createRandomSensorData();
+            emit(topics::SENSOR_DATA, SensorCodec::encode(data, encoding_), sensorId_);
+            
+            std::cout << "[VirtualSensor] Sent: T=" << data.temperature() 
+                    << "°C, H=" << data.humidity() 
+                    << "%, P=" << data.pressure() << "hPa" << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "[VirtualSensor] Error broadcasting data: " << e.what() << std::endl;
+            // Continue running even if broadcast fails
+        }
+    }
+
+    void VirtualSensor::acquireBatch() {
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - acquisitionStart_).count();
+        uint64_t due = static_cast<uint64_t>(elapsed * sampleRateHz_);
+
+        // 事件循环停顿超过 1 秒时丢弃积压，避免一次生成过多样本
+        uint64_t maxBacklog = static_cast<uint64_t>(sampleRateHz_) + 1;
+        if (due - samplesAcquired_ > maxBacklog) {
+            std::cerr << "[VirtualSensor] Acquisition fell behind, dropping "
+                      << (due - samplesAcquired_ - maxBacklog) << " samples" << std::endl;
+            samplesAcquired_ = due - maxBacklog;
+        }
+
+        double periodUs = 1e6 / sampleRateHz_;
+        for (; samplesAcquired_ < due; ++samplesAcquired_) {
+            double temperature, humidity, pressure;
+            sampleValues(temperature, humidity, pressure);
+            batch_.add_timestamps_us(acquisitionStartUs_ + static_cast<int64_t>(samplesAcquired_ * periodUs));
+            batch_.add_temperature(temperature);
+            batch_.add_humidity(humidity);
+            batch_.add_pressure(pressure);
+
+            if (static_cast<size_t>(batch_.temperature_size()) >= batchSize_) {
+                flushBatch();
+            }
+        }
+
+        if (batch_.temperature_size() > 0 && now - batchOpened_ >= std::chrono::milliseconds(batchMaxAgeMs_)) {
+            flushBatch();
+        }
+    }
+
+    void VirtualSensor::flushBatch() {
+        try {
+            emit(topics::SENSOR_BATCH, PayloadCodec<SensorBatch>::encode(batch_), sensorId_);
+        } catch (const std::exception& e) {
+            std::cerr << "[VirtualSensor] Error broadcasting batch: " << e.what() << std::endl;
+        }
+
+        samplesSinceReport_ += batch_.temperature_size();
+        ++batchesSinceReport_;
+        batch_.set_sequence(batch_.sequence() + 1);
+        // Clear 保留已分配的容量
+        batch_.clear_timestamps_us();
+        batch_.clear_temperature();
+        batch_.clear_humidity();
+        batch_.clear_pressure();
+        batchOpened_ = std::chrono::steady_clock::now();
+    }
+
+    void VirtualSensor::reportBatchRate() {
+        std::cout << "[VirtualSensor] Sent " << samplesSinceReport_ << " samples in "
+                  << batchesSinceReport_ << " batches (last seq " << batch_.sequence() << ")" << std::endl;
+        samplesSinceReport_ = 0;
+        batchesSinceReport_ = 0;
+    }
+
+    LoadGenerator::Options VirtualSensor::loadGeneratorOptions() const {
+        // "sensor": { "mode": "load", "load": { "sensors": 20000, "threads": 4, "seed": 42, "tick_ms": 10,
+        //   "prefix": "LOAD_", "profiles": [ { "name": "stable", "weight": 0.9, "rate_hz": 1, "drift": 0.001, "noise": 0.05 } ] } }
+        LoadGenerator::Options options;
+        options.encoding = encoding_;
+        options.threads = ThreadPlacement::getInstance().threadCount(
+            ThreadRole::App, static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+
+        const rapidjson::Value* sensorConfig = ConfigManager::getInstance().getObject("sensor");
+        if (!sensorConfig || !sensorConfig->IsObject() || !sensorConfig->HasMember("load") ||
+            !(*sensorConfig)["load"].IsObject()) {
+            return options;
+        }
+        const rapidjson::Value& load = (*sensorConfig)["load"];
+
+        if (load.HasMember("sensors") && load["sensors"].IsUint()) {
+            options.sensors = load["sensors"].GetUint();
+        }
+        if (load.HasMember("threads") && load["threads"].IsInt()) {
+            options.threads = load["threads"].GetInt();
+        }
+        if (load.HasMember("seed") && load["seed"].IsUint64()) {
+            options.seed = load["seed"].GetUint64();
+        }
+        if (load.HasMember("tick_ms") && load["tick_ms"].IsInt()) {
+            options.tickMs = load["tick_ms"].GetInt();
+        }
+        if (load.HasMember("prefix") && load["prefix"].IsString()) {
+            options.prefix = load["prefix"].GetString();
+        }
+        if (load.HasMember("profiles") && load["profiles"].IsArray()) {
+            const rapidjson::Value& profiles = load["profiles"];
+            for (rapidjson::SizeType i = 0; i < profiles.Size(); i++) {
+                if (!profiles[i].IsObject()) {
+                    continue;
+                }
+                const rapidjson::Value& config = profiles[i];
+                SensorProfile profile;
+                if (config.HasMember("name") && config["name"].IsString()) {
+                    profile.name = config["name"].GetString();
                 }
-                
-                // Sleep with interruption check
-                for (int i = 0; i < 20 && generating_.load() && isRunning(); ++i) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                if (config.HasMember("weight") && config["weight"].IsNumber()) {
+                    profile.weight = config["weight"].GetDouble();
                 }
-                
-            } catch (const std::exception& e) {
-                std::cerr << "[VirtualSensor] Error in data generation: " << e.what() << std::endl;
-                std::this_thread::sleep_for(std::chrono::seconds(1));
+                if (config.HasMember("rate_hz") && config["rate_hz"].IsNumber()) {
+                    profile.rateHz = config["rate_hz"].GetDouble();
+                }
+                if (config.HasMember("drift") && config["drift"].IsNumber()) {
+                    profile.drift = config["drift"].GetDouble();
+                }
+                if (config.HasMember("noise") && config["noise"].IsNumber()) {
+                    profile.noise = config["noise"].GetDouble();
+                }
+                options.profiles.push_back(profile);
             }
         }
-        
-        std::cout << "[VirtualSensor] Data generation stopped" << std::endl;
+        return options;
     }
 
-    SensorData VirtualSensor::createRandomSensorData() {
+    void VirtualSensor::startLoadGenerator() {
+        LoadGenerator::Options options = loadGeneratorOptions();
+        if (options.profiles.empty()) {
+            options.profiles.push_back(SensorProfile());
+        }
+        loadGenerator_ = std::make_unique<LoadGenerator>(options, [this](const std::string& sensorId,
+                                                                         const std::string& payload) {
+            emit(topics::SENSOR_DATA, payload, sensorId);
+        });
+
+        // 每个传感器的最新数据和 ID 映射都作为保留消息，扩大缓存以免新连接的订阅者丢失
+        size_t sensors = loadGenerator_->sensorCount();
+        eventBus_->setRetainedCapacity(sensors * 2 + 1024);
+        if (encoding_ == SensorEncoding::Binary) {
+            for (size_t i = 0; i < sensors; ++i) {
+                announce(loadGenerator_->sensorName(i));
+            }
+        }
+
+        double expectedRate = 0;
+        double totalWeight = 0;
+        for (const auto& profile : options.profiles) {
+            totalWeight += std::max(0.0, profile.weight);
+        }
+        for (const auto& profile : options.profiles) {
+            expectedRate += sensors * std::max(0.0, profile.weight) / totalWeight * profile.rateHz;
+        }
+        std::cout << "[VirtualSensor] Load mode: " << sensors << " sensors, " << options.profiles.size()
+                  << " profile(s), seed " << options.seed;
+        if (totalWeight > 0) {
+            std::cout << ", ~" << static_cast<uint64_t>(expectedRate) << " samples/s";
+        }
+        std::cout << std::endl;
+    }
+
+    void VirtualSensor::reportLoadRate() {
+        std::cout << "[VirtualSensor] Load generator sent " << loadGenerator_->takeSentCount()
+                  << " samples in the last second" << std::endl;
+    }
+
+    void VirtualSensor::sampleValues(double& temperature, double& humidity, double& pressure) {
         static std::random_device rd;
         static std::mt19937 gen(rd());
         static std::uniform_real_distribution<> tempDis(18.0, 28.0);
         static std::uniform_real_distribution<> humidityDis(30.0, 80.0);
         static std::uniform_real_distribution<> pressureDis(980.0, 1030.0);
-        
+
+        temperature = tempDis(gen);
+        humidity = humidityDis(gen);
+        pressure = pressureDis(gen);
+    }
+
+    SensorData VirtualSensor::createRandomSensorData() {
+        double temperature, humidity, pressure;
+        sampleValues(temperature, humidity, pressure);
+
         SensorData data;
         data.set_sensor_id(sensorId_);
-        data.set_temperature(tempDis(gen));
-        data.set_humidity(humidityDis(gen));
-        data.set_pressure(pressureDis(gen));
+        data.set_temperature(temperature);
+        data.set_humidity(humidity);
+        data.set_pressure(pressure);
         data.set_timestamp(std::chrono::duration_cast<std::chrono::milliseconds>(
             std::chrono::system_clock::now().time_since_epoch()).count());
         
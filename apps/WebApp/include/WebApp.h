@@ -2,11 +2,20 @@
 #include "AppTemplate.h"
 #include "algorithm_result.pb.h"
 #include "sensor_data.pb.h"
+#include "SensorCodec.h"
+#include "Topics.h"
+#include "RollupEngine.h"
+#include "TimeSeriesStore.h"
 #include <memory>
 #include <mutex>
+#include <string>
+#include <unordered_map>
 
 namespace webapp 
 {
+    using SensorDataTopic = Topic<topics::SENSOR_DATA, sensor::SensorSample>;
+    using SensorBatchTopic = Topic<topics::SENSOR_BATCH, SensorBatch>;
+    using AlgorithmResultTopic = Topic<topics::ALGORITHM_RESULT, AlgorithmResult>;
 
     class HttpServer;
 
@@ -21,22 +30,48 @@ namespace webapp
         void cleanup() override;
 
     private:
-        void handleSensorData(const std::string& eventType, const std::string& data);
-        void handleAlgorithmResult(const std::string& eventType, const std::string& data);
+        void handleSensorData(const sensor::SensorSample& sensorData);
+        void handleSensorBatch(const SensorBatch& batch);
+        void handleAlgorithmResult(const AlgorithmResult& result);
+        void loadRollupConfig();
+        void loadStoreConfig();
+        // 用存储中汇总保留范围内的样本重建 RollupEngine，重启后长范围查询仍有数据；在订阅事件之前调用
+        void seedRollups();
         
         // HTTP request handler
         std::string handleHttpRequest(const std::string& method, const std::string& path, const std::string& body);
         
         // API endpoint handlers
-        std::string handleGetData();
+        // GET /api/data?sensor=，缺省为最近收到数据的传感器
+        std::string handleGetData(const std::string& query);
+        // GET /api/history?sensor=&from=&to=&points=&mode=lttb|minmax，返回 HTTP 状态码：
+        // 参数不合法为 400，传感器不存在为 404，json 为错误信息
+        int handleGetHistory(const std::string& query, std::string& json);
         std::string handlePostConfig(const std::string& body);
         std::string handlePostCommand(const std::string& body);
 
     private:
         std::unique_ptr<HttpServer> httpServer_;
-        SensorData latestSensorData_;
-        AlgorithmResult latestResult_;
+        // 按传感器保存最新样本和结果，结果按 AlgorithmResult.sensor_id 归属
+        std::unordered_map<std::string, SensorData> latestSensorData_;
+        std::unordered_map<std::string, AlgorithmResult> latestResults_;
+        std::string latestSensorId_;
         mutable std::mutex dataMutex_;
-        bool hasData_;
+        // 每个传感器的多分辨率历史（内部加锁，事件线程写入、HTTP 线程查询）
+        // "webapp": { "rollup": { "max_sensors": 1000, "resolutions": [ { "width_ms": 1000, "retention": 900 }, ... ] } }
+        std::unique_ptr<RollupEngine> rollups_;
+        // 原始分辨率的压缩持久化历史，未启用时为空
+        // "webapp": { "store": { "enabled": true, "directory": "tsdb", "segment_size_mb": 64, "max_segments": 64,
+        //                        "chunk_samples": 1024, "max_chunk_age_ms": 60000 } }
+        std::unique_ptr<TimeSeriesStore> store_;
+
+        static constexpr size_t DEFAULT_HISTORY_POINTS = 500;
+        static constexpr size_t MAX_HISTORY_POINTS = 2000;
+        // 降采样的输入上限为输出点数的若干倍：原始样本超出时改用汇总桶，响应时间与时间范围无关
+        static constexpr size_t HISTORY_OVERSAMPLE = 8;
+        static constexpr int64_t DEFAULT_HISTORY_RANGE_MS = 3600 * 1000;
+        static constexpr int64_t MAX_HISTORY_TIMESTAMP_MS = int64_t(1) << 53;
+        // 启动时按时间片从存储读取样本写入汇总，限制一次解码的样本数
+        static constexpr int64_t ROLLUP_SEED_SLICE_MS = 600 * 1000;
     };
 }
\ No newline at end of file
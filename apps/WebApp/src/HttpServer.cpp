@@ -51,6 +51,7 @@ namespace webapp
     void HttpServer::stop() {
         running_ = false;
         if (serverSocket_ >= 0) {
+            shutdown(serverSocket_, SHUT_RDWR);
             close(serverSocket_);
             serverSocket_ = -1;
         }
@@ -79,7 +80,15 @@ namespace webapp
             buffer[bytesRead] = '\0';
             std::string request(buffer);
             std::string response = handleRequest(request);
-            send(clientSocket, response.c_str(), response.length(), 0);
+            // 历史查询的响应可达上百 KB，send 可能只写出一部分
+            size_t sent = 0;
+            while (sent < response.length()) {
+                ssize_t written = send(clientSocket, response.data() + sent, response.length() - sent, MSG_NOSIGNAL);
+                if (written <= 0) {
+                    break;
+                }
+                sent += static_cast<size_t>(written);
+            }
         }
         
         close(clientSocket);
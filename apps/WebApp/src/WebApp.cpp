@@ -1,6 +1,14 @@
 #include "WebApp.h"
 #include "HttpServer.h"
+#include "ConfigManager.h"
+#include "Downsampler.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <map>
 #include <sstream>
 #include <iomanip>
 #include <thread>
@@ -8,8 +16,73 @@
 
 namespace webapp 
 {
+    namespace {
+        // 解析 URL 查询串 a=1&b=x%20y
+        std::map<std::string, std::string> parseQuery(const std::string& query) {
+            auto decode = [](const std::string& text) {
+                std::string result;
+                for (size_t i = 0; i < text.size(); ++i) {
+                    if (text[i] == '+') {
+                        result += ' ';
+                    } else if (text[i] == '%' && i + 2 < text.size() &&
+                               std::isxdigit(static_cast<unsigned char>(text[i + 1])) &&
+                               std::isxdigit(static_cast<unsigned char>(text[i + 2]))) {
+                        result += static_cast<char>(std::strtol(text.substr(i + 1, 2).c_str(), nullptr, 16));
+                        i += 2;
+                    } else {
+                        result += text[i];
+                    }
+                }
+                return result;
+            };
 
-    WebApp::WebApp() : AppTemplate("WebApp", 20005), hasData_(false) {}
+            std::map<std::string, std::string> params;
+            size_t pos = 0;
+            while (pos <= query.size()) {
+                size_t end = query.find('&', pos);
+                if (end == std::string::npos) {
+                    end = query.size();
+                }
+                std::string pair = query.substr(pos, end - pos);
+                size_t equals = pair.find('=');
+                if (!pair.empty()) {
+                    params[decode(pair.substr(0, equals))] = equals == std::string::npos ? "" : decode(pair.substr(equals + 1));
+                }
+                pos = end + 1;
+            }
+            return params;
+        }
+
+        bool parseInt64(const std::string& text, int64_t& value) {
+            if (text.empty()) {
+                return false;
+            }
+            char* end = nullptr;
+            errno = 0;
+            long long parsed = std::strtoll(text.c_str(), &end, 10);
+            if (errno != 0 || *end != '\0') {
+                return false;
+            }
+            value = parsed;
+            return true;
+        }
+
+        std::string jsonEscape(const std::string& text) {
+            std::ostringstream escaped;
+            for (char c : text) {
+                if (c == '"' || c == '\\') {
+                    escaped << '\\' << c;
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+                } else {
+                    escaped << c;
+                }
+            }
+            return escaped.str();
+        }
+    }
+
+    WebApp::WebApp() : AppTemplate("WebApp", 20005) {}
 
     WebApp::~WebApp()
     {
@@ -19,14 +92,20 @@ namespace webapp
     void WebApp::initialize()
     {
         std::cout << "[WebApp] Initializing request handler (UI served by lighttpd)" << std::endl;
+        loadRollupConfig();
+        loadStoreConfig();
         
         // Register event handlers for inter-app communication
-        registerHandler("sensor.data", [this](const std::string& eventType, const std::string& data) {
-            handleSensorData(eventType, data);
+        subscribe<SensorDataTopic>([this](const sensor::SensorSample& sensorData) {
+            handleSensorData(sensorData);
         });
+        subscribe<SensorBatchTopic>([this](const SensorBatch& batch) {
+            handleSensorBatch(batch);
+        });
+        sensor::subscribeSensorIds(*this);
         
-        registerHandler("algorithm.result", [this](const std::string& eventType, const std::string& data) {
-            handleAlgorithmResult(eventType, data);
+        subscribe<AlgorithmResultTopic>([this](const AlgorithmResult& result) {
+            handleAlgorithmResult(result);
         });
         
         // Connect to other applications
@@ -44,64 +123,227 @@ namespace webapp
         std::cout << "[WebApp] URL request handler running on port 8081" << std::endl;
     }
 
+    void WebApp::loadRollupConfig()
+    {
+        RollupEngine::Options options;
+        const rapidjson::Value* webappConfig = ConfigManager::getInstance().getObject("webapp");
+        if (webappConfig && webappConfig->IsObject() && webappConfig->HasMember("rollup") &&
+            (*webappConfig)["rollup"].IsObject()) {
+            const rapidjson::Value& rollup = (*webappConfig)["rollup"];
+            if (rollup.HasMember("max_sensors") && rollup["max_sensors"].IsUint()) {
+                options.maxSensors = rollup["max_sensors"].GetUint();
+            }
+            if (rollup.HasMember("resolutions") && rollup["resolutions"].IsArray()) {
+                const rapidjson::Value& resolutions = rollup["resolutions"];
+                options.resolutions.clear();
+                for (rapidjson::SizeType i = 0; i < resolutions.Size(); ++i) {
+                    const rapidjson::Value& resolution = resolutions[i];
+                    if (resolution.IsObject() && resolution.HasMember("width_ms") && resolution["width_ms"].IsInt64() &&
+                        resolution.HasMember("retention") && resolution["retention"].IsUint()) {
+                        options.resolutions.push_back({resolution["width_ms"].GetInt64(), resolution["retention"].GetUint()});
+                    }
+                }
+            }
+        }
+        rollups_ = std::make_unique<RollupEngine>(options);
+
+        std::cout << "[WebApp] History rollups:";
+        for (const auto& resolution : rollups_->resolutions()) {
+            std::cout << " " << resolution.widthMs << " ms x " << resolution.retention;
+        }
+        std::cout << ", up to " << options.maxSensors << " sensors" << std::endl;
+    }
+
+    void WebApp::loadStoreConfig()
+    {
+        const rapidjson::Value* webappConfig = ConfigManager::getInstance().getObject("webapp");
+        if (!webappConfig || !webappConfig->IsObject() || !webappConfig->HasMember("store") ||
+            !(*webappConfig)["store"].IsObject()) {
+            return;
+        }
+        const rapidjson::Value& store = (*webappConfig)["store"];
+        if (!store.HasMember("enabled") || !store["enabled"].IsBool() || !store["enabled"].GetBool()) {
+            return;
+        }
+
+        TimeSeriesStore::Options options;
+        if (store.HasMember("directory") && store["directory"].IsString()) {
+            options.directory = store["directory"].GetString();
+        }
+        if (store.HasMember("segment_size_mb") && store["segment_size_mb"].IsUint()) {
+            options.segmentSize = static_cast<size_t>(store["segment_size_mb"].GetUint()) * 1024 * 1024;
+        }
+        if (store.HasMember("max_segments") && store["max_segments"].IsUint()) {
+            options.maxSegments = store["max_segments"].GetUint();
+        }
+        if (store.HasMember("chunk_samples") && store["chunk_samples"].IsUint()) {
+            options.chunkSamples = store["chunk_samples"].GetUint();
+        }
+        if (store.HasMember("max_chunk_age_ms") && store["max_chunk_age_ms"].IsUint()) {
+            options.maxChunkAge = std::chrono::milliseconds(store["max_chunk_age_ms"].GetUint());
+        }
+
+        store_ = std::make_unique<TimeSeriesStore>(options);
+        if (!store_->open()) {
+            std::cerr << "[WebApp] Failed to open time-series store, raw history disabled" << std::endl;
+            store_.reset();
+            return;
+        }
+        seedRollups();
+    }
+
+    void WebApp::seedRollups()
+    {
+        // 汇总只在内存中，重启后为空；从存储回放各级保留范围中最长的一段，按时间顺序写入，与实时写入的效果相同
+        int64_t coverage = 0;
+        for (const auto& resolution : rollups_->resolutions()) {
+            coverage = std::max<int64_t>(coverage, resolution.widthMs * static_cast<int64_t>(resolution.retention));
+        }
+        int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        int64_t from = std::max<int64_t>(0, now - coverage);
+
+        uint64_t seeded = 0;
+        std::vector<std::string> sensors = store_->sensors();
+        std::vector<TimeSeriesSample> samples;
+        for (const std::string& sensorId : sensors) {
+            for (int64_t start = from; start < MAX_HISTORY_TIMESTAMP_MS; start += ROLLUP_SEED_SLICE_MS) {
+                // 最后一片延伸到时间上限，时钟超前的样本也不遗漏
+                int64_t end = start + ROLLUP_SEED_SLICE_MS > now ? MAX_HISTORY_TIMESTAMP_MS : start + ROLLUP_SEED_SLICE_MS;
+                samples.clear();
+                if (store_->scan(sensorId, start, end, samples) > 0) {
+                    rollups_->add(sensorId, samples.data(), samples.size());
+                    seeded += samples.size();
+                }
+                if (end == MAX_HISTORY_TIMESTAMP_MS) {
+                    break;
+                }
+            }
+        }
+        std::cout << "[WebApp] Seeded history rollups with " << seeded << " stored samples from "
+                  << sensors.size() << " sensors" << std::endl;
+    }
+
     void WebApp::run() {
         std::cout << "[WebApp] Handling URL requests. Web UI served by lighttpd." << std::endl;
         
-        while (running_) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-        }
+        runEventLoop();
     }
 
     void WebApp::cleanup() {
         if (httpServer_) {
             httpServer_->stop();
         }
+        if (rollups_) {
+            RollupEngine::Counters counters = rollups_->counters();
+            std::cout << "[WebApp] Rolled up " << counters.samples << " samples (" << counters.late
+                      << " out of order, " << counters.dropped << " dropped)" << std::endl;
+        }
+        if (store_) {
+            TimeSeriesStore::Stats stats = store_->stats();
+            store_->close();
+            std::cout << "[WebApp] Stored " << stats.samples << " samples in " << stats.chunks << " chunks ("
+                      << stats.storedBytes << " bytes)" << std::endl;
+            store_.reset();
+        }
     }
 
-    void WebApp::handleSensorData(const std::string& eventType, const std::string& data)
+    void WebApp::handleSensorData(const sensor::SensorSample& sensorData)
     {
-        SensorData sensorData;
-        if (!sensorData.ParseFromString(data)) {
-            std::cerr << "[Algorithm] Failed to parse sensor data" << std::endl;
-            return;
-        }
         std::cout << "[WebApp] Received SensorData: "
             << "T=" << sensorData.temperature()
             << " H=" << sensorData.humidity()
             << " P=" << sensorData.pressure()
             << std::endl;
         
+        // ID 映射尚未收到的二进制样本按 sensor_key 区分，不会全部合并到空名称下
+        std::string placeholder;
+        const std::string& sensorId = sensorData.sensor_name(placeholder);
+
         {
             std::lock_guard<std::mutex> lock(dataMutex_);
-            latestSensorData_ = sensorData;
-            hasData_ = true;
+            // 逐字段复制，二进制样本不经过 toProto() 的临时消息
+            SensorData& latest = latestSensorData_[sensorId];
+            latest.set_sensor_id(sensorId);
+            latest.set_temperature(sensorData.temperature());
+            latest.set_humidity(sensorData.humidity());
+            latest.set_pressure(sensorData.pressure());
+            latest.set_timestamp(sensorData.timestamp());
+            latestSensorId_ = sensorId;
+        }
+
+        RollupEngine::Sample sample;
+        sample.timestampMs = sensorData.timestamp();
+        sample.values = {sensorData.temperature(), sensorData.humidity(), sensorData.pressure()};
+        rollups_->add(sensorId, sample);
+        if (store_) {
+            store_->append(sensorId, sample);
         }
     }
 
-    void WebApp::handleAlgorithmResult(const std::string& eventType, const std::string& data)
+    void WebApp::handleSensorBatch(const SensorBatch& batch)
     {
-        AlgorithmResult result;
-        if (!result.ParseFromString(data)) {
-            std::cerr << "[WebApp] Failed to parse algorithm result" << std::endl;
+        // 页面只展示最新值，取批次最后一个样本
+        int last = batch.temperature_size() - 1;
+        if (last < 0 || batch.humidity_size() <= last || batch.pressure_size() <= last ||
+            batch.timestamps_us_size() <= last) {
             return;
         }
-        
+
+        // 历史汇总需要全部样本，整批一次加锁写入
+        thread_local std::vector<RollupEngine::Sample> samples;
+        samples.resize(last + 1);
+        for (int i = 0; i <= last; ++i) {
+            samples[i].timestampMs = batch.timestamps_us(i) / 1000;
+            samples[i].values = {batch.temperature(i), batch.humidity(i), batch.pressure(i)};
+        }
+        rollups_->add(batch.sensor_id(), samples.data(), samples.size());
+        if (store_) {
+            store_->append(batch.sensor_id(), samples.data(), samples.size());
+        }
+
+        std::lock_guard<std::mutex> lock(dataMutex_);
+        SensorData& latest = latestSensorData_[batch.sensor_id()];
+        latest.set_sensor_id(batch.sensor_id());
+        latest.set_temperature(batch.temperature(last));
+        latest.set_humidity(batch.humidity(last));
+        latest.set_pressure(batch.pressure(last));
+        latest.set_timestamp(batch.timestamps_us(last) / 1000);
+        latestSensorId_ = batch.sensor_id();
+    }
+
+    void WebApp::handleAlgorithmResult(const AlgorithmResult& result)
+    {
+        // 结果按传感器分别保存，不同传感器的结果不会互相覆盖
         std::lock_guard<std::mutex> lock(dataMutex_);
-        latestResult_ = result;
+        latestResults_[result.sensor_id()] = result;
     }
 
     std::string WebApp::handleHttpRequest(const std::string& method, const std::string& path, const std::string& body) {
         std::cout << "[WebApp] " << method << " " << path << std::endl;
         
         std::ostringstream response;
+        size_t queryPos = path.find('?');
+        std::string route = path.substr(0, queryPos);
+        std::string query = queryPos == std::string::npos ? "" : path.substr(queryPos + 1);
         
         // Route requests to appropriate handlers
-        if (method == "GET" && path == "/api/data") {
+        if (method == "GET" && route == "/api/data") {
             response << "HTTP/1.1 200 OK\r\n";
             response << "Content-Type: application/json\r\n";
             response << "Access-Control-Allow-Origin: *\r\n";
             response << "Connection: close\r\n\r\n";
-            response << handleGetData();
+            response << handleGetData(query);
+        }
+        else if (method == "GET" && route == "/api/history") {
+            std::string json;
+            int status = handleGetHistory(query, json);
+            response << (status == 200 ? "HTTP/1.1 200 OK\r\n" :
+                         status == 404 ? "HTTP/1.1 404 Not Found\r\n" : "HTTP/1.1 400 Bad Request\r\n");
+            response << "Content-Type: application/json\r\n";
+            response << "Access-Control-Allow-Origin: *\r\n";
+            response << "Connection: close\r\n\r\n";
+            response << json;
         }
         else if (method == "POST" && path == "/api/config") {
             response << "HTTP/1.1 200 OK\r\n";
@@ -129,27 +371,36 @@ namespace webapp
         return response.str();
     }
 
-    std::string WebApp::handleGetData() {
+    std::string WebApp::handleGetData(const std::string& query) {
+        std::map<std::string, std::string> params = parseQuery(query);
         std::lock_guard<std::mutex> lock(dataMutex_);
         
+        auto sensorParam = params.find("sensor");
+        const std::string& sensorId = sensorParam != params.end() ? sensorParam->second : latestSensorId_;
+        auto data = latestSensorData_.find(sensorId);
+        auto result = latestResults_.find(sensorId);
+
         std::ostringstream json;
         json << "{";
         
-        if (hasData_) {
+        if (data != latestSensorData_.end()) {
+            const SensorData& latest = data->second;
             json << std::fixed << std::setprecision(2);
+            json << "\"sensorId\": \"" << jsonEscape(sensorId) << "\",";
             json << "\"sensorData\": {";
-            json << "\"temperature\": " << latestSensorData_.temperature() << ",";
-            json << "\"humidity\": " << latestSensorData_.humidity() << ",";
-            json << "\"pressure\": " << latestSensorData_.pressure() << ",";
-            json << "\"timestamp\": " << latestSensorData_.timestamp();
+            json << "\"temperature\": " << latest.temperature() << ",";
+            json << "\"humidity\": " << latest.humidity() << ",";
+            json << "\"pressure\": " << latest.pressure() << ",";
+            json << "\"timestamp\": " << latest.timestamp();
             json << "},";
             
-            if (latestResult_.comfort_index() > 0) {
+            if (result != latestResults_.end()) {
+                const AlgorithmResult& latestResult = result->second;
                 json << "\"algorithmResult\": {";
-                json << "\"comfortIndex\": " << latestResult_.comfort_index() << ",";
-                json << "\"alertLevel\": \"" << latestResult_.alert_level() << "\",";
-                json << "\"recommendation\": \"" << latestResult_.recommendation() << "\",";
-                json << "\"timestamp\": " << latestResult_.timestamp();
+                json << "\"comfortIndex\": " << latestResult.comfort_index() << ",";
+                json << "\"alertLevel\": \"" << latestResult.alert_level() << "\",";
+                json << "\"recommendation\": \"" << latestResult.recommendation() << "\",";
+                json << "\"timestamp\": " << latestResult.timestamp();
                 json << "}";
             } else {
                 json << "\"algorithmResult\": null";
@@ -163,6 +414,131 @@ namespace webapp
         return json.str();
     }
 
+    int WebApp::handleGetHistory(const std::string& query, std::string& json) {
+        std::map<std::string, std::string> params = parseQuery(query);
+        auto param = [&params](const char* name) -> const std::string* {
+            auto it = params.find(name);
+            return it == params.end() ? nullptr : &it->second;
+        };
+
+        const std::string* sensor = param("sensor");
+        if (!sensor || sensor->empty()) {
+            json = "{\"error\": \"Missing sensor\"}";
+            return 400;
+        }
+        int64_t to = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count() + 1;
+        if (param("to") && !parseInt64(*param("to"), to)) {
+            json = "{\"error\": \"Invalid to\"}";
+            return 400;
+        }
+        int64_t from = to - DEFAULT_HISTORY_RANGE_MS;
+        if (param("from") && !parseInt64(*param("from"), from)) {
+            json = "{\"error\": \"Invalid from\"}";
+            return 400;
+        }
+        // 限制在 epoch 毫秒的合理范围内，避免范围宽度计算溢出
+        from = std::max<int64_t>(from, 0);
+        to = std::min<int64_t>(to, MAX_HISTORY_TIMESTAMP_MS);
+        if (from >= to) {
+            json = "{\"error\": \"Empty time range\"}";
+            return 400;
+        }
+        int64_t points = static_cast<int64_t>(DEFAULT_HISTORY_POINTS);
+        if (param("points") && !parseInt64(*param("points"), points)) {
+            json = "{\"error\": \"Invalid points\"}";
+            return 400;
+        }
+        points = std::max<int64_t>(2, std::min<int64_t>(points, static_cast<int64_t>(MAX_HISTORY_POINTS)));
+        bool minMax = false;
+        if (const std::string* mode = param("mode")) {
+            if (*mode == "minmax") {
+                minMax = true;
+            } else if (*mode != "lttb") {
+                json = "{\"error\": \"Invalid mode\"}";
+                return 400;
+            }
+        }
+
+        // 数据源：原始样本足够少时直接读存储，否则用点数不超过预算的最细汇总分辨率
+        size_t budget = static_cast<size_t>(points) * HISTORY_OVERSAMPLE;
+        std::vector<TimeSeriesSample> samples;
+        std::vector<RollupEngine::Bucket> buckets;
+        int64_t resolutionMs = 0;
+        bool raw = false;
+        if (store_ && store_->estimate(*sensor, from, to) <= budget) {
+            raw = store_->scan(*sensor, from, to, samples) > 0;
+        }
+        if (!raw) {
+            int level = rollups_->query(*sensor, from, to, budget, buckets);
+            if (level < 0) {
+                json = "{\"error\": \"Unknown sensor\"}";
+                return 404;
+            }
+            resolutionMs = rollups_->resolutions()[level].widthMs;
+        }
+        size_t inputCount = raw ? samples.size() : buckets.size();
+
+        static const char* const METRIC_NAMES[RollupEngine::METRIC_COUNT] = {"temperature", "humidity", "pressure"};
+        std::vector<Downsampler::Point> input;
+        std::vector<Downsampler::Envelope> envelopes;
+        std::vector<Downsampler::Point> output;
+
+        std::ostringstream out;
+        out << "{\"sensor\": \"" << jsonEscape(*sensor) << "\",";
+        out << "\"from\": " << from << ",";
+        out << "\"to\": " << to << ",";
+        out << "\"source\": \"" << (raw ? "raw" : "rollup") << "\",";
+        out << "\"resolutionMs\": " << resolutionMs << ",";
+        out << "\"mode\": \"" << (minMax ? "minmax" : "lttb") << "\",";
+        out << "\"inputPoints\": " << inputCount << ",";
+        out << "\"series\": {";
+        out << std::fixed << std::setprecision(2);
+        for (size_t metric = 0; metric < RollupEngine::METRIC_COUNT; ++metric) {
+            // 跳过 NaN / Inf，JSON 无法表示且会破坏三角形面积计算
+            input.clear();
+            envelopes.clear();
+            for (size_t i = 0; i < inputCount; ++i) {
+                int64_t timestamp;
+                double value;
+                double low;
+                double high;
+                if (raw) {
+                    timestamp = samples[i].timestampMs;
+                    value = low = high = samples[i].values[metric];
+                } else {
+                    const RollupEngine::Bucket& bucket = buckets[i];
+                    timestamp = bucket.startMs;
+                    value = bucket.avg(static_cast<RollupEngine::Metric>(metric));
+                    low = bucket.metrics[metric].min;
+                    high = bucket.metrics[metric].max;
+                }
+                if (!std::isfinite(value) || !std::isfinite(low) || !std::isfinite(high)) {
+                    continue;
+                }
+                if (minMax) {
+                    envelopes.push_back({timestamp, low, high});
+                } else {
+                    input.push_back({timestamp, value});
+                }
+            }
+            if (minMax) {
+                Downsampler::minMax(envelopes.data(), envelopes.size(), static_cast<size_t>(points), output);
+            } else {
+                Downsampler::lttb(input.data(), input.size(), static_cast<size_t>(points), output);
+            }
+
+            out << (metric ? "," : "") << "\"" << METRIC_NAMES[metric] << "\": [";
+            for (size_t i = 0; i < output.size(); ++i) {
+                out << (i ? "," : "") << "[" << output[i].timestampMs << "," << output[i].value << "]";
+            }
+            out << "]";
+        }
+        out << "}}";
+        json = out.str();
+        return 200;
+    }
+
     std::string WebApp::handlePostConfig(const std::string& body) {
         std::cout << "[WebApp] Configuration update: " << body << std::endl;
         
@@ -180,7 +556,9 @@ namespace webapp
         
         if (body.find("\"action\": \"reset\"") != std::string::npos) {
             std::lock_guard<std::mutex> lock(dataMutex_);
-            hasData_ = false;
+            latestSensorData_.clear();
+            latestResults_.clear();
+            latestSensorId_.clear();
             return "{\"status\": \"success\", \"message\": \"Data reset\"}";
         }
         
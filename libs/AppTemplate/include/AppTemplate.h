@@ -1,10 +1,14 @@
 // AppTemplate.h - Fixed version
 #pragma once
 #include "EventBus.h"
+#include "TypedTopic.h"
+#include "EventLoop.h"
 #include <string>
 #include <memory>
 #include <atomic>
 #include <csignal>
+#include <chrono>
+#include <cstdint>
 
 class AppTemplate {
 public:
@@ -13,12 +17,30 @@ public:
 
     // 事件处理接口
     void postEvent(const std::string& eventType, const std::string& data);
-    void broadcast(const std::string& eventType, const std::string& data);
+    void broadcast(const std::string& eventType, const std::string& data, const std::string& key = "");
     void registerHandler(const std::string& eventType, EventBus::EventHandler handler);
 
+    // 类型化主题接口，负载类型不匹配时编译报错
+    template <typename TopicT, typename... Handlers>
+    void subscribe(Handlers&&... handlers) {
+        if (eventBus_) {
+            ::subscribe<TopicT>(*eventBus_, std::forward<Handlers>(handlers)...);
+        }
+    }
+
+    template <typename TopicT>
+    void publish(const typename TopicT::PayloadType& payload, const std::string& key = "") {
+        if (eventBus_) {
+            ::publish<TopicT>(*eventBus_, payload, key);
+        }
+    }
+
     // 连接其他应用
     void connectToPeer(const std::string& host, int port);
 
+    // 事件日志，需在 start() 之前调用；配置文件中的 "eventbus.journal" 会自动启用
+    bool enableJournal(const EventJournal::Options& options);
+
     // 应用生命周期
     virtual void initialize() = 0;
     virtual void run() = 0;
@@ -29,10 +51,33 @@ public:
     
     bool isRunning() const { return running_.load(); }
 
+    // 定时任务（线程安全），回调在事件循环线程执行
+    EventLoop::TimerId runAfter(std::chrono::milliseconds delay, EventLoop::Task task);
+    EventLoop::TimerId runEvery(std::chrono::milliseconds interval, EventLoop::Task task);
+    void cancelTimer(EventLoop::TimerId id);
+    void post(EventLoop::Task task);
+
 protected:
+    // 在 run() 中调用，阻塞直到 stop()
+    void runEventLoop();
+
+    // 加载 $APP_CONFIG 或 config/<appName>.json，并应用其中的 "threads" / "eventbus" 配置
+    void loadConfiguration();
+    void configureThreads();
+    void configureIoBackend();
+    void configureListener();
+    void configureJournal();
+    // initialize() 注册处理器之后回放日志，恢复重启前的状态；回放期间收到的远端事件暂存，回放结束后再投递
+    void replayJournalOnStart();
+
     std::string appName_;
     std::unique_ptr<EventBus> eventBus_;
+    std::unique_ptr<EventLoop> eventLoop_;
     std::atomic<bool> running_;
+
+    bool journalReplay_;
+    int64_t journalReplayWindowMs_;  // 0 表示回放全部保留的日志
+    std::chrono::milliseconds journalFlushInterval_;
     
     // Static signal handling
     static void signalHandler(int signal);
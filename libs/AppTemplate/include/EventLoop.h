@@ -0,0 +1,47 @@
+// EventLoop.h
+#pragma once
+#include "TimerWheel.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// 应用主事件循环：任务队列 + 1ms 精度分层时间轮
+// 空闲时阻塞到下一个定时器到期，stop()/post() 立即唤醒
+class EventLoop {
+public:
+    using Task = std::function<void()>;
+    using TimerId = TimerWheel::TimerId;
+
+    EventLoop();
+    ~EventLoop();
+
+    // 在当前线程运行，直到 stop()
+    void run();
+    void stop();
+    bool isRunning() const { return running_.load(); }
+
+    // 以下接口线程安全
+    void post(Task task);
+    TimerId runAfter(std::chrono::milliseconds delay, Task task);
+    TimerId runEvery(std::chrono::milliseconds interval, Task task);
+    void cancel(TimerId id);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    TimerId addTimer(std::chrono::milliseconds delay, std::chrono::milliseconds interval, Task task);
+    uint64_t currentTick() const;
+    void runPendingTasks();
+
+    const Clock::time_point startTime_;
+    TimerWheel wheel_;
+    std::vector<Task> pendingTasks_;
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::atomic<bool> running_;
+    std::atomic<bool> stopRequested_;
+    std::atomic<TimerId> nextTimerId_;
+};
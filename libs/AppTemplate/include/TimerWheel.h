@@ -0,0 +1,63 @@
+// TimerWheel.h
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// 分层时间轮（参考 Linux 内核 timer wheel）
+//   第 0 层 256 个槽，每槽 1 tick；第 1-3 层各 64 个槽，逐层放大 64 倍
+//   添加/取消 O(1)，推进时按需将高层槽级联到低层
+// 非线程安全，只在 EventLoop 线程中使用
+class TimerWheel {
+public:
+    using TimerId = uint64_t;
+    using Callback = std::function<void()>;
+
+    explicit TimerWheel(uint64_t startTick = 0);
+
+    // intervalTicks 为 0 表示单次定时器
+    void add(TimerId id, uint64_t expiryTick, uint64_t intervalTicks, Callback callback);
+    bool cancel(TimerId id);
+
+    // 处理所有到期时间 <= nowTick 的定时器
+    void advance(uint64_t nowTick);
+
+    // 距离下一次需要处理的 tick 数；没有定时器时返回 UINT64_MAX
+    uint64_t ticksUntilNext() const;
+
+    uint64_t currentTick() const { return currentTick_; }
+    size_t size() const { return timers_.size(); }
+
+private:
+    static constexpr int ROOT_BITS = 8;
+    static constexpr int LEVEL_BITS = 6;
+    static constexpr int LEVELS = 4;
+    static constexpr uint64_t ROOT_SIZE = 1ULL << ROOT_BITS;
+    static constexpr uint64_t LEVEL_SIZE = 1ULL << LEVEL_BITS;
+    static constexpr uint64_t MAX_SPAN = 1ULL << (ROOT_BITS + (LEVELS - 1) * LEVEL_BITS);
+
+    struct Timer;
+    using Slot = std::list<Timer*>;
+
+    struct Timer {
+        TimerId id;
+        uint64_t expiry;
+        uint64_t interval;
+        Callback callback;
+        Slot* slot = nullptr;
+        Slot::iterator position;
+        bool cancelled = false;
+    };
+
+    void schedule(Timer* timer);
+    void unlink(Timer* timer);
+    uint64_t cascade(int level);
+    void fire(Timer* timer);
+
+    std::vector<std::vector<Slot>> levels_;
+    std::unordered_map<TimerId, std::unique_ptr<Timer>> timers_;
+    uint64_t currentTick_;  // 下一个待处理的 tick
+};
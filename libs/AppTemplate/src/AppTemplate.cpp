@@ -1,6 +1,11 @@
 // AppTemplate.cpp - Fixed version
 #include "AppTemplate.h"
+#include "ConfigManager.h"
+#include "ThreadPlacement.h"
 #include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <sys/socket.h>
 #include <random>
 #include <thread>
 #include <chrono>
@@ -9,8 +14,11 @@
 AppTemplate* AppTemplate::currentApp_ = nullptr;
 
 AppTemplate::AppTemplate(const std::string& appName, int port) 
-    : appName_(appName), running_(false) {
+    : appName_(appName), running_(false), journalReplay_(false), journalReplayWindowMs_(0),
+      journalFlushInterval_(0) {
     
+    loadConfiguration();
+
     // 如果端口为0，随机分配
     if (port == 0) {
         std::random_device rd;
@@ -20,6 +28,10 @@ AppTemplate::AppTemplate(const std::string& appName, int port)
     }
     
     eventBus_ = std::make_unique<EventBus>(port);
+    configureIoBackend();
+    configureListener();
+    configureJournal();
+    eventLoop_ = std::make_unique<EventLoop>();
     std::cout << "[" << appName_ << "] Initialized on port " << port << std::endl;
     
     // Set up signal handling
@@ -40,9 +52,9 @@ void AppTemplate::postEvent(const std::string& eventType, const std::string& dat
     }
 }
 
-void AppTemplate::broadcast(const std::string& eventType, const std::string& data) {
+void AppTemplate::broadcast(const std::string& eventType, const std::string& data, const std::string& key) {
     if (eventBus_) {
-        eventBus_->broadcast(eventType, data);
+        eventBus_->broadcast(eventType, data, key);
     }
 }
 
@@ -60,6 +72,192 @@ void AppTemplate::connectToPeer(const std::string& host, int port) {
     }
 }
 
+EventLoop::TimerId AppTemplate::runAfter(std::chrono::milliseconds delay, EventLoop::Task task) {
+    return eventLoop_->runAfter(delay, std::move(task));
+}
+
+EventLoop::TimerId AppTemplate::runEvery(std::chrono::milliseconds interval, EventLoop::Task task) {
+    return eventLoop_->runEvery(interval, std::move(task));
+}
+
+void AppTemplate::cancelTimer(EventLoop::TimerId id) {
+    eventLoop_->cancel(id);
+}
+
+void AppTemplate::post(EventLoop::Task task) {
+    eventLoop_->post(std::move(task));
+}
+
+void AppTemplate::runEventLoop() {
+    // 事件循环运行在独立线程：timer 角色的绑核/调度只作用于该线程，
+    // 不会泄漏给主线程之后创建的线程
+    std::thread loopThread([this]() {
+        ThreadPlacement::getInstance().apply(ThreadRole::Timer, "timer");
+        eventLoop_->run();
+    });
+    loopThread.join();
+}
+
+void AppTemplate::loadConfiguration() {
+    const char* envPath = std::getenv("APP_CONFIG");
+    std::string path = envPath ? envPath : "config/" + appName_ + ".json";
+    if (std::ifstream(path).good()) {
+        ConfigManager::getInstance().loadConfig(path);
+    }
+    configureThreads();
+}
+
+void AppTemplate::configureThreads() {
+    // "threads": { "io": { "cpus": [2, 3], "spread": false, "policy": "fifo", "priority": 50, "count": 2 }, ... }
+    const rapidjson::Value* threads = ConfigManager::getInstance().getObject("threads");
+    if (!threads) {
+        return;
+    }
+
+    for (ThreadRole role : {ThreadRole::IO, ThreadRole::Dispatch, ThreadRole::App, ThreadRole::Timer}) {
+        const char* name = ThreadPlacement::roleName(role);
+        if (!threads->HasMember(name) || !(*threads)[name].IsObject()) {
+            continue;
+        }
+        const rapidjson::Value& config = (*threads)[name];
+
+        ThreadPolicy policy;
+        if (config.HasMember("cpus") && config["cpus"].IsArray()) {
+            const rapidjson::Value& cpus = config["cpus"];
+            for (rapidjson::SizeType i = 0; i < cpus.Size(); i++) {
+                if (!cpus[i].IsInt() || !ThreadPlacement::isValidCpu(cpus[i].GetInt())) {
+                    std::cerr << "[" << appName_ << "] Thread role '" << name << "': invalid cpu id at index "
+                              << i << ", expected 0.." << (CPU_SETSIZE - 1) << std::endl;
+                    continue;
+                }
+                int cpu = cpus[i].GetInt();
+                if (!ThreadPlacement::getInstance().isCpuAllowed(cpu)) {
+                    std::cerr << "[" << appName_ << "] Thread role '" << name << "': cpu " << cpu
+                              << " is not in the process affinity mask" << std::endl;
+                }
+                policy.cpus.push_back(cpu);
+            }
+        }
+        if (config.HasMember("spread") && config["spread"].IsBool()) {
+            policy.spread = config["spread"].GetBool();
+        }
+        if (config.HasMember("policy") && config["policy"].IsString()) {
+            policy.schedPolicy = ThreadPlacement::parseSchedPolicy(config["policy"].GetString());
+        }
+        if (config.HasMember("priority") && config["priority"].IsInt()) {
+            policy.priority = config["priority"].GetInt();
+        }
+        if (config.HasMember("count") && config["count"].IsInt()) {
+            // 事件循环只有一个线程，timer 角色的 count 没有意义
+            if (role == ThreadRole::Timer) {
+                std::cerr << "[" << appName_ << "] Thread role '" << name
+                          << "': count is not supported (single event loop thread), ignored" << std::endl;
+            } else {
+                policy.count = config["count"].GetInt();
+            }
+        }
+
+        ThreadPlacement::getInstance().setPolicy(role, policy);
+        std::cout << "[" << appName_ << "] Thread role '" << name << "': " << policy.cpus.size()
+                  << " cpu(s), count " << policy.count << std::endl;
+    }
+}
+
+void AppTemplate::configureIoBackend() {
+    // 环境变量 EVENTBUS_IO_BACKEND 优先于配置文件 "eventbus": { "io_backend": "io_uring" }
+    const char* envBackend = std::getenv("EVENTBUS_IO_BACKEND");
+    std::string name = envBackend ? envBackend
+                                  : ConfigManager::getInstance().getString("eventbus", "io_backend", "blocking");
+
+    IoBackend backend;
+    if (!UringReactor::parseBackend(name, backend)) {
+        std::cerr << "[" << appName_ << "] Unknown I/O backend '" << name << "', using blocking" << std::endl;
+        return;
+    }
+    if (backend == IoBackend::IoUring && !UringReactor::isSupported()) {
+        std::cerr << "[" << appName_ << "] io_uring not supported by this kernel, using blocking" << std::endl;
+        return;
+    }
+    eventBus_->setIoBackend(backend);
+    std::cout << "[" << appName_ << "] I/O backend: " << UringReactor::backendName(backend) << std::endl;
+}
+
+void AppTemplate::configureListener() {
+    // "eventbus": { "listen_shards": 4, "backlog": 4096 }
+    // 每个监听分片有自己的 accept 线程（io_uring 下为反应器线程），listen_shards 缺省取 threads.io.count
+    ConfigManager& config = ConfigManager::getInstance();
+    int ioThreads = ThreadPlacement::getInstance().threadCount(ThreadRole::IO, 1);
+    int shards = config.getInt("eventbus", "listen_shards", ioThreads);
+    int backlog = config.getInt("eventbus", "backlog", SOMAXCONN);
+    eventBus_->setListenOptions(shards, backlog);
+}
+
+void AppTemplate::configureJournal() {
+    // "eventbus": { "journal": { "directory": "journal_app", "segment_size_mb": 64, "max_segments": 16,
+    //                            "flush_interval_ms": 1000, "replay_on_start": true, "replay_window_s": 0 } }
+    const rapidjson::Value* eventbus = ConfigManager::getInstance().getObject("eventbus");
+    if (!eventbus || !eventbus->HasMember("journal") || !(*eventbus)["journal"].IsObject()) {
+        return;
+    }
+    const rapidjson::Value& config = (*eventbus)["journal"];
+    if (config.HasMember("enabled") && config["enabled"].IsBool() && !config["enabled"].GetBool()) {
+        return;
+    }
+
+    EventJournal::Options options;
+    options.directory = "journal_" + appName_;
+    if (config.HasMember("directory") && config["directory"].IsString()) {
+        options.directory = config["directory"].GetString();
+    }
+    if (config.HasMember("segment_size_mb") && config["segment_size_mb"].IsInt() && config["segment_size_mb"].GetInt() > 0) {
+        options.segmentSize = static_cast<size_t>(config["segment_size_mb"].GetInt()) * 1024 * 1024;
+    }
+    if (config.HasMember("max_segments") && config["max_segments"].IsInt() && config["max_segments"].GetInt() > 0) {
+        options.maxSegments = static_cast<size_t>(config["max_segments"].GetInt());
+    }
+    if (config.HasMember("flush_interval_ms") && config["flush_interval_ms"].IsInt() && config["flush_interval_ms"].GetInt() > 0) {
+        journalFlushInterval_ = std::chrono::milliseconds(config["flush_interval_ms"].GetInt());
+    }
+    if (config.HasMember("replay_on_start") && config["replay_on_start"].IsBool()) {
+        journalReplay_ = config["replay_on_start"].GetBool();
+    }
+    if (config.HasMember("replay_window_s") && config["replay_window_s"].IsInt() && config["replay_window_s"].GetInt() > 0) {
+        journalReplayWindowMs_ = static_cast<int64_t>(config["replay_window_s"].GetInt()) * 1000;
+    }
+
+    if (!enableJournal(options)) {
+        journalReplay_ = false;
+        journalFlushInterval_ = std::chrono::milliseconds(0);
+        return;
+    }
+    std::cout << "[" << appName_ << "] Event journal: " << options.directory
+              << (journalReplay_ ? " (replay on start)" : "") << std::endl;
+}
+
+bool AppTemplate::enableJournal(const EventJournal::Options& options) {
+    return eventBus_ && eventBus_->enableJournal(options);
+}
+
+void AppTemplate::replayJournalOnStart() {
+    if (journalFlushInterval_.count() > 0) {
+        runEvery(journalFlushInterval_, [this]() { eventBus_->flushJournal(); });
+    }
+    if (!journalReplay_) {
+        return;
+    }
+
+    size_t replayed;
+    if (journalReplayWindowMs_ > 0) {
+        int64_t since = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count() - journalReplayWindowMs_;
+        replayed = eventBus_->replayJournalSince(since);
+    } else {
+        replayed = eventBus_->replayJournal(0);
+    }
+    std::cout << "[" << appName_ << "] Replayed " << replayed << " journaled event(s)" << std::endl;
+    eventBus_->releaseRemoteEvents();
+}
+
 void AppTemplate::start() {
     if (running_.load()) {
         std::cout << "[" << appName_ << "] Already running" << std::endl;
@@ -69,10 +267,15 @@ void AppTemplate::start() {
     running_.store(true);
     
     try {
+        // 回放完成前收到的远端事件先暂存：对端在 initialize() 连接后即可发送，不能先于重启前的状态到达处理器
+        if (journalReplay_) {
+            eventBus_->holdRemoteEvents();
+        }
         eventBus_->start();
         
         std::cout << "[" << appName_ << "] Starting application..." << std::endl;
         initialize();
+        replayJournalOnStart();
         run();
     } catch (const std::exception& e) {
         std::cerr << "[" << appName_ << "] Error during startup: " << e.what() << std::endl;
@@ -87,6 +290,7 @@ void AppTemplate::stop() {
     
     std::cout << "[" << appName_ << "] Stopping application..." << std::endl;
     running_.store(false);
+    eventLoop_->stop();
     
     try {
         cleanup();
@@ -0,0 +1,92 @@
+// EventLoop.cpp
+#include "EventLoop.h"
+#include <iostream>
+#include <algorithm>
+
+EventLoop::EventLoop()
+    : startTime_(Clock::now()), wheel_(0), running_(false), stopRequested_(false), nextTimerId_(1) {}
+
+EventLoop::~EventLoop() {
+    stop();
+}
+
+void EventLoop::run() {
+    running_.store(true);
+
+    while (!stopRequested_.load()) {
+        runPendingTasks();
+        wheel_.advance(currentTick());
+
+        uint64_t wait = wheel_.ticksUntilNext();
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto ready = [this]() { return stopRequested_.load() || !pendingTasks_.empty(); };
+        if (wait == UINT64_MAX) {
+            wakeup_.wait(lock, ready);
+        } else {
+            auto deadline = startTime_ + std::chrono::milliseconds(wheel_.currentTick() + wait);
+            wakeup_.wait_until(lock, deadline, ready);
+        }
+    }
+
+    running_.store(false);
+}
+
+void EventLoop::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopRequested_.store(true);
+    }
+    wakeup_.notify_all();
+}
+
+void EventLoop::post(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pendingTasks_.push_back(std::move(task));
+    }
+    wakeup_.notify_one();
+}
+
+EventLoop::TimerId EventLoop::runAfter(std::chrono::milliseconds delay, Task task) {
+    return addTimer(delay, std::chrono::milliseconds(0), std::move(task));
+}
+
+EventLoop::TimerId EventLoop::runEvery(std::chrono::milliseconds interval, Task task) {
+    return addTimer(interval, interval, std::move(task));
+}
+
+void EventLoop::cancel(TimerId id) {
+    post([this, id]() { wheel_.cancel(id); });
+}
+
+EventLoop::TimerId EventLoop::addTimer(std::chrono::milliseconds delay, std::chrono::milliseconds interval,
+                                       Task task) {
+    TimerId id = nextTimerId_.fetch_add(1);
+    // 到期时间在调用时确定，不受投递延迟影响
+    uint64_t expiry = currentTick() + static_cast<uint64_t>(std::max<int64_t>(delay.count(), 0));
+    uint64_t ticks = static_cast<uint64_t>(std::max<int64_t>(interval.count(), 0));
+    post([this, id, expiry, ticks, task = std::move(task)]() mutable {
+        wheel_.add(id, expiry, ticks, std::move(task));
+    });
+    return id;
+}
+
+uint64_t EventLoop::currentTick() const {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        Clock::now() - startTime_).count());
+}
+
+void EventLoop::runPendingTasks() {
+    std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks.swap(pendingTasks_);
+    }
+    for (auto& task : tasks) {
+        try {
+            task();
+        } catch (const std::exception& e) {
+            std::cerr << "[EventLoop] Error in task: " << e.what() << std::endl;
+        }
+    }
+}
@@ -0,0 +1,148 @@
+// TimerWheel.cpp
+#include "TimerWheel.h"
+#include <iostream>
+
+TimerWheel::TimerWheel(uint64_t startTick) : currentTick_(startTick) {
+    levels_.resize(LEVELS);
+    levels_[0].resize(ROOT_SIZE);
+    for (int level = 1; level < LEVELS; ++level) {
+        levels_[level].resize(LEVEL_SIZE);
+    }
+}
+
+void TimerWheel::add(TimerId id, uint64_t expiryTick, uint64_t intervalTicks, Callback callback) {
+    cancel(id);
+
+    auto timer = std::make_unique<Timer>();
+    timer->id = id;
+    timer->expiry = expiryTick;
+    timer->interval = intervalTicks;
+    timer->callback = std::move(callback);
+
+    Timer* raw = timer.get();
+    timers_.emplace(id, std::move(timer));
+    schedule(raw);
+}
+
+bool TimerWheel::cancel(TimerId id) {
+    auto it = timers_.find(id);
+    if (it == timers_.end()) {
+        return false;
+    }
+
+    Timer* timer = it->second.get();
+    if (!timer->slot) {
+        // 正在回调中：延后到回调结束再释放
+        timer->cancelled = true;
+        return true;
+    }
+    unlink(timer);
+    timers_.erase(it);
+    return true;
+}
+
+void TimerWheel::advance(uint64_t nowTick) {
+    while (currentTick_ <= nowTick) {
+        uint64_t index = currentTick_ & (ROOT_SIZE - 1);
+
+        // 第 0 层转完一圈时，从上层依次级联
+        if (index == 0) {
+            for (int level = 1; level < LEVELS && cascade(level) == 0; ++level) {
+            }
+        }
+        ++currentTick_;
+
+        Slot& slot = levels_[0][index];
+        while (!slot.empty()) {
+            Timer* timer = slot.front();
+            slot.pop_front();
+            timer->slot = nullptr;
+            fire(timer);
+        }
+    }
+}
+
+uint64_t TimerWheel::ticksUntilNext() const {
+    if (timers_.empty()) {
+        return UINT64_MAX;
+    }
+
+    // 第 0 层内查找最近的非空槽；找不到则在下次级联时再检查
+    uint64_t toCascade = ROOT_SIZE - (currentTick_ & (ROOT_SIZE - 1));
+    for (uint64_t delta = 0; delta < toCascade; ++delta) {
+        if (!levels_[0][(currentTick_ + delta) & (ROOT_SIZE - 1)].empty()) {
+            return delta;
+        }
+    }
+    return toCascade;
+}
+
+void TimerWheel::schedule(Timer* timer) {
+    uint64_t expiry = timer->expiry;
+    Slot* slot;
+
+    if (expiry < currentTick_) {
+        // 已过期，放入下一个待处理槽
+        slot = &levels_[0][currentTick_ & (ROOT_SIZE - 1)];
+    } else {
+        uint64_t delta = expiry - currentTick_;
+        if (delta >= MAX_SPAN) {
+            // 超出时间轮范围：先放在最高层最远处，级联时再重新计算
+            expiry = currentTick_ + MAX_SPAN - 1;
+            delta = MAX_SPAN - 1;
+        }
+
+        if (delta < ROOT_SIZE) {
+            slot = &levels_[0][expiry & (ROOT_SIZE - 1)];
+        } else {
+            int level = 1;
+            while (delta >= (1ULL << (ROOT_BITS + level * LEVEL_BITS))) {
+                ++level;
+            }
+            int shift = ROOT_BITS + (level - 1) * LEVEL_BITS;
+            slot = &levels_[level][(expiry >> shift) & (LEVEL_SIZE - 1)];
+        }
+    }
+
+    timer->slot = slot;
+    timer->position = slot->insert(slot->end(), timer);
+}
+
+void TimerWheel::unlink(Timer* timer) {
+    if (timer->slot) {
+        timer->slot->erase(timer->position);
+        timer->slot = nullptr;
+    }
+}
+
+uint64_t TimerWheel::cascade(int level) {
+    int shift = ROOT_BITS + (level - 1) * LEVEL_BITS;
+    uint64_t index = (currentTick_ >> shift) & (LEVEL_SIZE - 1);
+
+    Slot pending;
+    pending.swap(levels_[level][index]);
+    for (Timer* timer : pending) {
+        timer->slot = nullptr;
+        schedule(timer);
+    }
+    return index;
+}
+
+void TimerWheel::fire(Timer* timer) {
+    try {
+        timer->callback();
+    } catch (const std::exception& e) {
+        std::cerr << "[TimerWheel] Error in timer " << timer->id << ": " << e.what() << std::endl;
+    }
+
+    if (timer->cancelled || timer->interval == 0) {
+        timers_.erase(timer->id);
+        return;
+    }
+
+    // 按绝对时间重新排期，避免周期任务累积漂移；落后时跳过错过的周期
+    do {
+        timer->expiry += timer->interval;
+    } while (timer->expiry < currentTick_);
+    schedule(timer);
+}
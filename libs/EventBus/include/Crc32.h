@@ -0,0 +1,27 @@
+// Crc32.h
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// CRC-32（IEEE 802.3，反射多项式 0xEDB88320），查表实现；事件日志、时间序列段和状态检查点共用。
+// 可分段计算：crc 为前面各段的结果，首段传 0
+inline uint32_t crc32(uint32_t crc, const char* data, size_t length) {
+    static const std::array<uint32_t, 256> table = []() {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+
+    crc ^= 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
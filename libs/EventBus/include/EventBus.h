@@ -7,38 +7,128 @@
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <deque>
+#include <condition_variable>
 #include "event_message.pb.h"
+#include "EventJournal.h"
+#include "RetainedCache.h"
+#include "TopicTrie.h"
+#include "ThreadPlacement.h"
+#include "UringReactor.h"
 
 class TcpServer;
 class TcpClient;
 
+// 每个 registerHandler 一个订阅。同一时刻最多一个线程（draining）调用处理器，
+// 其余线程把事件放入 pending 后立即返回，不会因处理器互相发布事件而死锁
+struct TopicTrie::Subscription {
+    struct Pending {
+        std::string eventType;
+        std::string data;
+        uint64_t retainedSequence;
+    };
+
+    explicit Subscription(Handler h) : handler(std::move(h)) {}
+
+    Handler handler;
+    std::mutex mutex;
+    std::deque<Pending> pending;
+    bool draining = true;           // 注册回放完成前为 true，实时事件先排队
+    uint64_t replayedThrough = 0;   // 回放快照的保留序号，不大于它的广播已体现在回放中
+};
+
 class EventBus {
 public:
-    using EventHandler = std::function<void(const std::string&, const std::string&)>;
+    using EventHandler = TopicTrie::Handler;
 
     EventBus(int port = 12345);
     ~EventBus();
 
     // 本地事件处理
     void postEvent(const std::string& eventType, const std::string& data);
+    // eventType 支持通配符："sensor.*" 匹配一段，"sensor.#" 匹配其后任意段
+    //
+    // 投递语义：同一个处理器的调用是串行的（即使事件来自多个接收/分发线程），
+    // 注册时先回放保留状态，之后才投递实时事件；保留快照中已包含的广播不会再次投递。
+    // 处理器正在执行时到达的事件（包括处理器内部自己发布的事件）排队，由当前执行线程依次处理。
     void registerHandler(const std::string& eventType, EventHandler handler);
 
-    // 跨进程广播
-    void broadcast(const std::string& eventType, const std::string& data);
+    // 跨进程广播；每个 (eventType, key) 的最后一条消息会被保留，新订阅者连接后立即收到
+    void broadcast(const std::string& eventType, const std::string& data, const std::string& key = "");
     void connectToPeer(const std::string& host, int port);
 
     void start();
     void stop();
 
+    // TCP 收发后端，需在 start()/connectToPeer() 之前设置
+    void setIoBackend(IoBackend backend) { ioBackend_ = backend; }
+    // 监听分片数（SO_REUSEPORT）和 listen backlog，需在 start() 之前设置
+    void setListenOptions(int shards, int backlog) {
+        listenShards_ = shards;
+        listenBacklog_ = backlog;
+    }
+
+    // 保留消息容量，0 表示关闭
+    void setRetainedCapacity(size_t capacity);
+
+    // 事件日志（可选）：记录所有经过总线的事件，用于重启恢复和离线分析。
+    // 只能在 start() 之前调用一次：接收线程不加锁读取 journal_
+    bool enableJournal(const EventJournal::Options& options);
+    // 把已追加的事件同步落盘（msync MS_SYNC），返回后可在掉电后恢复
+    void flushJournal();
+    // handler 为空时回放到本地处理器，只回放调用时已存在的事件
+    size_t replayJournal(uint64_t fromOffset, const EventJournal::ReplayHandler& handler = nullptr);
+    size_t replayJournalSince(int64_t timestampMs, const EventJournal::ReplayHandler& handler = nullptr);
+    // 启动回放期间暂存远端事件：hold 需在 start() 之前调用，此后收到的远端事件既不写日志也不分发，
+    // 回放只覆盖 hold 时日志中已有的事件；release 按到达顺序处理暂存的事件后恢复实时投递
+    void holdRemoteEvents();
+    void releaseRemoteEvents();
+
 private:
     void handleMessage(const EventMessage& message);
-    void distributeEvent(const std::string& eventType, const std::string& data);
+    // 写日志并分发一条远端事件
+    void acceptMessage(const EventMessage& message);
+    uint64_t replayEndOffset() const;
+    void journalEvent(const EventMessage& message);
+    void sendRetained(TcpClient& client);
+    void sendRetained(const std::string& clientEndpoint);
+    // retainedSequence 为 broadcast 写入保留缓存的序号，本地/远端事件为 0
+    void distributeEvent(const std::string& eventType, const std::string& data, uint64_t retainedSequence = 0);
+    void deliver(TopicTrie::Subscription& subscription, const std::string& eventType,
+                 const std::string& data, uint64_t retainedSequence);
+    void drain(TopicTrie::Subscription& subscription);
+    static void invoke(TopicTrie::Subscription& subscription, const std::string& eventType, const std::string& data);
+    void startDispatchers(int count);
+    void stopDispatchers();
+    void dispatchLoop(size_t index);
 
     int port_;
-    std::unordered_map<std::string, std::vector<EventHandler>> handlers_;
+    IoBackend ioBackend_;
+    int listenShards_;
+    int listenBacklog_;
+    using HandlerList = std::vector<TopicTrie::HandlerPtr>;
+    TopicTrie handlerTrie_;
+    // 具体主题 -> 已匹配的处理器列表，首次分发时生成，注册新处理器时清空
+    std::unordered_map<std::string, std::shared_ptr<const HandlerList>> matchCache_;
+    static constexpr size_t MATCH_CACHE_LIMIT = 4096;
     std::unique_ptr<TcpServer> server_;
+    std::unique_ptr<EventJournal> journal_;
+    RetainedCache retained_;
     std::vector<std::unique_ptr<TcpClient>> clients_;
+    // 分发线程池（ThreadRole::Dispatch 的 count > 0 时启用）：按 (event_type, key) 哈希分片，保证同键有序
+    struct DispatchQueue {
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::deque<std::shared_ptr<const EventMessage>> messages;
+    };
+    std::vector<std::unique_ptr<DispatchQueue>> dispatchQueues_;
+    std::vector<std::thread> dispatchThreads_;
+
     std::mutex handlersMutex_;
     std::mutex clientsMutex_;
     std::atomic<bool> running_;
+    std::atomic<bool> holding_;
+    uint64_t holdOffset_;  // hold 时日志的下一个偏移，回放到此为止
+    std::mutex heldMutex_;
+    std::deque<EventMessage> held_;
 };
\ No newline at end of file
@@ -0,0 +1,104 @@
+// EventJournal.h
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <ostream>
+#include <cstdint>
+#include "event_message.pb.h"
+
+// 追加写事件日志：固定大小的 mmap 段文件 + 稀疏 offset/时间索引
+//
+// 段文件布局（本机字节序）：
+//   [frame][frame]...[0 填充]
+//   frame = FrameHeader + EventMessage 序列化字节
+// 段写满后封存并写出 .idx 索引文件，超过 maxSegments 时删除最旧的段。
+//
+// 持久性：append() 只写入映射区（进程崩溃不丢，掉电可能丢）；flush() 和段封存
+// 同步写回段数据，封存时索引经 fsync + rename 原子落盘。
+class EventJournal {
+public:
+    struct Options {
+        std::string directory = "journal";
+        size_t segmentSize = 64 * 1024 * 1024;  // 每个段文件的固定大小
+        size_t indexIntervalBytes = 4096;       // 每隔多少字节记录一个索引点
+        size_t maxSegments = 16;                // 保留的最大段数量
+    };
+
+    // 返回 false 停止回放
+    using ReplayHandler = std::function<bool(uint64_t offset, const EventMessage& message)>;
+
+    explicit EventJournal(const Options& options);
+    ~EventJournal();
+
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    // 追加一条事件，返回其 offset；失败返回 UINT64_MAX
+    uint64_t append(const EventMessage& message);
+    // 同步写回活动段，返回后已追加的事件可在掉电后恢复
+    void flush();
+
+    // 从 offset（含）或追加时间（毫秒，含）开始顺序回放，返回回放条数
+    size_t replayFromOffset(uint64_t offset, const ReplayHandler& handler) const;
+    size_t replayFromTime(int64_t timestampMs, const ReplayHandler& handler) const;
+
+    // 删除所有完全位于 offset 之前的已封存段
+    void truncateBefore(uint64_t offset);
+
+    uint64_t firstOffset() const;
+    uint64_t nextOffset() const;
+
+private:
+    struct FrameHeader {
+        uint32_t length;     // 负载长度，0 表示段内数据结束
+        uint32_t checksum;   // 负载 CRC32
+        uint64_t offset;
+        int64_t appendTime;  // 追加时间（毫秒）
+    };
+
+    struct IndexEntry {
+        uint64_t offset;
+        int64_t appendTime;
+        uint32_t position;
+    };
+
+    struct Segment {
+        ~Segment();
+
+        uint64_t baseOffset = 0;
+        uint64_t nextOffset = 0;
+        std::string path;
+        int fd = -1;
+        char* data = nullptr;
+        size_t size = 0;
+        size_t writePos = 0;
+        int64_t firstTime = 0;
+        int64_t lastTime = 0;
+        bool sealed = false;
+        std::vector<IndexEntry> index;
+    };
+    using SegmentPtr = std::shared_ptr<Segment>;
+
+    SegmentPtr createSegment(uint64_t baseOffset);
+    SegmentPtr openSegment(const std::string& path, uint64_t baseOffset);
+    void recoverSegment(Segment& segment);
+    bool loadIndex(Segment& segment);
+    void sealSegment(Segment& segment);
+    static void writeIndex(std::ostream& file, const Segment& segment);
+    static bool syncPath(const std::string& path);
+    void enforceRetention();
+    std::string segmentPath(uint64_t baseOffset, const char* extension) const;
+
+    size_t replaySegments(const std::vector<SegmentPtr>& segments, uint64_t offset,
+                          int64_t timestampMs, const ReplayHandler& handler) const;
+
+
+    Options options_;
+    std::vector<SegmentPtr> segments_;
+    mutable std::mutex mutex_;
+    size_t lastIndexedPos_;
+};
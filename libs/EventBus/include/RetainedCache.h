@@ -0,0 +1,51 @@
+// RetainedCache.h
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+#include "event_message.pb.h"
+
+// 每个 (事件类型, key) 保留最后一条消息，供新连接的订阅者立即获取当前状态
+// 消息以 shared_ptr 共享，发布路径上不复制；容量满时淘汰最久未更新的条目
+class RetainedCache {
+public:
+    using MessagePtr = std::shared_ptr<const EventMessage>;
+
+    explicit RetainedCache(size_t capacity = 1024);
+
+    // 返回本次写入的序号（从 1 递增，容量为 0 时返回 0）
+    uint64_t store(const MessagePtr& message);
+    // sequence 非空时输出快照对应的最新序号：序号不大于它的写入都已体现在快照中
+    std::vector<MessagePtr> snapshot(uint64_t* sequence = nullptr) const;
+    std::vector<MessagePtr> snapshot(const std::string& eventType, uint64_t* sequence = nullptr) const;
+
+    void setCapacity(size_t capacity);
+    size_t capacity() const;
+    size_t size() const;
+    void clear();
+
+private:
+    struct Entry;
+    using KeyMap = std::unordered_map<std::string, Entry>;
+    using TopicMap = std::unordered_map<std::string, KeyMap>;
+    // 指向 map 节点中的键，unordered_map 节点地址稳定
+    using LruList = std::list<std::pair<const std::string*, const std::string*>>;
+
+    struct Entry {
+        MessagePtr message;
+        LruList::iterator lru;
+    };
+
+    void evictOldest();
+
+    TopicMap topics_;
+    LruList lru_;
+    size_t capacity_;
+    size_t size_;
+    uint64_t sequence_;
+    mutable std::mutex mutex_;
+};
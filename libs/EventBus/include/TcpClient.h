@@ -8,20 +8,25 @@
 #include <chrono>
 #include <queue>
 #include <future>
+#include <memory>
 #include "event_message.pb.h"
+#include "UringReactor.h"
 
 class TcpClient {
 public:
     using MessageHandler = std::function<void(const EventMessage&)>;
     using ConnectionStateHandler = std::function<void(bool)>;
+    using MessagePtr = std::shared_ptr<const EventMessage>;
     
     TcpClient(const std::string& host, int port, MessageHandler messageHandler,
-              ConnectionStateHandler connectionHandler = nullptr);
+              ConnectionStateHandler connectionHandler = nullptr,
+              IoBackend backend = IoBackend::Blocking);
     ~TcpClient();
     
     bool connect();
     void disconnect();
     void sendMessage(const EventMessage& message);
+    void sendMessage(MessagePtr message);
     bool sendMessageAsync(const EventMessage& message, std::chrono::milliseconds timeout);
     
     bool isConnected() const { return connected_.load(); }
@@ -33,6 +38,7 @@ private:
     bool connectSocket();
     void closeSocket();
     void notifyConnectionState(bool connected);
+    bool startReactor();
     
     std::string host_;
     int port_;
@@ -46,10 +52,16 @@ private:
     std::atomic<bool> shouldStop_;
     
     // Send queue
-    std::queue<EventMessage> sendQueue_;
+    std::queue<MessagePtr> sendQueue_;
     std::mutex sendMutex_;
     std::condition_variable sendCondition_;
     
+    // io_uring 后端：一个反应器线程代替收发两个线程，socket 交给反应器关闭
+    IoBackend backend_;
+    std::unique_ptr<UringReactor> reactor_;
+    UringReactor::ConnectionId connectionId_;
+    std::thread reactorThread_;
+    
     // Connection management
     mutable std::mutex connectionMutex_;
     static constexpr int CONNECT_TIMEOUT_MS = 3000;
@@ -6,8 +6,11 @@
 #include <functional>
 #include <atomic>
 #include <mutex>
-#include <unordered_set>
+#include <condition_variable>
+#include <unordered_map>
 #include "event_message.pb.h"
+#include "UringReactor.h"
+#include <sys/socket.h>
 
 class TcpServer {
 public:
@@ -15,9 +18,15 @@ public:
     using ClientConnectionHandler = std::function<void(const std::string&, bool)>;
 
     TcpServer(int port, MessageHandler messageHandler,
-              ClientConnectionHandler connectionHandler = nullptr);
+              ClientConnectionHandler connectionHandler = nullptr,
+              IoBackend backend = IoBackend::Blocking);
     ~TcpServer();
 
+    // 需在 start() 之前设置
+    // shards > 1 时使用 SO_REUSEPORT 建立多个监听 socket，由内核分配新连接，每个分片有自己的 accept 线程/反应器
+    void setListenerShards(int shards) { shardCount_ = shards > 0 ? shards : 1; }
+    void setBacklog(int backlog) { backlog_ = backlog > 0 ? backlog : SOMAXCONN; }
+
     void start();
     void stop();
     
@@ -25,27 +34,66 @@ public:
     size_t getConnectedClientsCount() const;
     std::vector<std::string> getConnectedClients() const;
 
+    // 向已接入的客户端直接发送消息（如新连接时推送保留状态）；按分片逐个查找，只持有所在分片的锁
+    bool sendToClient(const std::string& clientEndpoint, const EventMessage& message);
+
 private:
-    void acceptLoop();
-    void handleClient(int clientSocket, const std::string& clientEndpoint);
+    // 已接入的连接。阻塞后端下最后一个引用释放时才关闭 socket，
+    // sendToClient 在分片锁外发送时连接不会被关闭，fd 也不会被复用
+    struct ClientConnection {
+        ClientConnection(int fd, bool owned, UringReactor::ConnectionId id = 0)
+            : socket(fd), ownsSocket(owned), uringId(id) {}
+        ~ClientConnection();
+
+        int socket;
+        bool ownsSocket;         // io_uring 后端由反应器关闭
+        UringReactor::ConnectionId uringId;
+        std::mutex sendMutex;    // 同一连接上的帧不交错
+    };
+    using ConnectionPtr = std::shared_ptr<ClientConnection>;
+
+    // 每个监听分片拥有自己接入的连接，连接的增删和查找只锁所在分片，连接风暴时各分片互不竞争
+    struct ListenerShard {
+        int socket = -1;
+        std::thread acceptThread;
+        std::unique_ptr<UringReactor> reactor;
+        std::thread reactorThread;
+
+        std::mutex mutex;
+        std::unordered_map<std::string, ConnectionPtr> clients;  // endpoint -> 连接
+        std::unordered_map<UringReactor::ConnectionId, std::string> uringEndpoints;  // io_uring 连接 -> endpoint
+    };
+
+    int openListener(bool reusePort);
+    bool startReactors();
+    void acceptLoop(size_t shardIndex);
+    void handleClient(size_t shardIndex, ConnectionPtr connection, const std::string& clientEndpoint);
     void cleanupFinishedThreads();
     std::string getClientEndpoint(int socket) const;
+
+    // io_uring 后端回调，均在所属分片的反应器线程执行
+    void onUringAccept(size_t shardIndex, UringReactor::ConnectionId id);
+    void onUringFrame(size_t shardIndex, UringReactor::ConnectionId id, const char* data, size_t size);
+    void onUringClose(size_t shardIndex, UringReactor::ConnectionId id);
     
     int port_;
-    int serverSocket_;
+    int shardCount_;
+    int backlog_;
     MessageHandler messageHandler_;
     ClientConnectionHandler connectionHandler_;
     
-    std::thread acceptThread_;
+    std::vector<std::unique_ptr<ListenerShard>> shards_;
     std::vector<std::thread> clientThreads_;
     std::atomic<bool> running_;
     std::atomic<bool> shouldStop_;
-    
-    // Client management
-    mutable std::mutex clientsMutex_;
-    std::unordered_set<std::string> connectedClients_;
+
+
+    // io_uring 后端：每个分片一个反应器线程负责 accept、收发
+    IoBackend backend_;
+    bool useReactor_;
     
     // Thread cleanup
     std::thread cleanupThread_;
     std::mutex threadsMutex_;
+    std::condition_variable stopCondition_;
 };
@@ -0,0 +1,67 @@
+// ThreadPlacement.h
+#pragma once
+#include <string>
+#include <vector>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <sched.h>
+
+// 线程角色：不同角色可以绑定到不同的 CPU 核心并使用不同的调度策略
+//   IO       - TcpServer/TcpClient 的收发线程（count 为监听分片数的缺省值）
+//   Dispatch - EventBus 分发线程（count > 0 时启用分发线程池）
+//   App      - 应用自己的工作线程（count 为工作线程数的缺省值）
+//   Timer    - AppTemplate 事件循环线程（单线程，不支持 count）
+enum class ThreadRole {
+    IO = 0,
+    Dispatch,
+    App,
+    Timer
+};
+
+struct ThreadPolicy {
+    std::vector<int> cpus;  // 为空表示不绑定
+    bool spread = false;    // true: 同角色线程轮流绑定到单个核心；false: 绑定到整个核心集合
+    int schedPolicy = 0;    // SCHED_OTHER / SCHED_FIFO / SCHED_RR
+    int priority = 0;       // FIFO/RR 为实时优先级，OTHER 为 nice 值
+    int count = 0;          // 该角色的线程数量，0 表示使用默认值
+};
+
+class ThreadPlacement {
+public:
+    static ThreadPlacement& getInstance() {
+        static ThreadPlacement instance;
+        return instance;
+    }
+
+    // 超出 [0, CPU_SETSIZE) 的 CPU 编号会被丢弃并报错
+    void setPolicy(ThreadRole role, const ThreadPolicy& policy);
+    ThreadPolicy getPolicy(ThreadRole role) const;
+    int threadCount(ThreadRole role, int defaultCount) const;
+
+    // 为当前线程命名并应用角色的绑核和调度策略；
+    // 角色未配置的项恢复为进程默认值，不继承创建者线程的设置
+    void apply(ThreadRole role, const std::string& threadName = "");
+
+    static bool isValidCpu(int cpu);
+    // cpu 是否在进程启动时的亲和性掩码（sched_getaffinity）中
+    bool isCpuAllowed(int cpu) const;
+
+    static const char* roleName(ThreadRole role);
+    static bool parseRole(const std::string& name, ThreadRole& role);
+    static int parseSchedPolicy(const std::string& name);
+
+private:
+    ThreadPlacement();
+
+    static constexpr size_t ROLE_COUNT = 4;
+
+    std::array<ThreadPolicy, ROLE_COUNT> policies_;
+    std::array<std::atomic<unsigned>, ROLE_COUNT> spreadCursor_{};
+    mutable std::mutex mutex_;
+
+    // 首次使用时（主线程尚未被任何角色修改）记录的进程默认值
+    cpu_set_t defaultCpus_;
+    bool hasDefaultCpus_;
+    int defaultNice_;
+};
@@ -0,0 +1,51 @@
+// TopicTrie.h
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
+
+// 按 '.' 分段的主题前缀树，支持通配符：
+//   "*" 匹配恰好一段，如 "sensor.*" 匹配 "sensor.data"
+//   "#" 匹配其后任意多段（含零段），只能位于末尾，如 "sensor.#"
+// 非线程安全，由 EventBus 加锁使用
+class TopicTrie {
+public:
+    using Handler = std::function<void(const std::string&, const std::string&)>;
+    // 订阅（处理器 + 投递状态），由 EventBus 定义
+    struct Subscription;
+    using HandlerPtr = std::shared_ptr<Subscription>;
+
+    TopicTrie();
+
+    // 模式非法（'#' 不在末尾、空段）时返回 false
+    bool insert(const std::string& pattern, HandlerPtr handler);
+    // 返回匹配主题的所有处理器，按注册顺序
+    std::vector<HandlerPtr> match(const std::string& topic) const;
+
+    static bool isPattern(const std::string& topic);
+    static bool isValidPattern(const std::string& pattern);
+    static bool matches(const std::string& pattern, const std::string& topic);
+
+private:
+    struct Entry {
+        uint64_t sequence;
+        HandlerPtr handler;
+    };
+
+    struct Node {
+        std::unordered_map<std::string, std::unique_ptr<Node>> children;
+        std::unique_ptr<Node> singleWildcard;   // "*"
+        std::vector<Entry> handlers;            // 在此结束的精确/"*" 模式
+        std::vector<Entry> multiWildcard;       // 以 "#" 结束于此的模式
+    };
+
+    void collect(const Node& node, const std::vector<std::string>& segments, size_t depth,
+                 std::vector<Entry>& out) const;
+    static std::vector<std::string> split(const std::string& topic);
+
+    std::unique_ptr<Node> root_;
+    uint64_t nextSequence_;
+};
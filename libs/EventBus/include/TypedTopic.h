@@ -0,0 +1,102 @@
+// TypedTopic.h
+#pragma once
+#include <string>
+#include <iostream>
+#include <tuple>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include "EventBus.h"
+
+// 编译期类型化主题：主题名与负载类型绑定，订阅/发布/解码在编译期确定
+//
+//   inline constexpr char SENSOR_DATA[] = "sensor.data";
+//   using SensorDataTopic = Topic<SENSOR_DATA, SensorData>;
+//
+//   subscribe<SensorDataTopic>(bus, [](const SensorData& d) { ... });
+//   publish<SensorDataTopic>(bus, data, key);
+//
+// C++17 不支持字符串字面量作为模板参数，主题名使用具有静态存储期的字符数组。
+// 这里只提供机制，具体主题名由应用定义（本仓库的应用共用 apps/VirtualSensor/include/Topics.h）。
+
+template <const char* Name, typename Payload>
+struct Topic {
+    using PayloadType = Payload;
+    static constexpr const char* name = Name;
+};
+
+// 负载编解码扩展点：默认使用 protobuf，非 protobuf 负载类型特化此模板
+// encode(payload, out) 覆盖 out 的内容，out 的容量可以跨调用复用
+template <typename Payload>
+struct PayloadCodec {
+    static bool decode(const std::string& data, Payload& payload) {
+        return payload.ParseFromString(data);
+    }
+    static std::string encode(const Payload& payload) {
+        return payload.SerializeAsString();
+    }
+    static void encode(const Payload& payload, std::string& out) {
+        payload.SerializeToString(&out);
+    }
+};
+
+template <typename T>
+struct IsTopic : std::false_type {};
+
+template <const char* Name, typename Payload>
+struct IsTopic<Topic<Name, Payload>> : std::true_type {};
+
+// 同一主题的所有处理器保存在 tuple 中，消息只解码一次，处理器以内联方式依次调用
+template <typename TopicT, typename... Handlers>
+class TopicDispatcher {
+public:
+    static_assert(IsTopic<TopicT>::value, "TopicT must be a Topic<Name, Payload>");
+    using Payload = typename TopicT::PayloadType;
+    static_assert((std::is_invocable_v<Handlers&, const Payload&> && ...),
+                  "Topic handler must be callable with the topic's payload type");
+
+    explicit TopicDispatcher(Handlers... handlers) : handlers_(std::move(handlers)...) {}
+
+    void dispatch(const Payload& payload) {
+        std::apply([&payload](auto&... handler) { (handler(payload), ...); }, handlers_);
+    }
+
+    bool dispatchBytes(const std::string& data) {
+        Payload payload;
+        if (!PayloadCodec<Payload>::decode(data, payload)) {
+            return false;
+        }
+        dispatch(payload);
+        return true;
+    }
+
+private:
+    std::tuple<Handlers...> handlers_;
+};
+
+template <typename TopicT>
+bool decode(const std::string& data, typename TopicT::PayloadType& payload) {
+    static_assert(IsTopic<TopicT>::value, "TopicT must be a Topic<Name, Payload>");
+    return PayloadCodec<typename TopicT::PayloadType>::decode(data, payload);
+}
+
+// 序列化到按线程复用的缓冲区；broadcast 仍会为每条消息构造一个共享的 EventMessage（含负载副本）
+template <typename TopicT>
+void publish(EventBus& bus, const typename TopicT::PayloadType& payload, const std::string& key = "") {
+    static_assert(IsTopic<TopicT>::value, "TopicT must be a Topic<Name, Payload>");
+    thread_local std::string buffer;
+    PayloadCodec<typename TopicT::PayloadType>::encode(payload, buffer);
+    bus.broadcast(TopicT::name, buffer, key);
+}
+
+// 总线边界只做一次类型擦除：每个主题注册一个分发器
+template <typename TopicT, typename... Handlers>
+void subscribe(EventBus& bus, Handlers&&... handlers) {
+    auto dispatcher = std::make_shared<TopicDispatcher<TopicT, std::decay_t<Handlers>...>>(
+        std::forward<Handlers>(handlers)...);
+    bus.registerHandler(TopicT::name, [dispatcher](const std::string& eventType, const std::string& data) {
+        if (!dispatcher->dispatchBytes(data)) {
+            std::cerr << "Failed to decode " << eventType << " payload" << std::endl;
+        }
+    });
+}
@@ -0,0 +1,158 @@
+// UringReactor.h
+#pragma once
+#include <linux/io_uring.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "event_message.pb.h"
+
+// TcpServer / TcpClient 的 I/O 后端
+enum class IoBackend {
+    Blocking,  // 每连接阻塞线程（默认，兼容所有内核）
+    IoUring    // 单线程 io_uring 反应器，内核不支持时回退到 Blocking
+};
+
+// 基于 io_uring 的单线程反应器（直接使用系统调用，不依赖 liburing）
+//   - 监听 socket 使用 multishot accept
+//   - 连接使用 multishot recv + 注册的缓冲环（provided buffer ring），收包不需要每次重新提交
+//   - 发送跨线程入队，反应器按连接合并成一次 send，每轮循环一次 io_uring_enter 批量提交
+// 帧格式与阻塞路径相同：4 字节网络序长度 + protobuf 负载
+// addConnection()/send()/closeConnection()/stop() 线程安全；listen() 需在 run() 之前调用
+// 关闭连接时先回调 closeHandler，再关闭 fd，stop() 时剩余连接直接关闭不回调
+// 连接以 ConnectionId（代数 + fd）标识，fd 被复用后针对旧连接的发送/关闭和完成事件会被丢弃
+// 回调在反应器线程执行，应尽快返回（EventBus 在 io_uring 模式下默认把处理器交给分发线程）
+class UringReactor {
+public:
+    using ConnectionId = uint64_t;  // 高 32 位为代数，低 32 位为 fd
+    using FrameHandler = std::function<void(ConnectionId id, const char* data, size_t size)>;
+    using AcceptHandler = std::function<void(ConnectionId id)>;
+    using CloseHandler = std::function<void(ConnectionId id)>;
+
+    UringReactor(FrameHandler frameHandler, CloseHandler closeHandler = nullptr);
+    ~UringReactor();
+
+    UringReactor(const UringReactor&) = delete;
+    UringReactor& operator=(const UringReactor&) = delete;
+
+    // 创建 ring、注册缓冲环并用 socketpair 探测 multishot recv（内核 6.0+）；
+    // 失败时返回 false，调用方应回退到阻塞路径
+    bool init();
+    static bool isSupported();
+    static bool parseBackend(const std::string& name, IoBackend& backend);
+    static const char* backendName(IoBackend backend);
+
+    void listen(int listenFd, AcceptHandler acceptHandler);
+    // 连接交给反应器后由其负责关闭
+    ConnectionId addConnection(int fd);
+
+    // 入队一个完整帧（已包含长度头）；连接已关闭时帧被丢弃
+    bool send(ConnectionId id, std::string frame);
+    void closeConnection(ConnectionId id);
+
+    static int fdOf(ConnectionId id) { return static_cast<int>(static_cast<uint32_t>(id)); }
+
+    void run();
+    void stop();
+
+    // 序列化为带长度头的帧
+    static std::string encodeFrame(const EventMessage& message);
+
+private:
+    static constexpr unsigned RING_ENTRIES = 256;
+    static constexpr unsigned BUFFER_COUNT = 256;       // 必须是 2 的幂
+    static constexpr unsigned BUFFER_SIZE = 16 * 1024;
+    static constexpr uint16_t BUFFER_GROUP = 0;
+    static constexpr uint32_t MAX_FRAME_SIZE = 10 * 1024 * 1024;
+
+    enum OpType : uint64_t { OP_ACCEPT = 1, OP_RECV, OP_SEND, OP_WAKE, OP_CANCEL, OP_PROBE };
+    // user_data = 代数(32) | fd(24) | 操作类型(8)
+    static constexpr int MAX_FD = (1 << 24) - 1;
+
+    struct Connection {
+        uint32_t generation = 0;
+        std::string input;          // 未组成完整帧的数据
+        std::string outgoing;       // 等待发送
+        std::string inflight;       // 已提交给内核
+        size_t inflightOffset = 0;
+        int pendingOps = 0;
+        bool recvArmed = false;
+        bool closing = false;
+    };
+
+    io_uring_sqe* getSqe();
+    void submitAndWait(unsigned waitNr);
+    void processCompletions();
+    void handleCompletion(uint64_t userData, int32_t res, uint32_t flags);
+
+    bool probeMultishot();
+    bool waitCompletion(int32_t& res, uint32_t& flags);
+    void registerConnection(int fd, uint32_t generation);
+    Connection* findConnection(int fd, uint32_t generation);
+    uint32_t nextGeneration();
+    void armAccept();
+    void armRecv(int fd);
+    void armWake();
+    void armSend(int fd, Connection& connection);
+    void recycleBuffer(uint16_t bufferId);
+
+    void onRecv(int fd, int32_t res, uint32_t flags);
+    void onSend(int fd, int32_t res);
+    void drainPending();
+    void beginClose(int fd, Connection& connection);
+    void finishIfIdle(int fd);
+    void beginShutdown();
+    void teardown();
+
+    FrameHandler frameHandler_;
+    CloseHandler closeHandler_;
+    AcceptHandler acceptHandler_;
+
+    // ring
+    int ringFd_;
+    void* sqRing_;
+    void* cqRing_;
+    size_t sqRingSize_;
+    size_t cqRingSize_;
+    io_uring_sqe* sqes_;
+    unsigned sqEntries_;
+    unsigned* sqHead_;
+    unsigned* sqTail_;
+    unsigned sqMask_;
+    unsigned* cqHead_;
+    unsigned* cqTail_;
+    unsigned cqMask_;
+    io_uring_cqe* cqes_;
+    unsigned localTail_;
+    unsigned toSubmit_;
+
+    // 缓冲环；按 io_uring_buf 数组访问，tail 与 bufs[0].resv 重叠
+    // （C++ 下 io_uring_buf_ring::bufs 的偏移与内核布局不一致，不能直接使用）
+    io_uring_buf* bufferRing_;
+    size_t bufferRingSize_;
+    std::vector<char> bufferPool_;
+    unsigned bufferMask_;
+    uint16_t bufferTail_;
+
+    int listenFd_;
+    bool acceptArmed_;
+    int wakeFd_;
+    uint64_t wakeValue_;
+    bool wakeArmed_;
+    int inflightOps_;
+
+    std::unordered_map<int, Connection> connections_;
+
+    // 跨线程提交
+    std::mutex pendingMutex_;
+    std::unordered_map<ConnectionId, std::string> pendingSends_;
+    std::vector<ConnectionId> pendingAdds_;
+    std::vector<ConnectionId> pendingCloses_;
+    std::atomic<uint32_t> generation_;
+    std::atomic<bool> wakePending_;
+    std::atomic<bool> stopRequested_;
+    bool shuttingDown_;
+};
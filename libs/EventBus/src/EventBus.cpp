@@ -5,29 +5,71 @@
 #include <iostream>
 #include <chrono>
 #include <thread>
+#include <cassert>
+#include <algorithm>
 
-EventBus::EventBus(int port) : port_(port), running_(false) {}
+EventBus::EventBus(int port)
+    : port_(port), ioBackend_(IoBackend::Blocking), listenShards_(1), listenBacklog_(SOMAXCONN),
+      retained_(1024), running_(false), holding_(false), holdOffset_(0) {}
 
 EventBus::~EventBus() {
     stop();
 }
 
 void EventBus::postEvent(const std::string& eventType, const std::string& data) {
+    if (journal_) {
+        EventMessage message;
+        message.set_event_type(eventType);
+        message.set_data(data);
+        message.set_timestamp(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        message.set_source("local");
+        journalEvent(message);
+    }
     distributeEvent(eventType, data);
 }
 
 void EventBus::registerHandler(const std::string& eventType, EventHandler handler) {
-    std::lock_guard<std::mutex> lock(handlersMutex_);
-    handlers_[eventType].push_back(handler);
+    // draining 初始为 true：插入前缀树后到达的实时事件排在保留状态回放之后
+    auto subscription = std::make_shared<TopicTrie::Subscription>(std::move(handler));
+    {
+        std::lock_guard<std::mutex> lock(handlersMutex_);
+        if (!handlerTrie_.insert(eventType, subscription)) {
+            std::cerr << "Invalid event pattern: " << eventType << std::endl;
+            return;
+        }
+        matchCache_.clear();
+    }
+
+    // 晚注册的处理器立即获得保留状态。快照在插入之后获取，
+    // 序号不大于 replayedThrough 的广播要么在快照中，要么已被更新的状态覆盖
+    bool isPattern = TopicTrie::isPattern(eventType);
+    uint64_t sequence = 0;
+    auto snapshot = isPattern ? retained_.snapshot(&sequence) : retained_.snapshot(eventType, &sequence);
+    {
+        std::lock_guard<std::mutex> lock(subscription->mutex);
+        subscription->replayedThrough = sequence;
+    }
+    for (const auto& message : snapshot) {
+        if (isPattern && !TopicTrie::matches(eventType, message->event_type())) {
+            continue;
+        }
+        invoke(*subscription, message->event_type(), message->data());
+    }
+    drain(*subscription);
 }
 
-void EventBus::broadcast(const std::string& eventType, const std::string& data) {
-    EventMessage message;
-    message.set_event_type(eventType);
-    message.set_data(data);
-    message.set_timestamp(std::chrono::duration_cast<std::chrono::milliseconds>(
+void EventBus::broadcast(const std::string& eventType, const std::string& data, const std::string& key) {
+    // 消息只构造一次，由保留缓存和所有客户端发送队列共享
+    auto message = std::make_shared<EventMessage>();
+    message->set_event_type(eventType);
+    message->set_data(data);
+    message->set_key(key);
+    message->set_timestamp(std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::system_clock::now().time_since_epoch()).count());
-    message.set_source("local");
+    message->set_source("local");
+    journalEvent(*message);
+    uint64_t sequence = retained_.store(message);
 
     std::lock_guard<std::mutex> lock(clientsMutex_);
     
@@ -50,16 +92,24 @@ void EventBus::broadcast(const std::string& eventType, const std::string& data)
     }
 
     // 同时本地分发
-    distributeEvent(eventType, data);
+    distributeEvent(eventType, data, sequence);
 }
 
 void EventBus::connectToPeer(const std::string& host, int port) {
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    
-    // Check if already connected to this peer
     std::string endpoint = host + ":" + std::to_string(port);
-    for (const auto& client : clients_) {
-        if (client->getEndpoint() == endpoint && client->isConnected()) {
+    auto alreadyConnected = [this, &endpoint]() {
+        for (const auto& client : clients_) {
+            if (client->getEndpoint() == endpoint && client->isConnected()) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Check if already connected to this peer
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex_);
+        if (alreadyConnected()) {
             std::cout << "Already connected to " << endpoint << std::endl;
             return;
         }
@@ -70,9 +120,10 @@ void EventBus::connectToPeer(const std::string& host, int port) {
         [host, port](bool connected) {
             std::cout << "Connection to " << host << ":" << port 
                       << (connected ? " established" : " lost") << std::endl;
-        });
+        },
+        ioBackend_);
     
-    // Try to connect with retry
+    // 重试期间不持有 clientsMutex_，不阻塞 broadcast
     bool connected = false;
     for (int attempts = 0; attempts < 3 && running_; ++attempts) {
         if (client->connect()) {
@@ -84,12 +135,21 @@ void EventBus::connectToPeer(const std::string& host, int port) {
         std::this_thread::sleep_for(std::chrono::milliseconds(1000));
     }
     
-    if (connected) {
-        clients_.push_back(std::move(client));
-        std::cout << "Successfully connected to " << endpoint << std::endl;
-    } else {
+    if (!connected) {
         std::cerr << "Failed to connect to " << endpoint << " after 3 attempts" << std::endl;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    if (alreadyConnected()) {
+        std::cout << "Already connected to " << endpoint << std::endl;
+        return;
     }
+    // 先加入 clients_ 再持锁发送保留快照：broadcast 先写保留缓存再取 clientsMutex_，
+    // 因此并发的广播要么已在快照中，要么在快照之后发出，不会丢失或被旧状态覆盖
+    clients_.push_back(std::move(client));
+    sendRetained(*clients_.back());
+    std::cout << "Successfully connected to " << endpoint << std::endl;
 }
 
 void EventBus::start() {
@@ -98,8 +158,24 @@ void EventBus::start() {
     }
     
     running_.store(true);
+
+    // io_uring 模式下一个反应器线程负责所有连接，处理器默认交给分发线程，慢处理器不会阻塞收发
+    int defaultDispatchThreads = ioBackend_ == IoBackend::IoUring ? 1 : 0;
+    int dispatchThreads = ThreadPlacement::getInstance().threadCount(ThreadRole::Dispatch, defaultDispatchThreads);
+    if (dispatchThreads > 0) {
+        startDispatchers(dispatchThreads);
+    }
+
     server_ = std::make_unique<TcpServer>(port_, 
-        [this](const EventMessage& msg) { handleMessage(msg); });
+        [this](const EventMessage& msg) { handleMessage(msg); },
+        [this](const std::string& endpoint, bool connected) {
+            if (connected) {
+                sendRetained(endpoint);
+            }
+        },
+        ioBackend_);
+    server_->setListenerShards(listenShards_);
+    server_->setBacklog(listenBacklog_);
     server_->start();
     std::cout << "EventBus started on port " << port_ << std::endl;
 }
@@ -123,25 +199,280 @@ void EventBus::stop() {
         }
     }
     clients_.clear();
+
+    stopDispatchers();
+
+    if (journal_) {
+        journal_->flush();
+    }
     
     std::cout << "EventBus stopped" << std::endl;
 }
 
+void EventBus::setRetainedCapacity(size_t capacity) {
+    retained_.setCapacity(capacity);
+}
+
+void EventBus::sendRetained(TcpClient& client) {
+    for (const auto& message : retained_.snapshot()) {
+        client.sendMessage(message);
+    }
+}
+
+void EventBus::sendRetained(const std::string& clientEndpoint) {
+    auto snapshot = retained_.snapshot();
+    for (const auto& message : snapshot) {
+        if (!server_ || !server_->sendToClient(clientEndpoint, *message)) {
+            break;
+        }
+    }
+    if (!snapshot.empty()) {
+        std::cout << "Sent " << snapshot.size() << " retained event(s) to " << clientEndpoint << std::endl;
+    }
+}
+
+bool EventBus::enableJournal(const EventJournal::Options& options) {
+    // 启动后接收线程会并发读取 journal_，此时替换会产生数据竞争
+    assert(!running_.load() && !journal_);
+    if (running_.load() || journal_) {
+        std::cerr << "Event journal must be enabled once, before start()" << std::endl;
+        return false;
+    }
+
+    auto journal = std::make_unique<EventJournal>(options);
+    if (!journal->open()) {
+        std::cerr << "Failed to open event journal in " << options.directory << std::endl;
+        return false;
+    }
+    journal_ = std::move(journal);
+    return true;
+}
+
+void EventBus::flushJournal() {
+    if (journal_) {
+        journal_->flush();
+    }
+}
+
+size_t EventBus::replayJournal(uint64_t fromOffset, const EventJournal::ReplayHandler& handler) {
+    if (!journal_) {
+        return 0;
+    }
+    if (handler) {
+        return journal_->replayFromOffset(fromOffset, handler);
+    }
+    // 回放期间新追加的事件已经实时分发过，不再重复
+    uint64_t endOffset = replayEndOffset();
+    return journal_->replayFromOffset(fromOffset, [this, endOffset](uint64_t offset, const EventMessage& msg) {
+        if (offset >= endOffset) {
+            return false;
+        }
+        distributeEvent(msg.event_type(), msg.data());
+        return running_.load() && offset + 1 < endOffset;
+    });
+}
+
+size_t EventBus::replayJournalSince(int64_t timestampMs, const EventJournal::ReplayHandler& handler) {
+    if (!journal_) {
+        return 0;
+    }
+    if (handler) {
+        return journal_->replayFromTime(timestampMs, handler);
+    }
+    // 回放期间新追加的事件已经实时分发过，不再重复
+    uint64_t endOffset = replayEndOffset();
+    return journal_->replayFromTime(timestampMs, [this, endOffset](uint64_t offset, const EventMessage& msg) {
+        if (offset >= endOffset) {
+            return false;
+        }
+        distributeEvent(msg.event_type(), msg.data());
+        return running_.load() && offset + 1 < endOffset;
+    });
+}
+
+uint64_t EventBus::replayEndOffset() const {
+    // 暂存期间只回放 hold 之前的日志：之后追加的是本进程 initialize() 中发布的事件，已经实时分发过
+    return holding_.load() ? std::min(holdOffset_, journal_->nextOffset()) : journal_->nextOffset();
+}
+
+void EventBus::holdRemoteEvents() {
+    assert(!running_.load());
+    std::lock_guard<std::mutex> lock(heldMutex_);
+    holdOffset_ = journal_ ? journal_->nextOffset() : 0;
+    holding_.store(true);
+}
+
+void EventBus::releaseRemoteEvents() {
+    // 分批取出处理，处理期间到达的事件排在后面；暂存队列为空时才恢复直接投递，保证顺序
+    std::deque<EventMessage> batch;
+    size_t released = 0;
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(heldMutex_);
+            if (held_.empty()) {
+                holding_.store(false);
+                break;
+            }
+            batch.swap(held_);
+        }
+        for (const auto& message : batch) {
+            acceptMessage(message);
+        }
+        released += batch.size();
+        batch.clear();
+    }
+    if (released > 0) {
+        std::cout << "EventBus released " << released << " event(s) held during replay" << std::endl;
+    }
+}
+
 void EventBus::handleMessage(const EventMessage& message) {
-    distributeEvent(message.event_type(), message.data());
-}
-
-void EventBus::distributeEvent(const std::string& eventType, const std::string& data) {
-    std::lock_guard<std::mutex> lock(handlersMutex_);
-    auto it = handlers_.find(eventType);
-    if (it != handlers_.end()) {
-        for (auto& handler : it->second) {
-            try {
-                handler(eventType, data);
-            } catch (const std::exception& e) {
-                std::cerr << "Error in event handler for " << eventType 
-                          << ": " << e.what() << std::endl;
+    if (holding_.load()) {
+        std::lock_guard<std::mutex> lock(heldMutex_);
+        if (holding_.load()) {
+            held_.push_back(message);
+            return;
+        }
+    }
+    acceptMessage(message);
+}
+
+void EventBus::acceptMessage(const EventMessage& message) {
+    journalEvent(message);
+
+    if (dispatchQueues_.empty()) {
+        distributeEvent(message.event_type(), message.data());
+        return;
+    }
+
+    // 交给分发线程，I/O 线程不执行处理器
+    std::hash<std::string> hasher;
+    size_t shard = (hasher(message.event_type()) * 31 + hasher(message.key())) % dispatchQueues_.size();
+    auto& queue = *dispatchQueues_[shard];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.messages.push_back(std::make_shared<const EventMessage>(message));
+    }
+    queue.condition.notify_one();
+}
+
+void EventBus::startDispatchers(int count) {
+    for (int i = 0; i < count; ++i) {
+        dispatchQueues_.push_back(std::make_unique<DispatchQueue>());
+    }
+    for (int i = 0; i < count; ++i) {
+        dispatchThreads_.emplace_back(&EventBus::dispatchLoop, this, i);
+    }
+    std::cout << "EventBus dispatching on " << count << " thread(s)" << std::endl;
+}
+
+void EventBus::stopDispatchers() {
+    for (auto& queue : dispatchQueues_) {
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        queue->condition.notify_all();
+    }
+    for (auto& thread : dispatchThreads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    dispatchThreads_.clear();
+    dispatchQueues_.clear();
+}
+
+void EventBus::dispatchLoop(size_t index) {
+    ThreadPlacement::getInstance().apply(ThreadRole::Dispatch, "dispatch-" + std::to_string(index));
+    auto& queue = *dispatchQueues_[index];
+
+    while (true) {
+        std::shared_ptr<const EventMessage> message;
+        {
+            std::unique_lock<std::mutex> lock(queue.mutex);
+            queue.condition.wait(lock, [this, &queue]() {
+                return !queue.messages.empty() || !running_.load();
+            });
+            if (queue.messages.empty()) {
+                break;
             }
+            message = std::move(queue.messages.front());
+            queue.messages.pop_front();
         }
+        distributeEvent(message->event_type(), message->data());
+    }
+}
+
+void EventBus::journalEvent(const EventMessage& message) {
+    if (journal_) {
+        journal_->append(message);
     }
-}
\ No newline at end of file
+}
+
+void EventBus::distributeEvent(const std::string& eventType, const std::string& data, uint64_t retainedSequence) {
+    std::shared_ptr<const HandlerList> handlers;
+    {
+        std::lock_guard<std::mutex> lock(handlersMutex_);
+        auto it = matchCache_.find(eventType);
+        if (it != matchCache_.end()) {
+            handlers = it->second;
+        } else {
+            if (matchCache_.size() >= MATCH_CACHE_LIMIT) {
+                matchCache_.clear();
+            }
+            handlers = std::make_shared<const HandlerList>(handlerTrie_.match(eventType));
+            matchCache_.emplace(eventType, handlers);
+        }
+    }
+
+    // 在锁外调用，处理器内可以安全地注册新处理器
+    for (const auto& subscription : *handlers) {
+        deliver(*subscription, eventType, data, retainedSequence);
+    }
+}
+
+void EventBus::deliver(TopicTrie::Subscription& subscription, const std::string& eventType,
+                       const std::string& data, uint64_t retainedSequence) {
+    {
+        std::lock_guard<std::mutex> lock(subscription.mutex);
+        if (subscription.draining) {
+            // 其他线程（或处理器自身的调用栈）正在投递，排队保持串行
+            subscription.pending.push_back({eventType, data, retainedSequence});
+            return;
+        }
+        if (retainedSequence != 0 && retainedSequence <= subscription.replayedThrough) {
+            return;
+        }
+        subscription.draining = true;
+    }
+
+    // 无竞争时直接调用，不复制事件
+    invoke(subscription, eventType, data);
+    drain(subscription);
+}
+
+void EventBus::drain(TopicTrie::Subscription& subscription) {
+    while (true) {
+        TopicTrie::Subscription::Pending next;
+        {
+            std::lock_guard<std::mutex> lock(subscription.mutex);
+            if (subscription.pending.empty()) {
+                subscription.draining = false;
+                return;
+            }
+            next = std::move(subscription.pending.front());
+            subscription.pending.pop_front();
+            if (next.retainedSequence != 0 && next.retainedSequence <= subscription.replayedThrough) {
+                continue;
+            }
+        }
+        invoke(subscription, next.eventType, next.data);
+    }
+}
+
+void EventBus::invoke(TopicTrie::Subscription& subscription, const std::string& eventType, const std::string& data) {
+    try {
+        subscription.handler(eventType, data);
+    } catch (const std::exception& e) {
+        std::cerr << "Error in event handler for " << eventType 
+                  << ": " << e.what() << std::endl;
+    }
+}
@@ -0,0 +1,458 @@
+// EventJournal.cpp
+#include "EventJournal.h"
+#include "Crc32.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace {
+    constexpr uint32_t INDEX_MAGIC = 0x58494A45; // "EJIX"
+    constexpr const char* SEGMENT_EXT = ".seg";
+    constexpr const char* INDEX_EXT = ".idx";
+
+    int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+}
+
+EventJournal::Segment::~Segment() {
+    if (data) {
+        munmap(data, size);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+EventJournal::EventJournal(const Options& options)
+    : options_(options), lastIndexedPos_(0) {
+    // 索引中的段内位置为 32 位
+    options_.segmentSize = std::min<size_t>(options_.segmentSize, std::numeric_limits<uint32_t>::max());
+    options_.maxSegments = std::max<size_t>(options_.maxSegments, 1);
+}
+
+EventJournal::~EventJournal() {
+    close();
+}
+
+bool EventJournal::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!segments_.empty()) {
+        return true;
+    }
+
+    if (mkdir(options_.directory.c_str(), 0755) < 0 && errno != EEXIST) {
+        std::cerr << "[EventJournal] Failed to create directory " << options_.directory
+                  << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 查找已有段文件
+    std::vector<uint64_t> baseOffsets;
+    if (DIR* dir = opendir(options_.directory.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            size_t extPos = name.rfind(SEGMENT_EXT);
+            if (extPos == std::string::npos || extPos + strlen(SEGMENT_EXT) != name.size()) {
+                continue;
+            }
+            char* end = nullptr;
+            uint64_t base = std::strtoull(name.c_str(), &end, 10);
+            if (end == name.c_str() + extPos) {
+                baseOffsets.push_back(base);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(baseOffsets.begin(), baseOffsets.end());
+
+    for (size_t i = 0; i < baseOffsets.size(); ++i) {
+        auto segment = openSegment(segmentPath(baseOffsets[i], SEGMENT_EXT), baseOffsets[i]);
+        if (!segment) {
+            continue;
+        }
+        bool isLast = (i + 1 == baseOffsets.size());
+        if (isLast || !loadIndex(*segment)) {
+            recoverSegment(*segment);
+        }
+        segment->sealed = !isLast;
+        segments_.push_back(segment);
+    }
+
+    if (segments_.empty()) {
+        auto segment = createSegment(0);
+        if (!segment) {
+            return false;
+        }
+        segments_.push_back(segment);
+    }
+
+    const auto& active = segments_.back();
+    lastIndexedPos_ = active->index.empty() ? 0 : active->index.back().position;
+    enforceRetention();
+
+    std::cout << "[EventJournal] Opened " << options_.directory << " with " << segments_.size()
+              << " segment(s), next offset " << active->nextOffset << std::endl;
+    return true;
+}
+
+void EventJournal::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!segments_.empty()) {
+        const auto& active = segments_.back();
+        msync(active->data, active->size, MS_SYNC);
+    }
+    segments_.clear();
+}
+
+bool EventJournal::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !segments_.empty();
+}
+
+uint64_t EventJournal::append(const EventMessage& message) {
+    const size_t payloadSize = message.ByteSizeLong();
+    const size_t frameSize = sizeof(FrameHeader) + payloadSize;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (segments_.empty()) {
+        return UINT64_MAX;
+    }
+    if (frameSize > options_.segmentSize) {
+        std::cerr << "[EventJournal] Event too large for segment: " << payloadSize << std::endl;
+        return UINT64_MAX;
+    }
+
+    SegmentPtr active = segments_.back();
+    if (active->writePos + frameSize > active->size) {
+        sealSegment(*active);
+        active = createSegment(active->nextOffset);
+        if (!active) {
+            return UINT64_MAX;
+        }
+        segments_.push_back(active);
+        lastIndexedPos_ = 0;
+        enforceRetention();
+    }
+
+    // 负载直接序列化进映射区，不经过中间缓冲
+    char* frame = active->data + active->writePos;
+    char* payload = frame + sizeof(FrameHeader);
+    message.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(payload));
+
+    FrameHeader header;
+    header.length = static_cast<uint32_t>(payloadSize);
+    header.checksum = crc32(0, payload, payloadSize);
+    header.offset = active->nextOffset;
+    // 保证追加时间单调，便于按时间二分
+    header.appendTime = std::max(nowMs(), active->lastTime);
+    std::memcpy(frame, &header, sizeof(header));
+
+    if (active->index.empty() || active->writePos - lastIndexedPos_ >= options_.indexIntervalBytes) {
+        active->index.push_back({header.offset, header.appendTime,
+                                 static_cast<uint32_t>(active->writePos)});
+        lastIndexedPos_ = active->writePos;
+    }
+    if (active->writePos == 0) {
+        active->firstTime = header.appendTime;
+    }
+    active->lastTime = header.appendTime;
+    active->writePos += frameSize;
+    active->nextOffset++;
+
+    return header.offset;
+}
+
+void EventJournal::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!segments_.empty()) {
+        // 同步写回：返回时已追加的帧都已落盘
+        const auto& active = segments_.back();
+        if (msync(active->data, active->size, MS_SYNC) < 0) {
+            std::cerr << "[EventJournal] msync failed for " << active->path << ": " << strerror(errno) << std::endl;
+        }
+    }
+}
+
+size_t EventJournal::replayFromOffset(uint64_t offset, const ReplayHandler& handler) const {
+    std::vector<SegmentPtr> segments;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        segments = segments_;
+    }
+    return replaySegments(segments, offset, std::numeric_limits<int64_t>::min(), handler);
+}
+
+size_t EventJournal::replayFromTime(int64_t timestampMs, const ReplayHandler& handler) const {
+    std::vector<SegmentPtr> segments;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        segments = segments_;
+    }
+    return replaySegments(segments, 0, timestampMs, handler);
+}
+
+size_t EventJournal::replaySegments(const std::vector<SegmentPtr>& segments, uint64_t offset,
+                                    int64_t timestampMs, const ReplayHandler& handler) const {
+    const bool byTime = timestampMs != std::numeric_limits<int64_t>::min();
+    size_t replayed = 0;
+    EventMessage message;
+
+    for (const auto& segment : segments) {
+        size_t end;
+        std::vector<IndexEntry> index;
+        {
+            // 活动段在追加中，只读取快照时已提交的部分
+            std::lock_guard<std::mutex> lock(mutex_);
+            end = segment->writePos;
+            if (segment->nextOffset <= offset || segment->lastTime < timestampMs || end == 0) {
+                continue;
+            }
+            index = segment->index;
+        }
+
+        // 稀疏索引定位起始位置：最后一个不晚于目标的索引点
+        auto it = std::partition_point(index.begin(), index.end(), [&](const IndexEntry& entry) {
+            return byTime ? entry.appendTime < timestampMs : entry.offset <= offset;
+        });
+        size_t pos = (it == index.begin()) ? 0 : std::prev(it)->position;
+
+        while (pos + sizeof(FrameHeader) <= end) {
+            FrameHeader header;
+            std::memcpy(&header, segment->data + pos, sizeof(header));
+            if (header.length == 0) {
+                break;
+            }
+            const char* payload = segment->data + pos + sizeof(FrameHeader);
+            pos += sizeof(FrameHeader) + header.length;
+
+            if (header.offset < offset || header.appendTime < timestampMs) {
+                continue;
+            }
+            if (!message.ParseFromArray(payload, header.length)) {
+                std::cerr << "[EventJournal] Corrupt frame at offset " << header.offset << std::endl;
+                continue;
+            }
+            ++replayed;
+            if (!handler(header.offset, message)) {
+                return replayed;
+            }
+        }
+    }
+    return replayed;
+}
+
+void EventJournal::truncateBefore(uint64_t offset) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (segments_.size() > 1 && segments_.front()->nextOffset <= offset) {
+        const auto& oldest = segments_.front();
+        unlink(oldest->path.c_str());
+        unlink(segmentPath(oldest->baseOffset, INDEX_EXT).c_str());
+        segments_.erase(segments_.begin());
+    }
+}
+
+uint64_t EventJournal::firstOffset() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return segments_.empty() ? 0 : segments_.front()->baseOffset;
+}
+
+uint64_t EventJournal::nextOffset() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return segments_.empty() ? 0 : segments_.back()->nextOffset;
+}
+
+EventJournal::SegmentPtr EventJournal::createSegment(uint64_t baseOffset) {
+    std::string path = segmentPath(baseOffset, SEGMENT_EXT);
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "[EventJournal] Failed to create segment " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    if (ftruncate(fd, options_.segmentSize) < 0) {
+        std::cerr << "[EventJournal] Failed to size segment " << path << ": " << strerror(errno) << std::endl;
+        ::close(fd);
+        return nullptr;
+    }
+    ::close(fd);
+    // 新段的目录项落盘，flush() 之后掉电也能找到它
+    syncPath(options_.directory);
+    return openSegment(path, baseOffset);
+}
+
+EventJournal::SegmentPtr EventJournal::openSegment(const std::string& path, uint64_t baseOffset) {
+    auto segment = std::make_shared<Segment>();
+    segment->path = path;
+    segment->baseOffset = baseOffset;
+    segment->nextOffset = baseOffset;
+
+    segment->fd = ::open(path.c_str(), O_RDWR);
+    if (segment->fd < 0) {
+        std::cerr << "[EventJournal] Failed to open segment " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(segment->fd, &st) < 0 || st.st_size == 0) {
+        std::cerr << "[EventJournal] Invalid segment " << path << std::endl;
+        return nullptr;
+    }
+    segment->size = static_cast<size_t>(st.st_size);
+
+    void* mapped = mmap(nullptr, segment->size, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "[EventJournal] Failed to map segment " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    segment->data = static_cast<char*>(mapped);
+    madvise(segment->data, segment->size, MADV_SEQUENTIAL);
+    return segment;
+}
+
+void EventJournal::recoverSegment(Segment& segment) {
+    // 顺序扫描校验帧，遇到空帧、越界、校验失败或 offset 不连续即停止（处理写入中断）
+    size_t pos = 0;
+    size_t lastIndexed = 0;
+    segment.index.clear();
+
+    while (pos + sizeof(FrameHeader) <= segment.size) {
+        FrameHeader header;
+        std::memcpy(&header, segment.data + pos, sizeof(header));
+        if (header.length == 0 || pos + sizeof(FrameHeader) + header.length > segment.size ||
+            header.offset != segment.nextOffset ||
+            crc32(0, segment.data + pos + sizeof(FrameHeader), header.length) != header.checksum) {
+            break;
+        }
+
+        if (segment.index.empty() || pos - lastIndexed >= options_.indexIntervalBytes) {
+            segment.index.push_back({header.offset, header.appendTime, static_cast<uint32_t>(pos)});
+            lastIndexed = pos;
+        }
+        if (pos == 0) {
+            segment.firstTime = header.appendTime;
+        }
+        segment.lastTime = header.appendTime;
+        segment.nextOffset = header.offset + 1;
+        pos += sizeof(FrameHeader) + header.length;
+    }
+
+    segment.writePos = pos;
+    // 清掉中断写入留下的残帧头，避免之后被误读
+    if (pos + sizeof(FrameHeader) <= segment.size) {
+        std::memset(segment.data + pos, 0, sizeof(FrameHeader));
+    }
+}
+
+bool EventJournal::loadIndex(Segment& segment) {
+    std::ifstream file(segmentPath(segment.baseOffset, INDEX_EXT), std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    uint32_t magic = 0;
+    uint32_t count = 0;
+    uint64_t nextOffset = 0;
+    uint64_t writePos = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(&count), sizeof(count));
+    file.read(reinterpret_cast<char*>(&nextOffset), sizeof(nextOffset));
+    file.read(reinterpret_cast<char*>(&writePos), sizeof(writePos));
+    file.read(reinterpret_cast<char*>(&segment.firstTime), sizeof(segment.firstTime));
+    file.read(reinterpret_cast<char*>(&segment.lastTime), sizeof(segment.lastTime));
+    if (!file || magic != INDEX_MAGIC || writePos > segment.size) {
+        return false;
+    }
+
+    segment.index.resize(count);
+    file.read(reinterpret_cast<char*>(segment.index.data()), count * sizeof(IndexEntry));
+    if (!file) {
+        segment.index.clear();
+        return false;
+    }
+
+    segment.nextOffset = nextOffset;
+    segment.writePos = writePos;
+    return true;
+}
+
+void EventJournal::sealSegment(Segment& segment) {
+    segment.sealed = true;
+    // 段数据先于索引落盘，索引存在即说明其描述的帧完整
+    if (msync(segment.data, segment.size, MS_SYNC) < 0) {
+        std::cerr << "[EventJournal] msync failed for " << segment.path << ": " << strerror(errno) << std::endl;
+    }
+
+    // 先写临时文件再 rename，崩溃时不会留下半个索引
+    std::string indexPath = segmentPath(segment.baseOffset, INDEX_EXT);
+    std::string tempPath = indexPath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            std::cerr << "[EventJournal] Failed to write index for " << segment.path << std::endl;
+            return;
+        }
+        writeIndex(file, segment);
+        if (!file.flush()) {
+            std::cerr << "[EventJournal] Failed to write index for " << segment.path << std::endl;
+            unlink(tempPath.c_str());
+            return;
+        }
+    }
+
+    if (!syncPath(tempPath) || rename(tempPath.c_str(), indexPath.c_str()) < 0) {
+        std::cerr << "[EventJournal] Failed to commit index for " << segment.path << ": " << strerror(errno) << std::endl;
+        unlink(tempPath.c_str());
+        return;
+    }
+    syncPath(options_.directory);
+}
+
+void EventJournal::writeIndex(std::ostream& file, const Segment& segment) {
+
+    uint32_t count = static_cast<uint32_t>(segment.index.size());
+    uint64_t writePos = segment.writePos;
+    file.write(reinterpret_cast<const char*>(&INDEX_MAGIC), sizeof(INDEX_MAGIC));
+    file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+    file.write(reinterpret_cast<const char*>(&segment.nextOffset), sizeof(segment.nextOffset));
+    file.write(reinterpret_cast<const char*>(&writePos), sizeof(writePos));
+    file.write(reinterpret_cast<const char*>(&segment.firstTime), sizeof(segment.firstTime));
+    file.write(reinterpret_cast<const char*>(&segment.lastTime), sizeof(segment.lastTime));
+    file.write(reinterpret_cast<const char*>(segment.index.data()), count * sizeof(IndexEntry));
+}
+
+bool EventJournal::syncPath(const std::string& path) {
+    // 对目录 fsync 使新建/重命名的目录项持久化
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+void EventJournal::enforceRetention() {
+    while (segments_.size() > options_.maxSegments) {
+        const auto& oldest = segments_.front();
+        unlink(oldest->path.c_str());
+        unlink(segmentPath(oldest->baseOffset, INDEX_EXT).c_str());
+        segments_.erase(segments_.begin());
+    }
+}
+
+std::string EventJournal::segmentPath(uint64_t baseOffset, const char* extension) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%020llu", static_cast<unsigned long long>(baseOffset));
+    return options_.directory + "/" + name + extension;
+}
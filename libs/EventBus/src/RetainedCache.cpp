@@ -0,0 +1,107 @@
+// RetainedCache.cpp
+#include "RetainedCache.h"
+
+RetainedCache::RetainedCache(size_t capacity) : capacity_(capacity), size_(0), sequence_(0) {}
+
+uint64_t RetainedCache::store(const MessagePtr& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (capacity_ == 0) {
+        return 0;
+    }
+    uint64_t sequence = ++sequence_;
+
+    // 已有条目：只替换指针并移到 LRU 尾部，不分配内存
+    auto topicIt = topics_.find(message->event_type());
+    if (topicIt != topics_.end()) {
+        auto keyIt = topicIt->second.find(message->key());
+        if (keyIt != topicIt->second.end()) {
+            keyIt->second.message = message;
+            lru_.splice(lru_.end(), lru_, keyIt->second.lru);
+            return sequence;
+        }
+    }
+
+    if (size_ >= capacity_) {
+        evictOldest();
+        topicIt = topics_.find(message->event_type());
+    }
+    if (topicIt == topics_.end()) {
+        topicIt = topics_.emplace(message->event_type(), KeyMap()).first;
+    }
+
+    auto keyIt = topicIt->second.emplace(message->key(), Entry{message, lru_.end()}).first;
+    keyIt->second.lru = lru_.insert(lru_.end(), {&topicIt->first, &keyIt->first});
+    ++size_;
+    return sequence;
+}
+
+std::vector<RetainedCache::MessagePtr> RetainedCache::snapshot(uint64_t* sequence) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sequence) {
+        *sequence = sequence_;
+    }
+    std::vector<MessagePtr> result;
+    result.reserve(size_);
+    // 按更新顺序返回，保持事件的相对先后
+    for (const auto& item : lru_) {
+        result.push_back(topics_.at(*item.first).at(*item.second).message);
+    }
+    return result;
+}
+
+std::vector<RetainedCache::MessagePtr> RetainedCache::snapshot(const std::string& eventType, uint64_t* sequence) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (sequence) {
+        *sequence = sequence_;
+    }
+    std::vector<MessagePtr> result;
+    auto topicIt = topics_.find(eventType);
+    if (topicIt != topics_.end()) {
+        result.reserve(topicIt->second.size());
+        for (const auto& entry : topicIt->second) {
+            result.push_back(entry.second.message);
+        }
+    }
+    return result;
+}
+
+void RetainedCache::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    capacity_ = capacity;
+    while (size_ > capacity_) {
+        evictOldest();
+    }
+}
+
+size_t RetainedCache::capacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return capacity_;
+}
+
+size_t RetainedCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return size_;
+}
+
+void RetainedCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    topics_.clear();
+    lru_.clear();
+    size_ = 0;
+}
+
+void RetainedCache::evictOldest() {
+    if (lru_.empty()) {
+        return;
+    }
+    const std::string* topic = lru_.front().first;
+    const std::string* key = lru_.front().second;
+    lru_.pop_front();
+
+    auto topicIt = topics_.find(*topic);
+    topicIt->second.erase(topicIt->second.find(*key));
+    if (topicIt->second.empty()) {
+        topics_.erase(topicIt);
+    }
+    --size_;
+}
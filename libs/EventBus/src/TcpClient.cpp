@@ -1,5 +1,6 @@
 // TcpClient.cpp - Fixed version with better error handling
 #include "TcpClient.h"
+#include "ThreadPlacement.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
@@ -10,9 +11,10 @@
 #include <cstring>
 
 TcpClient::TcpClient(const std::string& host, int port, MessageHandler messageHandler,
-                     ConnectionStateHandler connectionHandler)
+                     ConnectionStateHandler connectionHandler, IoBackend backend)
     : host_(host), port_(port), socket_(-1), messageHandler_(messageHandler),
-      connectionHandler_(connectionHandler), connected_(false), shouldStop_(false) {
+      connectionHandler_(connectionHandler), connected_(false), shouldStop_(false),
+      backend_(backend), connectionId_(0) {
 }
 
 TcpClient::~TcpClient() {
@@ -34,8 +36,10 @@ bool TcpClient::connect() {
     connected_.store(true);
     
     // Start worker threads
-    receiveThread_ = std::thread(&TcpClient::receiveLoop, this);
-    sendThread_ = std::thread(&TcpClient::sendLoop, this);
+    if (backend_ != IoBackend::IoUring || !startReactor()) {
+        receiveThread_ = std::thread(&TcpClient::receiveLoop, this);
+        sendThread_ = std::thread(&TcpClient::sendLoop, this);
+    }
     
     notifyConnectionState(true);
     std::cout << "Connected to " << getEndpoint() << std::endl;
@@ -44,17 +48,28 @@ bool TcpClient::connect() {
 }
 
 void TcpClient::disconnect() {
-    if (!connected_.load()) {
+    // 对端断开或反应器关闭回调后 connected_ 已为 false，但工作线程仍需回收
+    if (!connected_.load() && !receiveThread_.joinable() && !reactorThread_.joinable()) {
         return;
     }
     
     std::lock_guard<std::mutex> lock(connectionMutex_);
     
     shouldStop_.store(true);
-    connected_.store(false);
+    bool wasConnected = connected_.exchange(false);
     
     // Wake up send thread
     sendCondition_.notify_all();
+
+    if (reactor_) {
+        reactor_->stop();
+        if (reactorThread_.joinable()) {
+            reactorThread_.join();
+        }
+        std::lock_guard<std::mutex> sendLock(sendMutex_);
+        reactor_.reset();
+        socket_ = -1;
+    }
     
     closeSocket();
     
@@ -74,11 +89,17 @@ void TcpClient::disconnect() {
         }
     }
     
-    notifyConnectionState(false);
+    if (wasConnected) {
+        notifyConnectionState(false);
+    }
     std::cout << "Disconnected from " << getEndpoint() << std::endl;
 }
 
 void TcpClient::sendMessage(const EventMessage& message) {
+    sendMessage(std::make_shared<const EventMessage>(message));
+}
+
+void TcpClient::sendMessage(MessagePtr message) {
     std::cout << "Queued message, sendQueue size: " << sendQueue_.size() << std::endl;
     if (!connected_.load()) {
         std::cerr << "Warning: Trying to send message while not connected to " 
@@ -88,7 +109,12 @@ void TcpClient::sendMessage(const EventMessage& message) {
     
     {
         std::lock_guard<std::mutex> lock(sendMutex_);
-        sendQueue_.push(message);
+        if (reactor_) {
+            // 在调用线程序列化，反应器只负责合并发送
+            reactor_->send(connectionId_, UringReactor::encodeFrame(*message));
+            return;
+        }
+        sendQueue_.push(std::move(message));
     }
     sendCondition_.notify_one();
 }
@@ -185,6 +211,42 @@ bool TcpClient::connectSocket() {
     return true;
 }
 
+bool TcpClient::startReactor() {
+    auto reactor = std::make_unique<UringReactor>(
+        [this](UringReactor::ConnectionId, const char* data, size_t size) {
+            EventMessage message;
+            if (!message.ParseFromArray(data, static_cast<int>(size))) {
+                std::cerr << "Failed to parse message from " << getEndpoint() << std::endl;
+                return;
+            }
+            if (messageHandler_) {
+                messageHandler_(message);
+            }
+        },
+        [this](UringReactor::ConnectionId) {
+            std::cout << "Server " << getEndpoint() << " closed connection" << std::endl;
+            if (connected_.exchange(false)) {
+                notifyConnectionState(false);
+            }
+        });
+    if (!reactor->init()) {
+        std::cerr << "io_uring unavailable, falling back to blocking I/O for " << getEndpoint() << std::endl;
+        return false;
+    }
+
+    UringReactor::ConnectionId id = reactor->addConnection(socket_);
+    {
+        std::lock_guard<std::mutex> lock(sendMutex_);
+        connectionId_ = id;
+        reactor_ = std::move(reactor);
+    }
+    reactorThread_ = std::thread([this]() {
+        ThreadPlacement::getInstance().apply(ThreadRole::IO, "io-uring");
+        reactor_->run();
+    });
+    return true;
+}
+
 void TcpClient::closeSocket() {
     if (socket_ >= 0) {
         shutdown(socket_, SHUT_RDWR); // Graceful shutdown
@@ -204,6 +266,7 @@ void TcpClient::notifyConnectionState(bool connected) {
 }
 
 void TcpClient::receiveLoop() {
+    ThreadPlacement::getInstance().apply(ThreadRole::IO, "io-recv");
     while (connected_.load() && !shouldStop_.load()) {
         try {
             uint32_t messageSize;
@@ -276,9 +339,10 @@ exit_loop:
 }
 
 void TcpClient::sendLoop() {
+    ThreadPlacement::getInstance().apply(ThreadRole::IO, "io-send");
     std::cout << "sendLoop iteration, queue size: " << sendQueue_.size() << std::endl;
     while (!shouldStop_.load()) {
-        EventMessage message;
+        MessagePtr message;
         bool hasMessage = false;
         
         {
@@ -296,7 +360,7 @@ void TcpClient::sendLoop() {
         
         if (hasMessage && connected_.load()) {
             try {
-                std::string serialized = message.SerializeAsString();
+                std::string serialized = message->SerializeAsString();
                 uint32_t messageSize = htonl(serialized.size());
                 
                 // Send size header
@@ -1,6 +1,7 @@
 // TcpServer.cpp
 #include <arpa/inet.h>
 #include "TcpServer.h"
+#include "ThreadPlacement.h"
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <unistd.h>
@@ -11,29 +12,35 @@
 #include <algorithm>
 
 TcpServer::TcpServer(int port, MessageHandler messageHandler,
-                     ClientConnectionHandler connectionHandler)
-    : port_(port), serverSocket_(-1), messageHandler_(messageHandler),
-      connectionHandler_(connectionHandler), running_(false), shouldStop_(false) {
+                     ClientConnectionHandler connectionHandler, IoBackend backend)
+    : port_(port), shardCount_(1), backlog_(SOMAXCONN), messageHandler_(messageHandler),
+      connectionHandler_(connectionHandler), running_(false), shouldStop_(false),
+      backend_(backend), useReactor_(false) {
 }
 
 TcpServer::~TcpServer() {
     stop();
 }
 
-void TcpServer::start() {
-    if (running_.load()) {
-        std::cout << "Server already running" << std::endl;
-        return;
+TcpServer::ClientConnection::~ClientConnection() {
+    if (ownsSocket) {
+        close(socket);
     }
-    
-    serverSocket_ = socket(AF_INET, SOCK_STREAM, 0);
-    if (serverSocket_ < 0) {
+}
+
+int TcpServer::openListener(bool reusePort) {
+    int listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenSocket < 0) {
         throw std::runtime_error("Failed to create server socket: " + std::string(strerror(errno)));
     }
     
     // Allow socket reuse
     int opt = 1;
-    setsockopt(serverSocket_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reusePort && setsockopt(listenSocket, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        close(listenSocket);
+        throw std::runtime_error("Failed to enable SO_REUSEPORT: " + std::string(strerror(errno)));
+    }
     
     struct sockaddr_in serverAddr;
     memset(&serverAddr, 0, sizeof(serverAddr));
@@ -41,28 +48,92 @@ void TcpServer::start() {
     serverAddr.sin_addr.s_addr = INADDR_ANY;
     serverAddr.sin_port = htons(port_);
     
-    if (bind(serverSocket_, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
-        close(serverSocket_);
+    if (bind(listenSocket, (struct sockaddr*)&serverAddr, sizeof(serverAddr)) < 0) {
+        close(listenSocket);
         throw std::runtime_error("Failed to bind server socket: " + std::string(strerror(errno)));
     }
     
-    if (listen(serverSocket_, 10) < 0) {
-        close(serverSocket_);
+    // 内核会把 backlog 截断到 net.core.somaxconn
+    if (listen(listenSocket, backlog_) < 0) {
+        close(listenSocket);
         throw std::runtime_error("Failed to listen on server socket: " + std::string(strerror(errno)));
     }
+    return listenSocket;
+}
+
+void TcpServer::start() {
+    if (running_.load()) {
+        std::cout << "Server already running" << std::endl;
+        return;
+    }
+    
+    // 单分片时不设置 SO_REUSEPORT，避免其他进程误绑定同一端口
+    try {
+        for (int i = 0; i < shardCount_; ++i) {
+            auto shard = std::make_unique<ListenerShard>();
+            shard->socket = openListener(shardCount_ > 1);
+            shards_.push_back(std::move(shard));
+        }
+    } catch (...) {
+        for (auto& shard : shards_) {
+            close(shard->socket);
+        }
+        shards_.clear();
+        throw;
+    }
     
     running_.store(true);
     shouldStop_.store(false);
-    
-    acceptThread_ = std::thread(&TcpServer::acceptLoop, this);
-    cleanupThread_ = std::thread([this]() {
-        while (running_.load()) {
-            std::this_thread::sleep_for(std::chrono::seconds(5));
-            cleanupFinishedThreads();
+
+    useReactor_ = backend_ == IoBackend::IoUring && startReactors();
+    if (backend_ == IoBackend::IoUring && !useReactor_) {
+        std::cerr << "io_uring unavailable, falling back to blocking I/O" << std::endl;
+    }
+
+    if (!useReactor_) {
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            shards_[i]->acceptThread = std::thread(&TcpServer::acceptLoop, this, i);
         }
-    });
+        cleanupThread_ = std::thread([this]() {
+            while (running_.load()) {
+                {
+                    std::unique_lock<std::mutex> lock(threadsMutex_);
+                    stopCondition_.wait_for(lock, std::chrono::seconds(5), [this]() { return !running_.load(); });
+                }
+                cleanupFinishedThreads();
+            }
+        });
+    }
     
-    std::cout << "Server started on port " << port_ << std::endl;
+    std::cout << "Server started on port " << port_ << " (" << UringReactor::backendName(
+                     useReactor_ ? IoBackend::IoUring : IoBackend::Blocking)
+              << ", " << shards_.size() << " listener(s), backlog " << backlog_ << ")" << std::endl;
+}
+
+bool TcpServer::startReactors() {
+    // 全部初始化成功后才启动线程，失败时整体回退到阻塞模式
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        auto& shard = shards_[i];
+        shard->reactor = std::make_unique<UringReactor>(
+            [this, i](UringReactor::ConnectionId id, const char* data, size_t size) { onUringFrame(i, id, data, size); },
+            [this, i](UringReactor::ConnectionId id) { onUringClose(i, id); });
+        if (!shard->reactor->init()) {
+            for (auto& created : shards_) {
+                created->reactor.reset();
+            }
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < shards_.size(); ++i) {
+        UringReactor* reactor = shards_[i]->reactor.get();
+        reactor->listen(shards_[i]->socket, [this, i](UringReactor::ConnectionId id) { onUringAccept(i, id); });
+        shards_[i]->reactorThread = std::thread([reactor, i]() {
+            ThreadPlacement::getInstance().apply(ThreadRole::IO, "io-uring-" + std::to_string(i));
+            reactor->run();
+        });
+    }
+    return true;
 }
 
 void TcpServer::stop() {
@@ -70,16 +141,47 @@ void TcpServer::stop() {
         return;
     }
     
-    shouldStop_.store(true);
-    running_.store(false);
+    {
+        std::lock_guard<std::mutex> lock(threadsMutex_);
+        shouldStop_.store(true);
+        running_.store(false);
+    }
+    stopCondition_.notify_all();
+
+    // 反应器负责关闭它接管的连接，监听 socket 在其退出后再关闭
+    if (useReactor_) {
+        for (auto& shard : shards_) {
+            shard->reactor->stop();
+        }
+        for (auto& shard : shards_) {
+            if (shard->reactorThread.joinable()) {
+                shard->reactorThread.join();
+            }
+        }
+        for (auto& shard : shards_) {
+            {
+                std::lock_guard<std::mutex> lock(shard->mutex);
+                shard->clients.clear();
+                shard->uringEndpoints.clear();
+            }
+            shard->reactor.reset();
+        }
+    }
     
-    if (serverSocket_ >= 0) {
-        close(serverSocket_);
-        serverSocket_ = -1;
+    // shutdown 唤醒阻塞在 accept/recv 上的线程，仅 close 不会唤醒
+    for (auto& shard : shards_) {
+        shutdown(shard->socket, SHUT_RDWR);
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto& client : shard->clients) {
+            shutdown(client.second->socket, SHUT_RDWR);
+        }
     }
     
-    if (acceptThread_.joinable()) {
-        acceptThread_.join();
+    for (auto& shard : shards_) {
+        if (shard->acceptThread.joinable()) {
+            shard->acceptThread.join();
+        }
+        close(shard->socket);
     }
     
     if (cleanupThread_.joinable()) {
@@ -97,30 +199,88 @@ void TcpServer::stop() {
         clientThreads_.clear();
     }
     
-    {
-        std::lock_guard<std::mutex> lock(clientsMutex_);
-        connectedClients_.clear();
-    }
+    // 连接线程退出时会访问所属分片，全部结束后才能释放分片
+    shards_.clear();
     
     std::cout << "Server stopped" << std::endl;
 }
 
 size_t TcpServer::getConnectedClientsCount() const {
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    return connectedClients_.size();
+    size_t count = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        count += shard->clients.size();
+    }
+    return count;
 }
 
 std::vector<std::string> TcpServer::getConnectedClients() const {
-    std::lock_guard<std::mutex> lock(clientsMutex_);
-    return std::vector<std::string>(connectedClients_.begin(), connectedClients_.end());
+    std::vector<std::string> clients;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        for (const auto& client : shard->clients) {
+            clients.push_back(client.first);
+        }
+    }
+    return clients;
+}
+
+bool TcpServer::sendToClient(const std::string& clientEndpoint, const EventMessage& message) {
+    if (useReactor_) {
+        std::string frame = UringReactor::encodeFrame(message);
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            auto it = shard->clients.find(clientEndpoint);
+            if (it != shard->clients.end()) {
+                return shard->reactor->send(it->second->uringId, std::move(frame));
+            }
+        }
+        return false;
+    }
+
+    // 只在查找时持有分片锁，慢客户端不会阻塞其他连接的接入和发送
+    ConnectionPtr connection;
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        auto it = shard->clients.find(clientEndpoint);
+        if (it != shard->clients.end()) {
+            connection = it->second;
+            break;
+        }
+    }
+    if (!connection) {
+        return false;
+    }
+
+    std::string serialized = message.SerializeAsString();
+    uint32_t messageSize = htonl(serialized.size());
+
+    std::lock_guard<std::mutex> sendLock(connection->sendMutex);
+    if (send(connection->socket, &messageSize, sizeof(messageSize), MSG_NOSIGNAL) != sizeof(messageSize)) {
+        return false;
+    }
+    size_t totalSent = 0;
+    while (totalSent < serialized.size()) {
+        ssize_t sent = send(connection->socket, serialized.data() + totalSent,
+                            serialized.size() - totalSent, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            std::cerr << "Send error to " << clientEndpoint << ": " << strerror(errno) << std::endl;
+            return false;
+        }
+        totalSent += sent;
+    }
+    return true;
 }
 
-void TcpServer::acceptLoop() {
+void TcpServer::acceptLoop(size_t shardIndex) {
+    ThreadPlacement::getInstance().apply(ThreadRole::IO, "io-accept");
+    ListenerShard& shard = *shards_[shardIndex];
+    const int listenSocket = shard.socket;
     while (running_.load() && !shouldStop_.load()) {
         struct sockaddr_in clientAddr;
         socklen_t clientLen = sizeof(clientAddr);
         
-        int clientSocket = accept(serverSocket_, (struct sockaddr*)&clientAddr, &clientLen);
+        int clientSocket = accept(listenSocket, (struct sockaddr*)&clientAddr, &clientLen);
         
         if (clientSocket < 0) {
             if (running_.load() && errno != EINTR) {
@@ -131,9 +291,10 @@ void TcpServer::acceptLoop() {
         
         std::string clientEndpoint = getClientEndpoint(clientSocket);
         
+        auto connection = std::make_shared<ClientConnection>(clientSocket, true);
         {
-            std::lock_guard<std::mutex> lock(clientsMutex_);
-            connectedClients_.insert(clientEndpoint);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.clients[clientEndpoint] = connection;
         }
         
         if (connectionHandler_) {
@@ -143,14 +304,16 @@ void TcpServer::acceptLoop() {
         // Create thread to handle this client
         {
             std::lock_guard<std::mutex> lock(threadsMutex_);
-            clientThreads_.emplace_back(&TcpServer::handleClient, this, clientSocket, clientEndpoint);
+            clientThreads_.emplace_back(&TcpServer::handleClient, this, shardIndex, std::move(connection), clientEndpoint);
         }
         
         std::cout << "Client connected: " << clientEndpoint << std::endl;
     }
 }
 
-void TcpServer::handleClient(int clientSocket, const std::string& clientEndpoint) {
+void TcpServer::handleClient(size_t shardIndex, ConnectionPtr connection, const std::string& clientEndpoint) {
+    ThreadPlacement::getInstance().apply(ThreadRole::IO, "io-conn");
+    const int clientSocket = connection->socket;
     while (running_.load() && !shouldStop_.load()) {
         try {
             uint32_t messageSize;
@@ -203,18 +366,77 @@ void TcpServer::handleClient(int clientSocket, const std::string& clientEndpoint
     }
     
 client_disconnected:
-    close(clientSocket);
-    
     {
-        std::lock_guard<std::mutex> lock(clientsMutex_);
-        connectedClients_.erase(clientEndpoint);
+        ListenerShard& shard = *shards_[shardIndex];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.clients.find(clientEndpoint);
+        if (it != shard.clients.end() && it->second == connection) {
+            shard.clients.erase(it);
+        }
     }
+    // 停止收发后由最后一个持有者关闭 socket（可能是正在发送的 sendToClient）
+    shutdown(clientSocket, SHUT_RDWR);
+    connection.reset();
     
     if (connectionHandler_) {
         connectionHandler_(clientEndpoint, false);
     }
 }
 
+void TcpServer::onUringAccept(size_t shardIndex, UringReactor::ConnectionId id) {
+    int clientSocket = UringReactor::fdOf(id);
+    std::string clientEndpoint = getClientEndpoint(clientSocket);
+    {
+        ListenerShard& shard = *shards_[shardIndex];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.clients[clientEndpoint] = std::make_shared<ClientConnection>(clientSocket, false, id);
+        shard.uringEndpoints[id] = clientEndpoint;
+    }
+
+    if (connectionHandler_) {
+        connectionHandler_(clientEndpoint, true);
+    }
+    std::cout << "Client connected: " << clientEndpoint << std::endl;
+}
+
+void TcpServer::onUringFrame(size_t shardIndex, UringReactor::ConnectionId id, const char* data, size_t size) {
+    EventMessage message;
+    if (!message.ParseFromArray(data, static_cast<int>(size))) {
+        ListenerShard& shard = *shards_[shardIndex];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.uringEndpoints.find(id);
+        std::cerr << "Failed to parse message from "
+                  << (it != shard.uringEndpoints.end() ? it->second : "unknown") << std::endl;
+        return;
+    }
+    if (messageHandler_) {
+        messageHandler_(message);
+    }
+}
+
+void TcpServer::onUringClose(size_t shardIndex, UringReactor::ConnectionId id) {
+    std::string clientEndpoint;
+    {
+        ListenerShard& shard = *shards_[shardIndex];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.uringEndpoints.find(id);
+        if (it == shard.uringEndpoints.end()) {
+            return;
+        }
+        clientEndpoint = std::move(it->second);
+        shard.uringEndpoints.erase(it);
+        auto client = shard.clients.find(clientEndpoint);
+        if (client != shard.clients.end() && client->second->uringId == id) {
+            shard.clients.erase(client);
+        }
+    }
+
+    std::cout << "Client disconnected: " << clientEndpoint << std::endl;
+    if (connectionHandler_) {
+        connectionHandler_(clientEndpoint, false);
+    }
+}
+
 void TcpServer::cleanupFinishedThreads() {
     std::lock_guard<std::mutex> lock(threadsMutex_);
     
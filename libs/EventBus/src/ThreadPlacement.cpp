@@ -0,0 +1,142 @@
+// ThreadPlacement.cpp
+#include "ThreadPlacement.h"
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+ThreadPlacement::ThreadPlacement() : hasDefaultCpus_(false), defaultNice_(0) {
+    CPU_ZERO(&defaultCpus_);
+    hasDefaultCpus_ = sched_getaffinity(0, sizeof(defaultCpus_), &defaultCpus_) == 0;
+    errno = 0;
+    int nice = getpriority(PRIO_PROCESS, 0);
+    if (errno == 0) {
+        defaultNice_ = nice;
+    }
+}
+
+void ThreadPlacement::setPolicy(ThreadRole role, const ThreadPolicy& policy) {
+    ThreadPolicy checked = policy;
+    checked.cpus.clear();
+    for (int cpu : policy.cpus) {
+        if (isValidCpu(cpu)) {
+            checked.cpus.push_back(cpu);
+        } else {
+            std::cerr << "[ThreadPlacement] Ignoring invalid cpu " << cpu << " for role "
+                      << roleName(role) << std::endl;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    policies_[static_cast<size_t>(role)] = checked;
+}
+
+bool ThreadPlacement::isValidCpu(int cpu) {
+    return cpu >= 0 && cpu < CPU_SETSIZE;
+}
+
+bool ThreadPlacement::isCpuAllowed(int cpu) const {
+    return isValidCpu(cpu) && (!hasDefaultCpus_ || CPU_ISSET(cpu, &defaultCpus_));
+}
+
+ThreadPolicy ThreadPlacement::getPolicy(ThreadRole role) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return policies_[static_cast<size_t>(role)];
+}
+
+int ThreadPlacement::threadCount(ThreadRole role, int defaultCount) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int count = policies_[static_cast<size_t>(role)].count;
+    return count > 0 ? count : defaultCount;
+}
+
+void ThreadPlacement::apply(ThreadRole role, const std::string& threadName) {
+    // Linux 线程名最长 15 个字符
+    std::string name = threadName.empty() ? roleName(role) : threadName;
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+
+    ThreadPolicy policy = getPolicy(role);
+
+    // 线程继承创建者的亲和性和调度策略，未配置的角色显式恢复为进程默认值
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    if (!policy.cpus.empty()) {
+        if (policy.spread) {
+            unsigned cursor = spreadCursor_[static_cast<size_t>(role)].fetch_add(1);
+            CPU_SET(policy.cpus[cursor % policy.cpus.size()], &cpuSet);
+        } else {
+            for (int cpu : policy.cpus) {
+                CPU_SET(cpu, &cpuSet);
+            }
+        }
+    } else if (hasDefaultCpus_) {
+        cpuSet = defaultCpus_;
+    }
+    if (!policy.cpus.empty() || hasDefaultCpus_) {
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+        if (rc != 0) {
+            std::cerr << "[ThreadPlacement] Failed to pin " << name << ": " << strerror(rc) << std::endl;
+        }
+    }
+
+    if (policy.schedPolicy == SCHED_FIFO || policy.schedPolicy == SCHED_RR) {
+        sched_param param;
+        param.sched_priority = policy.priority;
+        int rc = pthread_setschedparam(pthread_self(), policy.schedPolicy, &param);
+        if (rc != 0) {
+            std::cerr << "[ThreadPlacement] Failed to set realtime policy for " << name
+                      << ": " << strerror(rc) << " (requires CAP_SYS_NICE)" << std::endl;
+        }
+        return;
+    }
+
+    int currentPolicy = SCHED_OTHER;
+    sched_param currentParam;
+    if (pthread_getschedparam(pthread_self(), &currentPolicy, &currentParam) == 0 &&
+        currentPolicy != SCHED_OTHER) {
+        sched_param param;
+        param.sched_priority = 0;
+        int rc = pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+        if (rc != 0) {
+            std::cerr << "[ThreadPlacement] Failed to reset policy for " << name << ": " << strerror(rc) << std::endl;
+        }
+    }
+
+    pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+    int nice = policy.priority != 0 ? policy.priority : defaultNice_;
+    errno = 0;
+    int currentNice = getpriority(PRIO_PROCESS, tid);
+    if ((errno != 0 || currentNice != nice) && setpriority(PRIO_PROCESS, tid, nice) < 0) {
+        std::cerr << "[ThreadPlacement] Failed to set nice for " << name << ": " << strerror(errno) << std::endl;
+    }
+}
+
+const char* ThreadPlacement::roleName(ThreadRole role) {
+    switch (role) {
+        case ThreadRole::IO: return "io";
+        case ThreadRole::Dispatch: return "dispatch";
+        case ThreadRole::App: return "app";
+        case ThreadRole::Timer: return "timer";
+    }
+    return "unknown";
+}
+
+bool ThreadPlacement::parseRole(const std::string& name, ThreadRole& role) {
+    for (ThreadRole candidate : {ThreadRole::IO, ThreadRole::Dispatch, ThreadRole::App, ThreadRole::Timer}) {
+        if (name == roleName(candidate)) {
+            role = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+int ThreadPlacement::parseSchedPolicy(const std::string& name) {
+    if (name == "fifo") return SCHED_FIFO;
+    if (name == "rr") return SCHED_RR;
+    return SCHED_OTHER;
+}
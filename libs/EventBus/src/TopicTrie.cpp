@@ -0,0 +1,114 @@
+// TopicTrie.cpp
+#include "TopicTrie.h"
+#include <algorithm>
+
+TopicTrie::TopicTrie() : root_(std::make_unique<Node>()), nextSequence_(0) {}
+
+bool TopicTrie::insert(const std::string& pattern, HandlerPtr handler) {
+    if (!isValidPattern(pattern)) {
+        return false;
+    }
+
+    Node* node = root_.get();
+    for (const auto& segment : split(pattern)) {
+        if (segment == "#") {
+            node->multiWildcard.push_back({nextSequence_++, std::move(handler)});
+            return true;
+        }
+        std::unique_ptr<Node>& next = (segment == "*") ? node->singleWildcard : node->children[segment];
+        if (!next) {
+            next = std::make_unique<Node>();
+        }
+        node = next.get();
+    }
+    node->handlers.push_back({nextSequence_++, std::move(handler)});
+    return true;
+}
+
+std::vector<TopicTrie::HandlerPtr> TopicTrie::match(const std::string& topic) const {
+    std::vector<Entry> entries;
+    collect(*root_, split(topic), 0, entries);
+
+    // 多个模式可能同时匹配，按注册顺序调用
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry& a, const Entry& b) { return a.sequence < b.sequence; });
+
+    std::vector<HandlerPtr> result;
+    result.reserve(entries.size());
+    for (auto& entry : entries) {
+        result.push_back(std::move(entry.handler));
+    }
+    return result;
+}
+
+void TopicTrie::collect(const Node& node, const std::vector<std::string>& segments, size_t depth,
+                        std::vector<Entry>& out) const {
+    out.insert(out.end(), node.multiWildcard.begin(), node.multiWildcard.end());
+
+    if (depth == segments.size()) {
+        out.insert(out.end(), node.handlers.begin(), node.handlers.end());
+        return;
+    }
+
+    auto it = node.children.find(segments[depth]);
+    if (it != node.children.end()) {
+        collect(*it->second, segments, depth + 1, out);
+    }
+    if (node.singleWildcard) {
+        collect(*node.singleWildcard, segments, depth + 1, out);
+    }
+}
+
+bool TopicTrie::isPattern(const std::string& topic) {
+    for (const auto& segment : split(topic)) {
+        if (segment == "*" || segment == "#") {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TopicTrie::isValidPattern(const std::string& pattern) {
+    auto segments = split(pattern);
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (segments[i].empty()) {
+            return false;
+        }
+        if (segments[i] == "#" && i + 1 != segments.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TopicTrie::matches(const std::string& pattern, const std::string& topic) {
+    auto patternSegments = split(pattern);
+    auto topicSegments = split(topic);
+
+    for (size_t i = 0; i < patternSegments.size(); ++i) {
+        if (patternSegments[i] == "#") {
+            return true;
+        }
+        if (i >= topicSegments.size()) {
+            return false;
+        }
+        if (patternSegments[i] != "*" && patternSegments[i] != topicSegments[i]) {
+            return false;
+        }
+    }
+    return patternSegments.size() == topicSegments.size();
+}
+
+std::vector<std::string> TopicTrie::split(const std::string& topic) {
+    std::vector<std::string> segments;
+    size_t start = 0;
+    while (true) {
+        size_t dot = topic.find('.', start);
+        segments.push_back(topic.substr(start, dot - start));
+        if (dot == std::string::npos) {
+            break;
+        }
+        start = dot + 1;
+    }
+    return segments;
+}
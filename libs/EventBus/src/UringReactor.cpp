@@ -0,0 +1,749 @@
+// UringReactor.cpp
+#include "UringReactor.h"
+#include <arpa/inet.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+int uringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+int uringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int uringRegister(int ringFd, unsigned opcode, void* arg, unsigned nrArgs) {
+    return static_cast<int>(syscall(__NR_io_uring_register, ringFd, opcode, arg, nrArgs));
+}
+
+// user_data 编码：代数(32) | fd(24) | 操作类型(8)，fd 复用后旧连接的完成事件可以识别出来
+uint64_t makeUserData(int fd, uint32_t generation, uint64_t op) {
+    return (static_cast<uint64_t>(generation) << 32) |
+           (static_cast<uint64_t>(static_cast<uint32_t>(fd) & 0xffffff) << 8) | op;
+}
+
+UringReactor::ConnectionId makeConnectionId(int fd, uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+
+}
+
+UringReactor::UringReactor(FrameHandler frameHandler, CloseHandler closeHandler)
+    : frameHandler_(std::move(frameHandler)), closeHandler_(std::move(closeHandler)),
+      ringFd_(-1), sqRing_(nullptr), cqRing_(nullptr), sqRingSize_(0), cqRingSize_(0),
+      sqes_(nullptr), sqEntries_(0), sqHead_(nullptr), sqTail_(nullptr), sqMask_(0),
+      cqHead_(nullptr), cqTail_(nullptr), cqMask_(0), cqes_(nullptr), localTail_(0), toSubmit_(0),
+      bufferRing_(nullptr), bufferRingSize_(0), bufferMask_(BUFFER_COUNT - 1), bufferTail_(0),
+      listenFd_(-1), acceptArmed_(false), wakeFd_(-1), wakeValue_(0), wakeArmed_(false), inflightOps_(0),
+      generation_(0), wakePending_(false), stopRequested_(false), shuttingDown_(false) {
+}
+
+UringReactor::~UringReactor() {
+    teardown();
+}
+
+bool UringReactor::isSupported() {
+    static const bool supported = []() {
+        UringReactor probe(nullptr);
+        return probe.init();
+    }();
+    return supported;
+}
+
+bool UringReactor::parseBackend(const std::string& name, IoBackend& backend) {
+    if (name == "io_uring" || name == "uring") {
+        backend = IoBackend::IoUring;
+        return true;
+    }
+    if (name == "blocking") {
+        backend = IoBackend::Blocking;
+        return true;
+    }
+    return false;
+}
+
+const char* UringReactor::backendName(IoBackend backend) {
+    return backend == IoBackend::IoUring ? "io_uring" : "blocking";
+}
+
+bool UringReactor::init() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    // 协作式任务运行：完成事件在下次进入内核时处理，减少 IPI
+    params.flags = IORING_SETUP_COOP_TASKRUN;
+    ringFd_ = uringSetup(RING_ENTRIES, &params);
+    if (ringFd_ < 0 && errno == EINVAL) {
+        memset(&params, 0, sizeof(params));
+        ringFd_ = uringSetup(RING_ENTRIES, &params);
+    }
+    if (ringFd_ < 0) {
+        return false;
+    }
+
+    sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+    }
+
+    sqRing_ = mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ringFd_, IORING_OFF_SQ_RING);
+    if (sqRing_ == MAP_FAILED) {
+        sqRing_ = nullptr;
+        teardown();
+        return false;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        cqRing_ = sqRing_;
+    } else {
+        cqRing_ = mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                       ringFd_, IORING_OFF_CQ_RING);
+        if (cqRing_ == MAP_FAILED) {
+            cqRing_ = nullptr;
+            teardown();
+            return false;
+        }
+    }
+
+    void* sqes = mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ringFd_, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        teardown();
+        return false;
+    }
+    sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+    char* sq = static_cast<char*>(sqRing_);
+    char* cq = static_cast<char*>(cqRing_);
+    sqEntries_ = params.sq_entries;
+    sqHead_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    localTail_ = *sqTail_;
+
+    // SQ 索引数组固定为恒等映射，提交时只需推进 tail
+    unsigned* array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    for (unsigned i = 0; i < sqEntries_; ++i) {
+        array[i] = i;
+    }
+
+    // 注册缓冲环，multishot recv 从中取缓冲区
+    bufferRingSize_ = BUFFER_COUNT * sizeof(io_uring_buf);
+    void* ring = mmap(nullptr, bufferRingSize_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring == MAP_FAILED) {
+        teardown();
+        return false;
+    }
+    bufferRing_ = static_cast<io_uring_buf*>(ring);
+
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(bufferRing_);
+    reg.ring_entries = BUFFER_COUNT;
+    reg.bgid = BUFFER_GROUP;
+    if (uringRegister(ringFd_, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        teardown();
+        return false;
+    }
+
+    bufferPool_.resize(static_cast<size_t>(BUFFER_COUNT) * BUFFER_SIZE);
+    for (unsigned i = 0; i < BUFFER_COUNT; ++i) {
+        recycleBuffer(static_cast<uint16_t>(i));
+    }
+
+    wakeFd_ = eventfd(0, EFD_CLOEXEC);
+    if (wakeFd_ < 0) {
+        teardown();
+        return false;
+    }
+
+    // 5.19 已有缓冲环和 multishot accept，但 multishot recv 需要 6.0
+    if (!probeMultishot()) {
+        teardown();
+        return false;
+    }
+    return true;
+}
+
+bool UringReactor::probeMultishot() {
+    int pair[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, pair) < 0) {
+        return false;
+    }
+
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = pair[0];
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = makeUserData(0, 0, OP_PROBE);
+    submitAndWait(0);
+
+    bool supported = false;
+    int32_t res = 0;
+    uint32_t flags = 0;
+    char byte = 0;
+    if (write(pair[1], &byte, 1) == 1 && waitCompletion(res, flags)) {
+        // 不支持时内核直接以 -EINVAL 结束请求；支持时返回数据且带 F_MORE
+        supported = res == 1 && (flags & IORING_CQE_F_BUFFER) && (flags & IORING_CQE_F_MORE);
+        if (flags & IORING_CQE_F_BUFFER) {
+            recycleBuffer(static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT));
+        }
+        // 关闭写端，multishot 请求以 res == 0 结束
+        close(pair[1]);
+        pair[1] = -1;
+        while ((flags & IORING_CQE_F_MORE) && waitCompletion(res, flags)) {
+            if (flags & IORING_CQE_F_BUFFER) {
+                recycleBuffer(static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT));
+            }
+        }
+    }
+
+    if (pair[1] >= 0) {
+        close(pair[1]);
+    }
+    close(pair[0]);
+    return supported;
+}
+
+bool UringReactor::waitCompletion(int32_t& res, uint32_t& flags) {
+    // 仅在 init() 中使用，此时 ring 上只有探测请求
+    for (int attempts = 0; attempts < 100; ++attempts) {
+        unsigned head = *cqHead_;
+        if (head != __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe& cqe = cqes_[head & cqMask_];
+            res = cqe.res;
+            flags = cqe.flags;
+            __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+            return true;
+        }
+        if (uringEnter(ringFd_, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+    return false;
+}
+
+void UringReactor::listen(int listenFd, AcceptHandler acceptHandler) {
+    listenFd_ = listenFd;
+    acceptHandler_ = std::move(acceptHandler);
+}
+
+uint32_t UringReactor::nextGeneration() {
+    uint32_t generation = generation_.fetch_add(1) + 1;
+    // 0 保留给探测请求
+    return generation != 0 ? generation : generation_.fetch_add(1) + 1;
+}
+
+UringReactor::ConnectionId UringReactor::addConnection(int fd) {
+    ConnectionId id = makeConnectionId(fd, nextGeneration());
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pendingAdds_.push_back(id);
+    }
+    if (!wakePending_.exchange(true)) {
+        uint64_t one = 1;
+        (void)!write(wakeFd_, &one, sizeof(one));
+    }
+    return id;
+}
+
+bool UringReactor::send(ConnectionId id, std::string frame) {
+    if (stopRequested_.load()) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        std::string& pending = pendingSends_[id];
+        if (pending.empty()) {
+            pending.swap(frame);
+        } else {
+            pending.append(frame);
+        }
+    }
+    // 反应器处理前只唤醒一次，高频发送时不会每条消息一次系统调用
+    if (!wakePending_.exchange(true)) {
+        uint64_t one = 1;
+        (void)!write(wakeFd_, &one, sizeof(one));
+    }
+    return true;
+}
+
+void UringReactor::closeConnection(ConnectionId id) {
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pendingCloses_.push_back(id);
+    }
+    if (!wakePending_.exchange(true)) {
+        uint64_t one = 1;
+        (void)!write(wakeFd_, &one, sizeof(one));
+    }
+}
+
+void UringReactor::stop() {
+    stopRequested_.store(true);
+    if (wakeFd_ >= 0) {
+        uint64_t one = 1;
+        (void)!write(wakeFd_, &one, sizeof(one));
+    }
+}
+
+std::string UringReactor::encodeFrame(const EventMessage& message) {
+    size_t size = message.ByteSizeLong();
+    std::string frame(sizeof(uint32_t) + size, '\0');
+    uint32_t header = htonl(static_cast<uint32_t>(size));
+    memcpy(&frame[0], &header, sizeof(header));
+    message.SerializeWithCachedSizesToArray(reinterpret_cast<uint8_t*>(&frame[sizeof(header)]));
+    return frame;
+}
+
+void UringReactor::run() {
+    armWake();
+    if (listenFd_ >= 0) {
+        armAccept();
+    }
+
+    while (true) {
+        drainPending();
+        if (stopRequested_.load() && !shuttingDown_) {
+            beginShutdown();
+        }
+        if (shuttingDown_ && inflightOps_ == 0) {
+            break;
+        }
+        submitAndWait(1);
+        processCompletions();
+    }
+
+    // 所有请求都已完成，剩余连接直接关闭
+    for (auto& entry : connections_) {
+        close(entry.first);
+    }
+    connections_.clear();
+}
+
+io_uring_sqe* UringReactor::getSqe() {
+    // SQ 满时先提交已有请求
+    if (localTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_) {
+        submitAndWait(0);
+    }
+    io_uring_sqe* sqe = &sqes_[localTail_ & sqMask_];
+    memset(sqe, 0, sizeof(*sqe));
+    ++localTail_;
+    ++toSubmit_;
+    return sqe;
+}
+
+void UringReactor::submitAndWait(unsigned waitNr) {
+    if (toSubmit_ == 0 && waitNr == 0) {
+        return;
+    }
+    __atomic_store_n(sqTail_, localTail_, __ATOMIC_RELEASE);
+    int ret = uringEnter(ringFd_, toSubmit_, waitNr, waitNr > 0 ? IORING_ENTER_GETEVENTS : 0);
+    if (ret >= 0) {
+        toSubmit_ -= static_cast<unsigned>(ret);
+    } else if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+        std::cerr << "[UringReactor] io_uring_enter failed: " << strerror(errno) << std::endl;
+    }
+}
+
+void UringReactor::processCompletions() {
+    unsigned head = *cqHead_;
+    unsigned tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+    while (head != tail) {
+        const io_uring_cqe& cqe = cqes_[head & cqMask_];
+        uint64_t userData = cqe.user_data;
+        int32_t res = cqe.res;
+        uint32_t flags = cqe.flags;
+        ++head;
+        __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+
+        handleCompletion(userData, res, flags);
+        if (head == tail) {
+            tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+        }
+    }
+}
+
+void UringReactor::handleCompletion(uint64_t userData, int32_t res, uint32_t flags) {
+    int fd = static_cast<int>((userData >> 8) & 0xffffff);
+    uint32_t generation = static_cast<uint32_t>(userData >> 32);
+    bool more = (flags & IORING_CQE_F_MORE) != 0;
+
+    switch (userData & 0xff) {
+        case OP_ACCEPT:
+            if (!more) {
+                acceptArmed_ = false;
+                --inflightOps_;
+            }
+            if (res > MAX_FD) {
+                std::cerr << "[UringReactor] Accepted fd " << res << " exceeds user_data range" << std::endl;
+                close(res);
+            } else if (res >= 0) {
+                uint32_t connectionGeneration = nextGeneration();
+                registerConnection(res, connectionGeneration);
+                if (acceptHandler_) {
+                    acceptHandler_(makeConnectionId(res, connectionGeneration));
+                }
+            } else if (!shuttingDown_ && res != -ECANCELED) {
+                std::cerr << "[UringReactor] Accept failed: " << strerror(-res) << std::endl;
+            }
+            if (!acceptArmed_ && !shuttingDown_) {
+                armAccept();
+            }
+            break;
+        case OP_RECV:
+        case OP_SEND:
+            if (!findConnection(fd, generation)) {
+                // 连接在所有请求完成后才移除，理论上不会出现；防御性地维护计数
+                if ((userData & 0xff) == OP_SEND || !more) {
+                    --inflightOps_;
+                }
+                if (flags & IORING_CQE_F_BUFFER) {
+                    recycleBuffer(static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT));
+                }
+                break;
+            }
+            if ((userData & 0xff) == OP_RECV) {
+                onRecv(fd, res, flags);
+            } else {
+                onSend(fd, res);
+            }
+            break;
+        case OP_WAKE:
+            wakeArmed_ = false;
+            --inflightOps_;
+            if (!shuttingDown_) {
+                armWake();
+            }
+            break;
+        case OP_CANCEL:
+            --inflightOps_;
+            break;
+    }
+}
+
+void UringReactor::registerConnection(int fd, uint32_t generation) {
+    auto inserted = connections_.emplace(fd, Connection());
+    if (!inserted.second) {
+        // fd 不会在关闭前被复用，出现即说明调用方重复添加
+        std::cerr << "[UringReactor] fd " << fd << " already registered" << std::endl;
+        return;
+    }
+    inserted.first->second.generation = generation;
+    armRecv(fd);
+}
+
+UringReactor::Connection* UringReactor::findConnection(int fd, uint32_t generation) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end() || it->second.generation != generation) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+void UringReactor::armAccept() {
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listenFd_;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_CLOEXEC;
+    sqe->user_data = makeUserData(listenFd_, 0, OP_ACCEPT);
+    acceptArmed_ = true;
+    ++inflightOps_;
+}
+
+void UringReactor::armRecv(int fd) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = makeUserData(fd, it->second.generation, OP_RECV);
+    it->second.recvArmed = true;
+    ++it->second.pendingOps;
+    ++inflightOps_;
+}
+
+void UringReactor::armWake() {
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = wakeFd_;
+    sqe->addr = reinterpret_cast<uint64_t>(&wakeValue_);
+    sqe->len = sizeof(wakeValue_);
+    sqe->user_data = makeUserData(wakeFd_, 0, OP_WAKE);
+    wakeArmed_ = true;
+    ++inflightOps_;
+}
+
+void UringReactor::armSend(int fd, Connection& connection) {
+    if (connection.inflight.empty()) {
+        connection.inflight.swap(connection.outgoing);
+        connection.inflightOffset = 0;
+    }
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = reinterpret_cast<uint64_t>(connection.inflight.data() + connection.inflightOffset);
+    sqe->len = static_cast<uint32_t>(connection.inflight.size() - connection.inflightOffset);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = makeUserData(fd, connection.generation, OP_SEND);
+    ++connection.pendingOps;
+    ++inflightOps_;
+}
+
+void UringReactor::recycleBuffer(uint16_t bufferId) {
+    io_uring_buf& buffer = bufferRing_[bufferTail_ & bufferMask_];
+    buffer.addr = reinterpret_cast<uint64_t>(bufferPool_.data() + static_cast<size_t>(bufferId) * BUFFER_SIZE);
+    buffer.len = BUFFER_SIZE;
+    buffer.bid = bufferId;
+    ++bufferTail_;
+    __atomic_store_n(&bufferRing_[0].resv, bufferTail_, __ATOMIC_RELEASE);
+}
+
+void UringReactor::onRecv(int fd, int32_t res, uint32_t flags) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    Connection& connection = it->second;
+    if (!(flags & IORING_CQE_F_MORE)) {
+        connection.recvArmed = false;
+        --connection.pendingOps;
+        --inflightOps_;
+    }
+
+    if (res > 0 && (flags & IORING_CQE_F_BUFFER)) {
+        uint16_t bufferId = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+        const char* data = bufferPool_.data() + static_cast<size_t>(bufferId) * BUFFER_SIZE;
+        size_t size = static_cast<size_t>(res);
+
+        // 没有残留数据时直接在缓冲区上解析，只把不完整的尾部拷出
+        if (!connection.input.empty()) {
+            connection.input.append(data, size);
+            data = connection.input.data();
+            size = connection.input.size();
+        }
+
+        size_t position = 0;
+        bool oversized = false;
+        while (size - position >= sizeof(uint32_t)) {
+            uint32_t frameSize;
+            memcpy(&frameSize, data + position, sizeof(frameSize));
+            frameSize = ntohl(frameSize);
+            if (frameSize > MAX_FRAME_SIZE) {
+                std::cerr << "[UringReactor] Message too large on fd " << fd << ": " << frameSize << std::endl;
+                oversized = true;
+                break;
+            }
+            if (size - position - sizeof(uint32_t) < frameSize) {
+                break;
+            }
+            if (frameHandler_) {
+                try {
+                    frameHandler_(makeConnectionId(fd, connection.generation), data + position + sizeof(uint32_t), frameSize);
+                } catch (const std::exception& e) {
+                    std::cerr << "[UringReactor] Error in frame handler: " << e.what() << std::endl;
+                }
+            }
+            position += sizeof(uint32_t) + frameSize;
+        }
+
+        if (data == connection.input.data()) {
+            connection.input.erase(0, position);
+        } else if (position < size) {
+            connection.input.assign(data + position, size - position);
+        }
+        recycleBuffer(bufferId);
+
+        if (oversized) {
+            beginClose(fd, connection);
+        } else if (!connection.recvArmed && !connection.closing && !shuttingDown_) {
+            armRecv(fd);
+        }
+    } else if (res == -ENOBUFS) {
+        // 缓冲区暂时用尽，处理完已有数据后重新挂载
+        if (!connection.recvArmed && !connection.closing && !shuttingDown_) {
+            armRecv(fd);
+        }
+    } else if (res <= 0) {
+        if (res < 0 && res != -ECANCELED && !connection.closing && !shuttingDown_) {
+            std::cerr << "[UringReactor] Receive error on fd " << fd << ": " << strerror(-res) << std::endl;
+        }
+        beginClose(fd, connection);
+    }
+    finishIfIdle(fd);
+}
+
+void UringReactor::onSend(int fd, int32_t res) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    Connection& connection = it->second;
+    --connection.pendingOps;
+    --inflightOps_;
+
+    if (res < 0) {
+        if (!connection.closing && !shuttingDown_) {
+            std::cerr << "[UringReactor] Send error on fd " << fd << ": " << strerror(-res) << std::endl;
+        }
+        beginClose(fd, connection);
+    } else if (!connection.closing && !shuttingDown_) {
+        connection.inflightOffset += static_cast<size_t>(res);
+        if (connection.inflightOffset >= connection.inflight.size()) {
+            connection.inflight.clear();
+            connection.inflightOffset = 0;
+        }
+        // 部分发送时继续发剩余部分，否则发送期间积累的数据
+        if (!connection.inflight.empty() || !connection.outgoing.empty()) {
+            armSend(fd, connection);
+        }
+    }
+    finishIfIdle(fd);
+}
+
+void UringReactor::drainPending() {
+    std::vector<ConnectionId> adds;
+    std::vector<ConnectionId> closes;
+    std::unordered_map<ConnectionId, std::string> sends;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        wakePending_.store(false);
+        adds.swap(pendingAdds_);
+        closes.swap(pendingCloses_);
+        sends.swap(pendingSends_);
+    }
+
+    for (ConnectionId id : adds) {
+        if (fdOf(id) > MAX_FD) {
+            std::cerr << "[UringReactor] fd " << fdOf(id) << " exceeds user_data range" << std::endl;
+            close(fdOf(id));
+            continue;
+        }
+        registerConnection(fdOf(id), static_cast<uint32_t>(id >> 32));
+    }
+
+    for (auto& entry : sends) {
+        // 代数不符说明原连接已关闭且 fd 被复用，丢弃
+        int fd = fdOf(entry.first);
+        Connection* found = findConnection(fd, static_cast<uint32_t>(entry.first >> 32));
+        if (!found || found->closing) {
+            continue;
+        }
+        Connection& connection = *found;
+        if (connection.outgoing.empty()) {
+            connection.outgoing.swap(entry.second);
+        } else {
+            connection.outgoing.append(entry.second);
+        }
+        if (connection.inflight.empty()) {
+            armSend(fd, connection);
+        }
+    }
+
+    for (ConnectionId id : closes) {
+        int fd = fdOf(id);
+        if (Connection* connection = findConnection(fd, static_cast<uint32_t>(id >> 32))) {
+            beginClose(fd, *connection);
+            finishIfIdle(fd);
+        }
+    }
+}
+
+void UringReactor::beginClose(int fd, Connection& connection) {
+    if (connection.closing) {
+        return;
+    }
+    connection.closing = true;
+    // 唤醒该连接上所有未完成的请求
+    shutdown(fd, SHUT_RDWR);
+}
+
+void UringReactor::finishIfIdle(int fd) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end() || !it->second.closing || it->second.pendingOps > 0) {
+        return;
+    }
+    ConnectionId id = makeConnectionId(fd, it->second.generation);
+    connections_.erase(it);
+
+    // 先通知上层移除映射，再丢弃残留发送并关闭 fd；之后仍持有旧 id 的发送因代数不符被丢弃
+    if (closeHandler_ && !shuttingDown_) {
+        closeHandler_(id);
+    }
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex_);
+        pendingSends_.erase(id);
+    }
+    close(fd);
+}
+
+void UringReactor::beginShutdown() {
+    shuttingDown_ = true;
+
+    // 取消 accept、wake 和所有 recv；连接 shutdown 保证发送也能结束
+    io_uring_sqe* sqe = getSqe();
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+    sqe->user_data = makeUserData(0, 0, OP_CANCEL);
+    ++inflightOps_;
+
+    for (auto& entry : connections_) {
+        shutdown(entry.first, SHUT_RDWR);
+    }
+    if (listenFd_ >= 0) {
+        shutdown(listenFd_, SHUT_RDWR);
+    }
+}
+
+void UringReactor::teardown() {
+    for (auto& entry : connections_) {
+        close(entry.first);
+    }
+    connections_.clear();
+
+    if (wakeFd_ >= 0) {
+        close(wakeFd_);
+        wakeFd_ = -1;
+    }
+    if (ringFd_ >= 0) {
+        close(ringFd_);
+        ringFd_ = -1;
+    }
+    if (sqes_) {
+        munmap(sqes_, sqEntries_ * sizeof(io_uring_sqe));
+        sqes_ = nullptr;
+    }
+    if (cqRing_ && cqRing_ != sqRing_) {
+        munmap(cqRing_, cqRingSize_);
+    }
+    cqRing_ = nullptr;
+    if (sqRing_) {
+        munmap(sqRing_, sqRingSize_);
+        sqRing_ = nullptr;
+    }
+    if (bufferRing_) {
+        munmap(bufferRing_, bufferRingSize_);
+        bufferRing_ = nullptr;
+    }
+}
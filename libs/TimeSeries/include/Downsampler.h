@@ -0,0 +1,30 @@
+// Downsampler.h
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 服务端降采样：把一条曲线压缩到页面能绘制的点数
+//   - LTTB（Largest-Triangle-Three-Buckets）：保留首尾点，中间每个桶选出与前一个已选点、下一桶均值构成三角形面积最大的点，
+//     视觉形状最接近原曲线
+//   - min/max 抽取：每个桶输出最小值点和最大值点（按时间先后），保证尖峰不被抹平
+// 输入需按时间排序；输入点数不超过 threshold 时原样输出
+class Downsampler {
+public:
+    struct Point {
+        int64_t timestampMs;
+        double value;
+    };
+
+    // 已经汇总过的输入（例如 RollupEngine 的桶）带有自己的 min/max；原始样本的 min == max
+    struct Envelope {
+        int64_t timestampMs;
+        double min;
+        double max;
+    };
+
+    // threshold < 3 时只输出首尾点
+    static void lttb(const Point* input, size_t count, size_t threshold, std::vector<Point>& out);
+    // 输出最多 threshold 个点（threshold / 2 个桶）
+    static void minMax(const Envelope* input, size_t count, size_t threshold, std::vector<Point>& out);
+};
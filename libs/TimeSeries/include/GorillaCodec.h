@@ -0,0 +1,103 @@
+// GorillaCodec.h
+#pragma once
+#include "TimeSeriesSample.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Gorilla 风格的时间序列压缩（Pelkonen et al., VLDB 2015）：
+//   - 时间戳：首个原样 64 位，之后写二阶差分（delta-of-delta），等间隔采样时每个样本只占 1 位
+//   - 浮点数：与前一个值按位异或，相同为 1 位；否则只写异或结果中有效位的区间，
+//     区间落在上一次的前导零/尾随零范围内时复用，不再写区间长度
+// 位流按 64 位字存储，字内从高位到低位写入
+
+class BitWriter {
+public:
+    // 写入 value 的低 bits 位（1 ~ 64）
+    void write(uint64_t value, unsigned bits);
+    void writeBit(bool bit) { write(bit ? 1 : 0, 1); }
+
+    const std::vector<uint64_t>& words() const { return words_; }
+    size_t bitCount() const { return words_.size() * 64 - (used_ ? 64 - used_ : 0); }
+    void clear();
+
+private:
+    std::vector<uint64_t> words_;
+    unsigned used_ = 0;  // 最后一个字中已写入的位数，0 表示已写满（或为空）
+};
+
+class BitReader {
+public:
+    BitReader() : words_(nullptr), wordCount_(0) {}
+    BitReader(const uint64_t* words, size_t wordCount) : words_(words), wordCount_(wordCount) {}
+
+    // 读取 bits 位（1 ~ 64）；越界时返回 0 并置位 overrun
+    uint64_t read(unsigned bits);
+    bool readBit() { return read(1) != 0; }
+    bool overrun() const { return overrun_; }
+
+private:
+    const uint64_t* words_;
+    size_t wordCount_;
+    size_t index_ = 0;
+    unsigned position_ = 0;  // 当前字中已读取的位数
+    bool overrun_ = false;
+};
+
+// 一个数据块的列式编码：时间戳和每个指标各占一列，可以只解码需要的列
+class ChunkEncoder {
+public:
+    static constexpr size_t COLUMN_COUNT = 1 + TimeSeriesSample::METRIC_COUNT;
+
+    void add(const TimeSeriesSample& sample);
+    void clear();
+
+    size_t count() const { return count_; }
+    int64_t minTime() const { return minTime_; }
+    int64_t maxTime() const { return maxTime_; }
+    const std::vector<uint64_t>& column(size_t index) const { return columns_[index].words(); }
+
+private:
+    struct ValueState {
+        uint64_t previous = 0;
+        unsigned leading = 0;
+        unsigned trailing = 0;
+        bool hasWindow = false;
+    };
+
+    void encodeValue(BitWriter& writer, ValueState& state, double value);
+
+    BitWriter columns_[COLUMN_COUNT];
+    ValueState values_[TimeSeriesSample::METRIC_COUNT];
+    size_t count_ = 0;
+    int64_t previousTime_ = 0;
+    int64_t previousDelta_ = 0;
+    int64_t minTime_ = 0;
+    int64_t maxTime_ = 0;
+};
+
+// 解码 ChunkEncoder 写出的各列；columns[i] 指向第 i 列的字，长度为 wordCounts[i]
+class ChunkDecoder {
+public:
+    ChunkDecoder(const uint64_t* const* columns, const size_t* wordCounts, size_t count);
+
+    // 依次输出样本，全部读完或数据损坏时返回 false
+    bool next(TimeSeriesSample& sample);
+
+private:
+    struct ValueState {
+        uint64_t previous = 0;
+        unsigned leading = 0;
+        unsigned trailing = 0;
+    };
+
+    double decodeValue(BitReader& reader, ValueState& state);
+
+    BitReader timestamps_;
+    BitReader values_[TimeSeriesSample::METRIC_COUNT];
+    ValueState valueStates_[TimeSeriesSample::METRIC_COUNT];
+    size_t remaining_;
+    size_t decoded_ = 0;
+    int64_t previousTime_ = 0;
+    int64_t previousDelta_ = 0;
+};
@@ -0,0 +1,141 @@
+// RollupEngine.h
+#pragma once
+#include "TimeSeriesSample.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 多分辨率增量汇总：每个传感器按若干分辨率（缺省 1 s / 1 min / 1 h）维护 min/max/avg/count 桶
+//   - 样本只写入最细一级的当前桶；一个桶关闭时并入上一级的当前桶，粗粒度桶由细粒度桶合并而来，不回扫样本
+//   - 每级保留最近 retention 个非空桶（环形缓冲区，按需增长），没有数据的时间段不占空间
+//   - 乱序样本：所属桶仍在某一级保留范围内时就地更新（或插入）该桶及其上各级，否则在该级丢弃
+//   - 查询时选择覆盖时间范围且点数不超过上限的最细分辨率，一周的历史通常只需几百个桶
+class RollupEngine {
+public:
+    enum Metric : size_t {
+        TEMPERATURE = 0,
+        HUMIDITY,
+        PRESSURE,
+        METRIC_COUNT
+    };
+
+    using Sample = TimeSeriesSample;
+    static_assert(METRIC_COUNT == TimeSeriesSample::METRIC_COUNT, "Metric must match TimeSeriesSample");
+
+    struct Stats {
+        double min = 0;
+        double max = 0;
+        double sum = 0;
+    };
+
+    struct Bucket {
+        int64_t startMs = 0;
+        uint64_t count = 0;
+        std::array<Stats, METRIC_COUNT> metrics{};
+
+        void add(const Sample& sample);
+        void merge(const Bucket& other);
+        double avg(Metric metric) const { return count ? metrics[metric].sum / static_cast<double>(count) : 0; }
+    };
+
+    struct Resolution {
+        int64_t widthMs;
+        size_t retention;  // 保留的桶数
+    };
+
+    struct Options {
+        // 每级宽度必须是上一级的整数倍
+        // 缺省保留 15 分钟秒级、1 天分钟级、31 天小时级数据，每个传感器最多约 270 KB
+        std::vector<Resolution> resolutions = {{1000, 900}, {60000, 1440}, {3600000, 24 * 31}};
+        size_t maxSensors = 1000;  // 超出后新传感器的样本被忽略
+    };
+
+    struct Counters {
+        uint64_t samples = 0;
+        uint64_t late = 0;     // 乱序但仍被接受
+        uint64_t dropped = 0;  // 超出所有级别保留范围或传感器数超限
+    };
+
+    explicit RollupEngine(const Options& options);
+
+    // 非法配置（宽度不是上一级的整数倍等）时返回 false 并使用缺省分辨率
+    static bool validate(const Options& options, std::string& error);
+
+    void add(const std::string& sensorId, const Sample& sample);
+    void add(const std::string& sensorId, const Sample* samples, size_t count);
+
+    // 按时间顺序输出 [fromMs, toMs) 内的桶（含未关闭的当前桶），返回所用分辨率的序号；传感器不存在时返回 -1
+    int query(const std::string& sensorId, int64_t fromMs, int64_t toMs, size_t maxPoints,
+              std::vector<Bucket>& out) const;
+    // 指定分辨率查询
+    void queryLevel(const std::string& sensorId, size_t level, int64_t fromMs, int64_t toMs, std::vector<Bucket>& out) const;
+
+    const std::vector<Resolution>& resolutions() const { return options_.resolutions; }
+    std::vector<std::string> sensors() const;
+    Counters counters() const;
+
+private:
+    class Level {
+    public:
+        Level(int64_t widthMs, size_t retention) : widthMs_(widthMs), retention_(retention), head_(0), evicted_(false) {}
+
+        int64_t widthMs() const { return widthMs_; }
+        int64_t bucketStart(int64_t timestampMs) const;
+        bool hasCurrent() const { return current_.count > 0; }
+        const Bucket& current() const { return current_; }
+        Bucket& current() { return current_; }
+        // 关闭当前桶并写入环形缓冲区
+        void close();
+        // 已关闭桶中起始时间为 startMs 的桶；不在保留范围内时返回 nullptr
+        Bucket* find(int64_t startMs);
+        // 按时间顺序插入一个空的已关闭桶（乱序样本所属的桶从未出现过时）；早于保留范围时返回 nullptr
+        Bucket* insert(int64_t startMs);
+        // 最旧的保留桶起始时间；没有已关闭桶时返回当前桶的起始时间
+        int64_t oldestStart() const;
+        // 是否淘汰过桶；未淘汰时保留着全部历史
+        bool evicted() const { return evicted_; }
+        void collect(int64_t fromMs, int64_t toMs, std::vector<Bucket>& out) const;
+
+    private:
+        Bucket& push();
+        const Bucket& at(size_t index) const { return ring_[(head_ + index) % ring_.size()]; }
+        Bucket& at(size_t index) { return ring_[(head_ + index) % ring_.size()]; }
+        // 前 count 个已关闭桶中第一个结束时间晚于 timestampMs 的逻辑下标
+        size_t lowerBound(int64_t timestampMs, size_t count) const;
+
+        int64_t widthMs_;
+        size_t retention_;
+        std::vector<Bucket> ring_;  // 按起始时间递增，满后覆盖最旧的桶
+        size_t head_;
+        bool evicted_;
+        Bucket current_;
+    };
+
+    struct Series {
+        std::vector<Level> levels;
+    };
+
+    void addLocked(Series& series, const Sample& sample);
+    // 写入某一级的数据：一个样本或细一级关闭的桶
+    struct Update {
+        int64_t timestampMs;
+        const Sample* sample;
+        const Bucket* bucket;
+
+        void applyTo(Bucket& target) const;
+    };
+
+    // 把 update 合并进第 level 级，需要时关闭当前桶并逐级向上合并；任一级接受时返回 true
+    bool absorb(Series& series, size_t level, const Update& update);
+    Series* seriesFor(const std::string& sensorId);
+    void collectLocked(const Series& series, size_t level, int64_t fromMs, int64_t toMs, std::vector<Bucket>& out) const;
+
+    Options options_;
+    std::unordered_map<std::string, std::unique_ptr<Series>> series_;
+    Counters counters_;
+    mutable std::mutex mutex_;
+};
@@ -0,0 +1,13 @@
+// TimeSeriesSample.h
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// TimeSeries 库中各组件共用的样本：时间戳加温度、湿度、气压三个指标
+struct TimeSeriesSample {
+    static constexpr size_t METRIC_COUNT = 3;
+
+    int64_t timestampMs = 0;
+    std::array<double, METRIC_COUNT> values{};
+};
@@ -0,0 +1,131 @@
+// TimeSeriesStore.h
+#pragma once
+#include "GorillaCodec.h"
+#include "TimeSeriesSample.h"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// 嵌入式时间序列存储：按传感器分块的列式压缩 + 追加写 mmap 段文件 + 内存时间索引
+//
+//   - 每个传感器有一个内存中的开放块，样本以 Gorilla 编码追加（等间隔、缓变的数据每个样本约 2 ~ 4 字节）；
+//     达到 chunk_samples 个样本或开放超过 max_chunk_age_ms 后封存，整块写入当前段
+//   - 段文件布局（本机字节序，8 字节对齐）：
+//       [chunk][chunk]...[0 填充]
+//       chunk = ChunkHeader + sensor_id（补齐到 8 字节）+ 时间戳列 + 温度列 + 湿度列 + 气压列
+//     段写满后新建下一个段，超过 max_segments 时删除最旧的段
+//   - 打开时顺序扫描段文件重建索引；最后一个段逐块校验 CRC，截掉写入中断留下的残块
+//   - 时间索引：每个传感器的块按最小时间戳排序，并记录前缀最大时间戳，范围查询二分定位
+//   - 查询在锁内只复制块引用，解码在锁外进行；段以 shared_ptr 持有，被淘汰的段在查询结束后才解除映射
+// 开放块只在内存中，进程异常退出时丢失（最多 max_chunk_age_ms 的数据）；close() 会封存所有开放块
+class TimeSeriesStore {
+public:
+    struct Options {
+        std::string directory = "tsdb";
+        size_t segmentSize = 64 * 1024 * 1024;  // 每个段文件的固定大小
+        size_t maxSegments = 64;                // 保留的最大段数量
+        size_t chunkSamples = 1024;
+        std::chrono::milliseconds maxChunkAge{60000};
+    };
+
+    struct Stats {
+        size_t sensors = 0;
+        size_t segments = 0;
+        uint64_t chunks = 0;
+        uint64_t samples = 0;      // 已封存和开放块中的样本
+        uint64_t storedBytes = 0;  // 已封存块占用的段空间
+        uint64_t sealedSamples = 0;
+    };
+
+    explicit TimeSeriesStore(const Options& options);
+    ~TimeSeriesStore();
+
+    TimeSeriesStore(const TimeSeriesStore&) = delete;
+    TimeSeriesStore& operator=(const TimeSeriesStore&) = delete;
+
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    bool append(const std::string& sensorId, const TimeSeriesSample& sample);
+    bool append(const std::string& sensorId, const TimeSeriesSample* samples, size_t count);
+    // 封存所有开放块并异步刷盘
+    void flush();
+
+    // 把 [fromMs, toMs) 内的样本按时间顺序追加到 out，最多 maxSamples 个（0 为不限），返回追加的个数
+    size_t scan(const std::string& sensorId, int64_t fromMs, int64_t toMs, std::vector<TimeSeriesSample>& out,
+                size_t maxSamples = 0) const;
+
+    // 与 [fromMs, toMs) 相交的块中的样本总数，不解码；是 scan 结果数的上界，用于在查询前估算代价
+    size_t estimate(const std::string& sensorId, int64_t fromMs, int64_t toMs) const;
+
+    std::vector<std::string> sensors() const;
+    Stats stats() const;
+
+private:
+    struct ChunkHeader {
+        uint32_t length;    // 整个块的字节数（含头），0 表示段内数据结束
+        uint32_t checksum;  // 头之后全部字节的 CRC32
+        uint32_t count;
+        uint16_t idLength;
+        uint16_t reserved;
+        int64_t minTime;
+        int64_t maxTime;
+        uint32_t columnWords[ChunkEncoder::COLUMN_COUNT];
+    };
+    static_assert(sizeof(ChunkHeader) % 8 == 0, "chunk columns must stay 8-byte aligned");
+
+    struct Segment {
+        ~Segment();
+
+        uint64_t sequence = 0;
+        std::string path;
+        int fd = -1;
+        char* data = nullptr;
+        size_t size = 0;
+        size_t writePos = 0;
+    };
+    using SegmentPtr = std::shared_ptr<Segment>;
+
+    struct ChunkRef {
+        SegmentPtr segment;
+        uint32_t position;
+        uint32_t count;
+        int64_t minTime;
+        int64_t maxTime;
+        int64_t prefixMaxTime;  // 索引中该块及之前所有块的最大时间戳，单调不减
+    };
+
+    struct Series {
+        std::deque<ChunkRef> chunks;  // 按 minTime 排序
+        ChunkEncoder open;
+        std::chrono::steady_clock::time_point openedAt;
+    };
+
+    SegmentPtr createSegment(uint64_t sequence);
+    SegmentPtr openSegment(const std::string& path, uint64_t sequence);
+    // 扫描段内的块并加入索引；verify 时校验 CRC，遇到无效块即停止
+    void recoverSegment(const SegmentPtr& segment, bool verify);
+    void indexChunk(const std::string& sensorId, const ChunkRef& chunk);
+    bool seal(const std::string& sensorId, Series& series);
+    void enforceRetention();
+    std::string segmentPath(uint64_t sequence) const;
+    // 解码一个块中 [fromMs, toMs) 内的样本
+    static void decode(const uint64_t* const* columns, const size_t* wordCounts, size_t count,
+                       int64_t fromMs, int64_t toMs, std::vector<TimeSeriesSample>& out);
+    static void decodeRecord(const char* record, int64_t fromMs, int64_t toMs, std::vector<TimeSeriesSample>& out);
+
+
+    Options options_;
+    std::vector<SegmentPtr> segments_;
+    std::unordered_map<std::string, Series> series_;
+    uint64_t chunkCount_;
+    uint64_t sealedSamples_;
+    uint64_t storedBytes_;
+    mutable std::mutex mutex_;
+};
@@ -0,0 +1,110 @@
+// Downsampler.cpp
+#include "Downsampler.h"
+#include <cmath>
+
+void Downsampler::lttb(const Point* input, size_t count, size_t threshold, std::vector<Point>& out) {
+    out.clear();
+    if (count <= threshold || count <= 2) {
+        out.assign(input, input + count);
+        return;
+    }
+    if (threshold < 3) {
+        out.push_back(input[0]);
+        if (threshold == 2) {
+            out.push_back(input[count - 1]);
+        }
+        return;
+    }
+
+    out.reserve(threshold);
+    out.push_back(input[0]);
+
+    // 首尾点之外的 count - 2 个点分成 threshold - 2 个桶
+    const double every = static_cast<double>(count - 2) / static_cast<double>(threshold - 2);
+    size_t selected = 0;
+    for (size_t bucket = 0; bucket < threshold - 2; ++bucket) {
+        size_t start = static_cast<size_t>(std::floor(bucket * every)) + 1;
+        size_t end = static_cast<size_t>(std::floor((bucket + 1) * every)) + 1;
+
+        // 下一个桶的均值作为三角形的第三个顶点；最后一个桶用尾点
+        size_t nextStart = end;
+        size_t nextEnd = bucket + 2 < threshold - 1 ? static_cast<size_t>(std::floor((bucket + 2) * every)) + 1 : count;
+        if (nextEnd > count) {
+            nextEnd = count;
+        }
+        double avgTime = 0;
+        double avgValue = 0;
+        for (size_t i = nextStart; i < nextEnd; ++i) {
+            avgTime += static_cast<double>(input[i].timestampMs - input[selected].timestampMs);
+            avgValue += input[i].value;
+        }
+        size_t nextCount = nextEnd - nextStart;
+        avgTime /= static_cast<double>(nextCount);
+        avgValue /= static_cast<double>(nextCount);
+
+        // 时间以已选点为原点，避免大时间戳相乘丢失精度
+        const Point& anchor = input[selected];
+        double maxArea = -1;
+        size_t best = start;
+        for (size_t i = start; i < end; ++i) {
+            double dt = static_cast<double>(input[i].timestampMs - anchor.timestampMs);
+            double area = std::fabs(dt * (avgValue - anchor.value) - avgTime * (input[i].value - anchor.value));
+            if (area > maxArea) {
+                maxArea = area;
+                best = i;
+            }
+        }
+        out.push_back(input[best]);
+        selected = best;
+    }
+
+    out.push_back(input[count - 1]);
+}
+
+void Downsampler::minMax(const Envelope* input, size_t count, size_t threshold, std::vector<Point>& out) {
+    out.clear();
+    size_t buckets = threshold / 2;
+    if (buckets == 0) {
+        if (count > 0 && threshold > 0) {
+            out.push_back({input[0].timestampMs, input[0].min});
+        }
+        return;
+    }
+    if (count <= buckets) {
+        // 每个输入最多展开成两个点
+        for (size_t i = 0; i < count; ++i) {
+            out.push_back({input[i].timestampMs, input[i].min});
+            if (input[i].max != input[i].min) {
+                out.push_back({input[i].timestampMs, input[i].max});
+            }
+        }
+        return;
+    }
+
+    out.reserve(buckets * 2);
+    for (size_t bucket = 0; bucket < buckets; ++bucket) {
+        size_t start = bucket * count / buckets;
+        size_t end = (bucket + 1) * count / buckets;
+        size_t low = start;
+        size_t high = start;
+        for (size_t i = start + 1; i < end; ++i) {
+            if (input[i].min < input[low].min) {
+                low = i;
+            }
+            if (input[i].max > input[high].max) {
+                high = i;
+            }
+        }
+        const Point lowPoint{input[low].timestampMs, input[low].min};
+        const Point highPoint{input[high].timestampMs, input[high].max};
+        if (low == high && input[low].min == input[low].max) {
+            out.push_back(lowPoint);
+        } else if (low <= high) {
+            out.push_back(lowPoint);
+            out.push_back(highPoint);
+        } else {
+            out.push_back(highPoint);
+            out.push_back(lowPoint);
+        }
+    }
+}
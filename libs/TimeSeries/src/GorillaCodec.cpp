@@ -0,0 +1,246 @@
+// GorillaCodec.cpp
+#include "GorillaCodec.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// 有符号差值映射为无符号，绝对值小的差值编码后也小
+uint64_t zigzag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t unzigzag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+uint64_t toBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double fromBits(uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// 二阶差分的变长前缀：'0' 为 0，其余按 zigzag 后的位数分档
+struct DodClass {
+    unsigned prefix;      // 前缀的值
+    unsigned prefixBits;  // 前缀的位数
+    unsigned valueBits;
+};
+
+constexpr DodClass DOD_CLASSES[] = {
+    {0b10, 2, 7},
+    {0b110, 3, 9},
+    {0b1110, 4, 12},
+    {0b11110, 5, 32},
+    {0b11111, 5, 64},
+};
+
+} // namespace
+
+void BitWriter::write(uint64_t value, unsigned bits) {
+    if (bits < 64) {
+        value &= (uint64_t(1) << bits) - 1;
+    }
+    if (used_ == 0) {
+        words_.push_back(0);
+    }
+    unsigned available = 64 - used_;
+    if (bits <= available) {
+        words_.back() |= value << (available - bits);
+        used_ = (used_ + bits) & 63;
+    } else {
+        // 跨字：高位填满当前字，剩余低位写入新字
+        unsigned overflow = bits - available;
+        words_.back() |= value >> overflow;
+        words_.push_back(value << (64 - overflow));
+        used_ = overflow;
+    }
+}
+
+void BitWriter::clear() {
+    words_.clear();
+    used_ = 0;
+}
+
+uint64_t BitReader::read(unsigned bits) {
+    if (bits == 0) {
+        return 0;
+    }
+    if (index_ >= wordCount_) {
+        overrun_ = true;
+        return 0;
+    }
+    unsigned available = 64 - position_;
+    uint64_t word = words_[index_] << position_;
+    if (bits <= available) {
+        position_ += bits;
+        if (position_ == 64) {
+            position_ = 0;
+            ++index_;
+        }
+        return word >> (64 - bits);
+    }
+
+    uint64_t high = word >> position_;  // 当前字剩余的 available 位
+    unsigned overflow = bits - available;
+    if (++index_ >= wordCount_) {
+        overrun_ = true;
+        return 0;
+    }
+    position_ = overflow;
+    return (high << overflow) | (words_[index_] >> (64 - overflow));
+}
+
+void ChunkEncoder::add(const TimeSeriesSample& sample) {
+    BitWriter& timestamps = columns_[0];
+    if (count_ == 0) {
+        timestamps.write(static_cast<uint64_t>(sample.timestampMs), 64);
+        previousDelta_ = 0;
+        minTime_ = maxTime_ = sample.timestampMs;
+    } else {
+        // 无符号运算，极端时间戳下也不会有符号溢出
+        int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(sample.timestampMs) - static_cast<uint64_t>(previousTime_));
+        int64_t dod = static_cast<int64_t>(static_cast<uint64_t>(delta) - static_cast<uint64_t>(previousDelta_));
+        if (dod == 0) {
+            timestamps.writeBit(false);
+        } else {
+            uint64_t encoded = zigzag(dod);
+            for (const DodClass& dodClass : DOD_CLASSES) {
+                if (dodClass.valueBits == 64 || encoded < (uint64_t(1) << dodClass.valueBits)) {
+                    timestamps.write(dodClass.prefix, dodClass.prefixBits);
+                    timestamps.write(encoded, dodClass.valueBits);
+                    break;
+                }
+            }
+        }
+        previousDelta_ = delta;
+        minTime_ = std::min(minTime_, sample.timestampMs);
+        maxTime_ = std::max(maxTime_, sample.timestampMs);
+    }
+    previousTime_ = sample.timestampMs;
+
+    for (size_t m = 0; m < TimeSeriesSample::METRIC_COUNT; ++m) {
+        encodeValue(columns_[1 + m], values_[m], sample.values[m]);
+    }
+    ++count_;
+}
+
+void ChunkEncoder::encodeValue(BitWriter& writer, ValueState& state, double value) {
+    uint64_t bits = toBits(value);
+    if (count_ == 0) {
+        writer.write(bits, 64);
+        state = ValueState();
+        state.previous = bits;
+        return;
+    }
+
+    uint64_t xored = bits ^ state.previous;
+    state.previous = bits;
+    if (xored == 0) {
+        writer.writeBit(false);
+        return;
+    }
+    writer.writeBit(true);
+
+    // 前导零最多记 31（5 位），有效位数 1 ~ 64（6 位，64 记为 0）
+    unsigned leading = std::min(static_cast<unsigned>(__builtin_clzll(xored)), 31u);
+    unsigned trailing = static_cast<unsigned>(__builtin_ctzll(xored));
+    if (state.hasWindow && leading >= state.leading && trailing >= state.trailing) {
+        writer.writeBit(false);
+        writer.write(xored >> state.trailing, 64 - state.leading - state.trailing);
+        return;
+    }
+    unsigned significant = 64 - leading - trailing;
+    writer.writeBit(true);
+    writer.write(leading, 5);
+    writer.write(significant & 63, 6);
+    writer.write(xored >> trailing, significant);
+    state.leading = leading;
+    state.trailing = trailing;
+    state.hasWindow = true;
+}
+
+void ChunkEncoder::clear() {
+    for (BitWriter& column : columns_) {
+        column.clear();
+    }
+    count_ = 0;
+}
+
+ChunkDecoder::ChunkDecoder(const uint64_t* const* columns, const size_t* wordCounts, size_t count)
+    : timestamps_(columns[0], wordCounts[0]), remaining_(count) {
+    for (size_t m = 0; m < TimeSeriesSample::METRIC_COUNT; ++m) {
+        values_[m] = BitReader(columns[1 + m], wordCounts[1 + m]);
+    }
+}
+
+bool ChunkDecoder::next(TimeSeriesSample& sample) {
+    if (remaining_ == 0) {
+        return false;
+    }
+
+    if (decoded_ == 0) {
+        sample.timestampMs = static_cast<int64_t>(timestamps_.read(64));
+        previousDelta_ = 0;
+    } else {
+        int64_t dod = 0;
+        if (timestamps_.readBit()) {
+            // 前缀中连续的 1 的个数决定分档
+            size_t index = 0;
+            while (index + 1 < sizeof(DOD_CLASSES) / sizeof(DOD_CLASSES[0]) && timestamps_.readBit()) {
+                ++index;
+            }
+            dod = unzigzag(timestamps_.read(DOD_CLASSES[index].valueBits));
+        }
+        int64_t delta = static_cast<int64_t>(static_cast<uint64_t>(previousDelta_) + static_cast<uint64_t>(dod));
+        sample.timestampMs = static_cast<int64_t>(static_cast<uint64_t>(previousTime_) + static_cast<uint64_t>(delta));
+        previousDelta_ = delta;
+    }
+    previousTime_ = sample.timestampMs;
+
+    for (size_t m = 0; m < TimeSeriesSample::METRIC_COUNT; ++m) {
+        sample.values[m] = decodeValue(values_[m], valueStates_[m]);
+    }
+
+    bool overrun = timestamps_.overrun();
+    for (const BitReader& reader : values_) {
+        overrun = overrun || reader.overrun();
+    }
+    if (overrun) {
+        remaining_ = 0;
+        return false;
+    }
+    ++decoded_;
+    --remaining_;
+    return true;
+}
+
+double ChunkDecoder::decodeValue(BitReader& reader, ValueState& state) {
+    if (decoded_ == 0) {
+        state.previous = reader.read(64);
+        return fromBits(state.previous);
+    }
+    if (reader.readBit()) {
+        if (reader.readBit()) {
+            state.leading = static_cast<unsigned>(reader.read(5));
+            unsigned significant = static_cast<unsigned>(reader.read(6));
+            if (significant == 0) {
+                significant = 64;
+            }
+            // 损坏的数据可能给出不可能的区间
+            if (state.leading + significant > 64) {
+                state.leading = 64 - significant;
+            }
+            state.trailing = 64 - state.leading - significant;
+        }
+        unsigned significant = 64 - state.leading - state.trailing;
+        state.previous ^= reader.read(significant) << state.trailing;
+    }
+    return fromBits(state.previous);
+}
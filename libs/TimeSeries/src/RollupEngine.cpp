@@ -0,0 +1,297 @@
+// RollupEngine.cpp
+#include "RollupEngine.h"
+#include <algorithm>
+#include <iostream>
+
+void RollupEngine::Bucket::add(const Sample& sample) {
+    for (size_t m = 0; m < METRIC_COUNT; ++m) {
+        double value = sample.values[m];
+        Stats& stats = metrics[m];
+        stats.min = count == 0 ? value : std::min(stats.min, value);
+        stats.max = count == 0 ? value : std::max(stats.max, value);
+        stats.sum += value;
+    }
+    ++count;
+}
+
+void RollupEngine::Bucket::merge(const Bucket& other) {
+    if (other.count == 0) {
+        return;
+    }
+    for (size_t m = 0; m < METRIC_COUNT; ++m) {
+        Stats& stats = metrics[m];
+        const Stats& source = other.metrics[m];
+        stats.min = count == 0 ? source.min : std::min(stats.min, source.min);
+        stats.max = count == 0 ? source.max : std::max(stats.max, source.max);
+        stats.sum += source.sum;
+    }
+    count += other.count;
+}
+
+int64_t RollupEngine::Level::bucketStart(int64_t timestampMs) const {
+    int64_t quotient = timestampMs / widthMs_;
+    if (timestampMs % widthMs_ != 0 && timestampMs < 0) {
+        --quotient;
+    }
+    return quotient * widthMs_;
+}
+
+RollupEngine::Bucket& RollupEngine::Level::push() {
+    if (ring_.size() < retention_) {
+        ring_.emplace_back();
+        return ring_.back();
+    }
+    // 已满：覆盖最旧的桶
+    Bucket& slot = ring_[head_];
+    head_ = (head_ + 1) % ring_.size();
+    evicted_ = true;
+    return slot;
+}
+
+void RollupEngine::Level::close() {
+    push() = current_;
+    current_ = Bucket();
+}
+
+RollupEngine::Bucket* RollupEngine::Level::insert(int64_t startMs) {
+    if (evicted_ && startMs < at(0).startMs) {
+        return nullptr;
+    }
+    // 先占用末尾一个位置（满时淘汰最旧的桶），再把插入点之后的桶后移；乱序样本少见，移动代价可以接受
+    push();
+    size_t last = ring_.size() - 1;
+    size_t position = lowerBound(startMs, last);
+    for (size_t i = last; i > position; --i) {
+        at(i) = at(i - 1);
+    }
+    Bucket& bucket = at(position);
+    bucket = Bucket();
+    bucket.startMs = startMs;
+    return &bucket;
+}
+
+size_t RollupEngine::Level::lowerBound(int64_t timestampMs, size_t count) const {
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        if (at(middle).startMs + widthMs_ <= timestampMs) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+RollupEngine::Bucket* RollupEngine::Level::find(int64_t startMs) {
+    size_t index = lowerBound(startMs, ring_.size());
+    if (index < ring_.size() && at(index).startMs == startMs) {
+        return &at(index);
+    }
+    return nullptr;
+}
+
+int64_t RollupEngine::Level::oldestStart() const {
+    return ring_.empty() ? current_.startMs : at(0).startMs;
+}
+
+void RollupEngine::Level::collect(int64_t fromMs, int64_t toMs, std::vector<Bucket>& out) const {
+    for (size_t i = lowerBound(fromMs, ring_.size()); i < ring_.size() && at(i).startMs < toMs; ++i) {
+        out.push_back(at(i));
+    }
+}
+
+RollupEngine::RollupEngine(const Options& options) : options_(options) {
+    std::string error;
+    if (!validate(options_, error)) {
+        std::cerr << "[RollupEngine] " << error << ", using default resolutions" << std::endl;
+        options_.resolutions = Options().resolutions;
+    }
+}
+
+bool RollupEngine::validate(const Options& options, std::string& error) {
+    if (options.resolutions.empty()) {
+        error = "no resolutions";
+        return false;
+    }
+    for (size_t i = 0; i < options.resolutions.size(); ++i) {
+        const Resolution& resolution = options.resolutions[i];
+        if (resolution.widthMs <= 0 || resolution.retention == 0) {
+            error = "resolution " + std::to_string(i) + " needs positive width and retention";
+            return false;
+        }
+        if (i > 0 && (resolution.widthMs <= options.resolutions[i - 1].widthMs ||
+                      resolution.widthMs % options.resolutions[i - 1].widthMs != 0)) {
+            error = "resolution " + std::to_string(i) + " width must be a multiple of the previous one";
+            return false;
+        }
+    }
+    return true;
+}
+
+RollupEngine::Series* RollupEngine::seriesFor(const std::string& sensorId) {
+    auto it = series_.find(sensorId);
+    if (it != series_.end()) {
+        return it->second.get();
+    }
+    if (series_.size() >= options_.maxSensors) {
+        return nullptr;
+    }
+    auto series = std::make_unique<Series>();
+    for (const Resolution& resolution : options_.resolutions) {
+        series->levels.emplace_back(resolution.widthMs, resolution.retention);
+    }
+    return series_.emplace(sensorId, std::move(series)).first->second.get();
+}
+
+void RollupEngine::add(const std::string& sensorId, const Sample& sample) {
+    add(sensorId, &sample, 1);
+}
+
+void RollupEngine::add(const std::string& sensorId, const Sample* samples, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Series* series = seriesFor(sensorId);
+    if (!series) {
+        counters_.dropped += count;
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) {
+        addLocked(*series, samples[i]);
+    }
+}
+
+void RollupEngine::addLocked(Series& series, const Sample& sample) {
+    const Level& finest = series.levels.front();
+    bool late = finest.hasCurrent() && finest.bucketStart(sample.timestampMs) < finest.current().startMs;
+    bool accepted = absorb(series, 0, Update{sample.timestampMs, &sample, nullptr});
+    ++counters_.samples;
+    if (!accepted) {
+        ++counters_.dropped;
+    } else if (late) {
+        ++counters_.late;
+    }
+}
+
+void RollupEngine::Update::applyTo(Bucket& target) const {
+    if (sample) {
+        target.add(*sample);
+    } else {
+        target.merge(*bucket);
+    }
+}
+
+bool RollupEngine::absorb(Series& series, size_t level, const Update& update) {
+    Level& target = series.levels[level];
+    bool hasCoarser = level + 1 < series.levels.size();
+    int64_t start = target.bucketStart(update.timestampMs);
+
+    if (!target.hasCurrent() || start > target.current().startMs) {
+        if (target.hasCurrent()) {
+            // 新桶开始：旧桶关闭并并入上一级
+            Bucket closed = target.current();
+            target.close();
+            if (hasCoarser) {
+                absorb(series, level + 1, Update{closed.startMs, nullptr, &closed});
+            }
+        }
+        target.current().startMs = start;
+        update.applyTo(target.current());
+        return true;
+    }
+    if (start == target.current().startMs) {
+        // 当前桶关闭时才会并入上一级
+        update.applyTo(target.current());
+        return true;
+    }
+
+    // 乱序：更新本级已关闭的桶；上一级已经包含本级所有已关闭的桶，需要同步更新
+    bool accepted = false;
+    if (Bucket* bucket = target.find(start)) {
+        update.applyTo(*bucket);
+        accepted = true;
+    } else if (Bucket* inserted = target.insert(start)) {
+        update.applyTo(*inserted);
+        accepted = true;
+    }
+    if (hasCoarser) {
+        accepted = absorb(series, level + 1, update) || accepted;
+    }
+    return accepted;
+}
+
+int RollupEngine::query(const std::string& sensorId, int64_t fromMs, int64_t toMs, size_t maxPoints,
+                        std::vector<Bucket>& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = series_.find(sensorId);
+    if (it == series_.end()) {
+        return -1;
+    }
+    const Series& series = *it->second;
+
+    // 最细的、保留范围覆盖 fromMs 且点数不超过上限的分辨率；都不满足时用最粗的一级
+    size_t chosen = series.levels.size() - 1;
+    for (size_t i = 0; i < series.levels.size(); ++i) {
+        const Level& level = series.levels[i];
+        bool covered = !level.evicted() || level.oldestStart() <= fromMs;
+        int64_t points = (toMs - fromMs + level.widthMs() - 1) / level.widthMs();
+        if (covered && (maxPoints == 0 || points <= static_cast<int64_t>(maxPoints))) {
+            chosen = i;
+            break;
+        }
+    }
+    out.clear();
+    collectLocked(series, chosen, fromMs, toMs, out);
+    return static_cast<int>(chosen);
+}
+
+void RollupEngine::queryLevel(const std::string& sensorId, size_t level, int64_t fromMs, int64_t toMs,
+                              std::vector<Bucket>& out) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out.clear();
+    auto it = series_.find(sensorId);
+    if (it == series_.end() || level >= it->second->levels.size()) {
+        return;
+    }
+    collectLocked(*it->second, level, fromMs, toMs, out);
+}
+
+void RollupEngine::collectLocked(const Series& series, size_t level, int64_t fromMs, int64_t toMs,
+                                 std::vector<Bucket>& out) const {
+    const Level& target = series.levels[level];
+    target.collect(fromMs, toMs, out);
+
+    // 未关闭的桶：本级当前桶尚未包含更细各级的当前桶，查询时合并进来，结果不落后于最新样本；
+    // 从粗到细各级当前桶的起始时间单调不减
+    size_t closedCount = out.size();
+    for (size_t i = level + 1; i-- > 0;) {
+        const Level& source = series.levels[i];
+        if (!source.hasCurrent()) {
+            continue;
+        }
+        int64_t start = target.bucketStart(source.current().startMs);
+        if (out.size() > closedCount && out.back().startMs == start) {
+            out.back().merge(source.current());
+        } else if (start < toMs && start + target.widthMs() > fromMs) {
+            Bucket& open = out.emplace_back();
+            open.startMs = start;
+            open.merge(source.current());
+        }
+    }
+}
+
+std::vector<std::string> RollupEngine::sensors() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> ids;
+    ids.reserve(series_.size());
+    for (const auto& entry : series_) {
+        ids.push_back(entry.first);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+RollupEngine::Counters RollupEngine::counters() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return counters_;
+}
@@ -0,0 +1,486 @@
+// TimeSeriesStore.cpp
+#include "TimeSeriesStore.h"
+#include "Crc32.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <errno.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace {
+    constexpr const char* SEGMENT_EXT = ".tsc";
+    constexpr size_t MIN_SEGMENT_SIZE = 1024 * 1024;
+    constexpr size_t MIN_CHUNK_SAMPLES = 16;
+    constexpr size_t MAX_CHUNK_SAMPLES = 8192;
+
+    size_t align8(size_t value) {
+        return (value + 7) & ~size_t(7);
+    }
+}
+
+TimeSeriesStore::Segment::~Segment() {
+    if (data) {
+        munmap(data, size);
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+TimeSeriesStore::TimeSeriesStore(const Options& options)
+    : options_(options), chunkCount_(0), sealedSamples_(0), storedBytes_(0) {
+    // 块内位置为 32 位；单个块最大约 300 KB（8192 个样本且完全不可压缩时），段至少 1 MB
+    options_.segmentSize = std::clamp<size_t>(options_.segmentSize, MIN_SEGMENT_SIZE, std::numeric_limits<uint32_t>::max());
+    options_.segmentSize &= ~size_t(7);
+    options_.maxSegments = std::max<size_t>(options_.maxSegments, 1);
+    options_.chunkSamples = std::clamp(options_.chunkSamples, MIN_CHUNK_SAMPLES, MAX_CHUNK_SAMPLES);
+}
+
+TimeSeriesStore::~TimeSeriesStore() {
+    close();
+}
+
+bool TimeSeriesStore::open() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!segments_.empty()) {
+        return true;
+    }
+
+    if (mkdir(options_.directory.c_str(), 0755) < 0 && errno != EEXIST) {
+        std::cerr << "[TimeSeriesStore] Failed to create directory " << options_.directory
+                  << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 查找已有段文件
+    std::vector<uint64_t> sequences;
+    if (DIR* dir = opendir(options_.directory.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            size_t extPos = name.rfind(SEGMENT_EXT);
+            if (extPos == std::string::npos || extPos + strlen(SEGMENT_EXT) != name.size()) {
+                continue;
+            }
+            char* end = nullptr;
+            uint64_t sequence = std::strtoull(name.c_str(), &end, 10);
+            if (end == name.c_str() + extPos) {
+                sequences.push_back(sequence);
+            }
+        }
+        closedir(dir);
+    }
+    std::sort(sequences.begin(), sequences.end());
+
+    for (size_t i = 0; i < sequences.size(); ++i) {
+        auto segment = openSegment(segmentPath(sequences[i]), sequences[i]);
+        if (!segment) {
+            continue;
+        }
+        // 之前的段已完整写出，只有最后一个段可能有中断的写入
+        recoverSegment(segment, i + 1 == sequences.size());
+        segments_.push_back(segment);
+    }
+
+    if (segments_.empty()) {
+        auto segment = createSegment(0);
+        if (!segment) {
+            return false;
+        }
+        segments_.push_back(segment);
+    }
+    enforceRetention();
+
+    std::cout << "[TimeSeriesStore] Opened " << options_.directory << " with " << segments_.size()
+              << " segment(s), " << series_.size() << " sensor(s), " << chunkCount_ << " chunk(s)" << std::endl;
+    return true;
+}
+
+void TimeSeriesStore::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (segments_.empty()) {
+        return;
+    }
+    for (auto& entry : series_) {
+        seal(entry.first, entry.second);
+    }
+    const auto& active = segments_.back();
+    msync(active->data, active->size, MS_SYNC);
+    series_.clear();
+    segments_.clear();
+    chunkCount_ = sealedSamples_ = storedBytes_ = 0;
+}
+
+bool TimeSeriesStore::isOpen() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return !segments_.empty();
+}
+
+bool TimeSeriesStore::append(const std::string& sensorId, const TimeSeriesSample& sample) {
+    return append(sensorId, &sample, 1);
+}
+
+bool TimeSeriesStore::append(const std::string& sensorId, const TimeSeriesSample* samples, size_t count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (segments_.empty()) {
+        return false;
+    }
+
+    Series& series = series_[sensorId];
+    auto now = std::chrono::steady_clock::now();
+    bool ok = true;
+    for (size_t i = 0; i < count; ++i) {
+        if (series.open.count() == 0) {
+            series.openedAt = now;
+        }
+        series.open.add(samples[i]);
+        if (series.open.count() >= options_.chunkSamples) {
+            ok = seal(sensorId, series) && ok;
+        }
+    }
+    if (series.open.count() > 0 && now - series.openedAt >= options_.maxChunkAge) {
+        ok = seal(sensorId, series) && ok;
+    }
+    return ok;
+}
+
+void TimeSeriesStore::flush() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (segments_.empty()) {
+        return;
+    }
+    for (auto& entry : series_) {
+        seal(entry.first, entry.second);
+    }
+    const auto& active = segments_.back();
+    msync(active->data, active->size, MS_ASYNC);
+}
+
+bool TimeSeriesStore::seal(const std::string& sensorId, Series& series) {
+    const ChunkEncoder& chunk = series.open;
+    if (chunk.count() == 0) {
+        return true;
+    }
+
+    size_t idBytes = align8(sensorId.size());
+    size_t columnBytes = 0;
+    for (size_t c = 0; c < ChunkEncoder::COLUMN_COUNT; ++c) {
+        columnBytes += chunk.column(c).size() * sizeof(uint64_t);
+    }
+    size_t length = sizeof(ChunkHeader) + idBytes + columnBytes;
+    if (length > options_.segmentSize || sensorId.size() > std::numeric_limits<uint16_t>::max()) {
+        std::cerr << "[TimeSeriesStore] Chunk too large for segment: " << length << std::endl;
+        series.open.clear();
+        return false;
+    }
+
+    SegmentPtr active = segments_.back();
+    if (active->writePos + length > active->size) {
+        msync(active->data, active->size, MS_ASYNC);
+        active = createSegment(active->sequence + 1);
+        if (!active) {
+            series.open.clear();
+            return false;
+        }
+        segments_.push_back(active);
+        enforceRetention();
+    }
+
+    // 先写块体，最后写头：写入中断时长度或校验和对不上，恢复时丢弃该块
+    char* record = active->data + active->writePos;
+    char* body = record + sizeof(ChunkHeader);
+    std::memset(body, 0, idBytes);
+    std::memcpy(body, sensorId.data(), sensorId.size());
+    char* column = body + idBytes;
+    ChunkHeader header{};
+    for (size_t c = 0; c < ChunkEncoder::COLUMN_COUNT; ++c) {
+        const std::vector<uint64_t>& words = chunk.column(c);
+        std::memcpy(column, words.data(), words.size() * sizeof(uint64_t));
+        column += words.size() * sizeof(uint64_t);
+        header.columnWords[c] = static_cast<uint32_t>(words.size());
+    }
+    header.length = static_cast<uint32_t>(length);
+    header.checksum = crc32(0, body, length - sizeof(ChunkHeader));
+    header.count = static_cast<uint32_t>(chunk.count());
+    header.idLength = static_cast<uint16_t>(sensorId.size());
+    header.minTime = chunk.minTime();
+    header.maxTime = chunk.maxTime();
+    std::memcpy(record, &header, sizeof(header));
+
+    ChunkRef ref{active, static_cast<uint32_t>(active->writePos), header.count, header.minTime, header.maxTime, 0};
+    active->writePos += length;
+    indexChunk(sensorId, ref);
+    storedBytes_ += length;
+    series.open.clear();
+    return true;
+}
+
+void TimeSeriesStore::indexChunk(const std::string& sensorId, const ChunkRef& chunk) {
+    Series& series = series_[sensorId];
+    auto& chunks = series.chunks;
+    // 通常按时间顺序追加到末尾；乱序到达的块插入到对应位置并更新之后的前缀最大值
+    auto position = std::upper_bound(chunks.begin(), chunks.end(), chunk.minTime, [](int64_t time, const ChunkRef& ref) {
+        return time < ref.minTime;
+    });
+    size_t index = static_cast<size_t>(position - chunks.begin());
+    chunks.insert(position, chunk);
+    for (size_t i = index; i < chunks.size(); ++i) {
+        int64_t previous = i == 0 ? std::numeric_limits<int64_t>::min() : chunks[i - 1].prefixMaxTime;
+        int64_t prefix = std::max(previous, chunks[i].maxTime);
+        if (i > index && prefix == chunks[i].prefixMaxTime) {
+            break;
+        }
+        chunks[i].prefixMaxTime = prefix;
+    }
+    ++chunkCount_;
+    sealedSamples_ += chunk.count;
+}
+
+size_t TimeSeriesStore::scan(const std::string& sensorId, int64_t fromMs, int64_t toMs,
+                             std::vector<TimeSeriesSample>& out, size_t maxSamples) const {
+    std::vector<ChunkRef> chunks;
+    std::vector<uint64_t> openColumns[ChunkEncoder::COLUMN_COUNT];
+    size_t openCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = series_.find(sensorId);
+        if (it == series_.end() || fromMs >= toMs) {
+            return 0;
+        }
+        const Series& series = it->second;
+        // 第一个前缀最大时间戳不早于 fromMs 的块之前的块都不会与范围相交
+        auto first = std::partition_point(series.chunks.begin(), series.chunks.end(), [fromMs](const ChunkRef& ref) {
+            return ref.prefixMaxTime < fromMs;
+        });
+        for (auto chunk = first; chunk != series.chunks.end() && chunk->minTime < toMs; ++chunk) {
+            if (chunk->maxTime >= fromMs) {
+                chunks.push_back(*chunk);
+            }
+        }
+        if (series.open.count() > 0 && series.open.minTime() < toMs && series.open.maxTime() >= fromMs) {
+            openCount = series.open.count();
+            for (size_t c = 0; c < ChunkEncoder::COLUMN_COUNT; ++c) {
+                openColumns[c] = series.open.column(c);
+            }
+        }
+    }
+
+    size_t first = out.size();
+    for (const ChunkRef& chunk : chunks) {
+        decodeRecord(chunk.segment->data + chunk.position, fromMs, toMs, out);
+    }
+    if (openCount > 0) {
+        const uint64_t* columns[ChunkEncoder::COLUMN_COUNT];
+        size_t wordCounts[ChunkEncoder::COLUMN_COUNT];
+        for (size_t c = 0; c < ChunkEncoder::COLUMN_COUNT; ++c) {
+            columns[c] = openColumns[c].data();
+            wordCounts[c] = openColumns[c].size();
+        }
+        decode(columns, wordCounts, openCount, fromMs, toMs, out);
+    }
+
+    // 块之间或块内可能有乱序样本
+    auto byTime = [](const TimeSeriesSample& a, const TimeSeriesSample& b) {
+        return a.timestampMs < b.timestampMs;
+    };
+    if (!std::is_sorted(out.begin() + first, out.end(), byTime)) {
+        std::stable_sort(out.begin() + first, out.end(), byTime);
+    }
+    if (maxSamples > 0 && out.size() - first > maxSamples) {
+        out.resize(first + maxSamples);
+    }
+    return out.size() - first;
+}
+
+size_t TimeSeriesStore::estimate(const std::string& sensorId, int64_t fromMs, int64_t toMs) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = series_.find(sensorId);
+    if (it == series_.end() || fromMs >= toMs) {
+        return 0;
+    }
+    const Series& series = it->second;
+    size_t total = 0;
+    auto first = std::partition_point(series.chunks.begin(), series.chunks.end(), [fromMs](const ChunkRef& ref) {
+        return ref.prefixMaxTime < fromMs;
+    });
+    for (auto chunk = first; chunk != series.chunks.end() && chunk->minTime < toMs; ++chunk) {
+        if (chunk->maxTime >= fromMs) {
+            total += chunk->count;
+        }
+    }
+    if (series.open.count() > 0 && series.open.minTime() < toMs && series.open.maxTime() >= fromMs) {
+        total += series.open.count();
+    }
+    return total;
+}
+
+void TimeSeriesStore::decodeRecord(const char* record, int64_t fromMs, int64_t toMs, std::vector<TimeSeriesSample>& out) {
+    ChunkHeader header;
+    std::memcpy(&header, record, sizeof(header));
+    // 块在段内 8 字节对齐，列可以直接按 64 位字读取
+    const char* column = record + sizeof(ChunkHeader) + align8(header.idLength);
+    const uint64_t* columns[ChunkEncoder::COLUMN_COUNT];
+    size_t wordCounts[ChunkEncoder::COLUMN_COUNT];
+    for (size_t c = 0; c < ChunkEncoder::COLUMN_COUNT; ++c) {
+        columns[c] = reinterpret_cast<const uint64_t*>(column);
+        wordCounts[c] = header.columnWords[c];
+        column += header.columnWords[c] * sizeof(uint64_t);
+    }
+    decode(columns, wordCounts, header.count, fromMs, toMs, out);
+}
+
+void TimeSeriesStore::decode(const uint64_t* const* columns, const size_t* wordCounts, size_t count,
+                             int64_t fromMs, int64_t toMs, std::vector<TimeSeriesSample>& out) {
+    ChunkDecoder decoder(columns, wordCounts, count);
+    TimeSeriesSample sample;
+    while (decoder.next(sample)) {
+        if (sample.timestampMs >= fromMs && sample.timestampMs < toMs) {
+            out.push_back(sample);
+        }
+    }
+}
+
+std::vector<std::string> TimeSeriesStore::sensors() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> ids;
+    ids.reserve(series_.size());
+    for (const auto& entry : series_) {
+        ids.push_back(entry.first);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+TimeSeriesStore::Stats TimeSeriesStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats;
+    stats.sensors = series_.size();
+    stats.segments = segments_.size();
+    stats.chunks = chunkCount_;
+    stats.sealedSamples = sealedSamples_;
+    stats.samples = sealedSamples_;
+    for (const auto& entry : series_) {
+        stats.samples += entry.second.open.count();
+    }
+    stats.storedBytes = storedBytes_;
+    return stats;
+}
+
+TimeSeriesStore::SegmentPtr TimeSeriesStore::createSegment(uint64_t sequence) {
+    std::string path = segmentPath(sequence);
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "[TimeSeriesStore] Failed to create segment " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    if (ftruncate(fd, options_.segmentSize) < 0) {
+        std::cerr << "[TimeSeriesStore] Failed to size segment " << path << ": " << strerror(errno) << std::endl;
+        ::close(fd);
+        return nullptr;
+    }
+    ::close(fd);
+    return openSegment(path, sequence);
+}
+
+TimeSeriesStore::SegmentPtr TimeSeriesStore::openSegment(const std::string& path, uint64_t sequence) {
+    auto segment = std::make_shared<Segment>();
+    segment->path = path;
+    segment->sequence = sequence;
+
+    segment->fd = ::open(path.c_str(), O_RDWR);
+    if (segment->fd < 0) {
+        std::cerr << "[TimeSeriesStore] Failed to open segment " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(segment->fd, &st) < 0 || st.st_size < static_cast<off_t>(sizeof(ChunkHeader))) {
+        std::cerr << "[TimeSeriesStore] Invalid segment " << path << std::endl;
+        return nullptr;
+    }
+    segment->size = static_cast<size_t>(st.st_size) & ~size_t(7);
+
+    void* mapped = mmap(nullptr, segment->size, PROT_READ | PROT_WRITE, MAP_SHARED, segment->fd, 0);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "[TimeSeriesStore] Failed to map segment " << path << ": " << strerror(errno) << std::endl;
+        return nullptr;
+    }
+    segment->data = static_cast<char*>(mapped);
+    return segment;
+}
+
+void TimeSeriesStore::recoverSegment(const SegmentPtr& segment, bool verify) {
+    // 顺序扫描块头，遇到空块、越界、列长度不符或（verify 时）校验失败即停止
+    size_t pos = 0;
+    while (pos + sizeof(ChunkHeader) <= segment->size) {
+        ChunkHeader header;
+        std::memcpy(&header, segment->data + pos, sizeof(header));
+        size_t columnBytes = 0;
+        for (uint32_t words : header.columnWords) {
+            columnBytes += static_cast<size_t>(words) * sizeof(uint64_t);
+        }
+        if (header.length == 0 || header.length % 8 != 0 || header.count == 0 ||
+            pos + header.length > segment->size ||
+            header.length != sizeof(ChunkHeader) + align8(header.idLength) + columnBytes ||
+            (verify && crc32(0, segment->data + pos + sizeof(ChunkHeader), header.length - sizeof(ChunkHeader)) != header.checksum)) {
+            break;
+        }
+
+        std::string sensorId(segment->data + pos + sizeof(ChunkHeader), header.idLength);
+        indexChunk(sensorId, ChunkRef{segment, static_cast<uint32_t>(pos), header.count, header.minTime, header.maxTime, 0});
+        storedBytes_ += header.length;
+        pos += header.length;
+    }
+
+    segment->writePos = pos;
+    // 清掉中断写入留下的残块头，避免之后被误读
+    if (pos + sizeof(ChunkHeader) <= segment->size) {
+        std::memset(segment->data + pos, 0, sizeof(ChunkHeader));
+    }
+}
+
+void TimeSeriesStore::enforceRetention() {
+    while (segments_.size() > options_.maxSegments) {
+        SegmentPtr oldest = segments_.front();
+        segments_.erase(segments_.begin());
+        unlink(oldest->path.c_str());
+
+        // 从索引中移除引用该段的块；正在进行的查询仍持有段，结束后才解除映射
+        for (auto it = series_.begin(); it != series_.end();) {
+            auto& chunks = it->second.chunks;
+            size_t before = chunks.size();
+            for (const ChunkRef& chunk : chunks) {
+                if (chunk.segment == oldest) {
+                    sealedSamples_ -= chunk.count;
+                }
+            }
+            chunks.erase(std::remove_if(chunks.begin(), chunks.end(), [&oldest](const ChunkRef& chunk) {
+                return chunk.segment == oldest;
+            }), chunks.end());
+            chunkCount_ -= before - chunks.size();
+            int64_t prefix = std::numeric_limits<int64_t>::min();
+            for (ChunkRef& chunk : chunks) {
+                prefix = std::max(prefix, chunk.maxTime);
+                chunk.prefixMaxTime = prefix;
+            }
+            if (chunks.empty() && it->second.open.count() == 0) {
+                it = series_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        storedBytes_ -= std::min<uint64_t>(storedBytes_, oldest->writePos);
+    }
+}
+
+std::string TimeSeriesStore::segmentPath(uint64_t sequence) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%020llu", static_cast<unsigned long long>(sequence));
+    return options_.directory + "/" + name + SEGMENT_EXT;
+}